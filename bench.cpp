@@ -0,0 +1,160 @@
+#include <benchmark/benchmark.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "bigint.hpp"
+
+// Throughput of the basic operations from one limb up to 10^7 decimal digits.
+// Results are printed as JSON unless another --benchmark_format is given, so
+// runs can be compared across releases and hosts; bigint_tune finds the
+// algorithm thresholds themselves.
+//
+// usage: bigint_bench [google benchmark flags]
+
+namespace {
+// operand sizes in decimal digits, the first fitting in one limb
+void digit_sizes(benchmark::internal::Benchmark *b) {
+  b->Arg(9);
+  for (std::int64_t d = 100; d <= 10'000'000; d *= 10) {
+    b->Arg(d);
+  }
+  b->Unit(benchmark::kMicrosecond);
+}
+
+// a random positive decimal string of n digits
+std::string random_digits(std::size_t n, std::uint64_t seed) {
+  std::mt19937_64 rng(seed);
+  std::uniform_int_distribution<int> dist(0, 9);
+  std::string s(n, '0');
+  for (char &ch : s) {
+    ch = static_cast<char>('0' + dist(rng));
+  }
+  s[0] = '1';
+  return s;
+}
+
+bigint random_bigint(std::size_t n, std::uint64_t seed) {
+  return bigint(random_digits(n, seed));
+}
+
+std::size_t digits(const benchmark::State &state) {
+  return static_cast<std::size_t>(state.range(0));
+}
+
+void report(benchmark::State &state, const bigint &a) {
+  state.counters["limbs"] =
+      static_cast<double>((a.bit_length() + 31) / 32);
+  state.counters["digits_per_second"] = benchmark::Counter(
+      static_cast<double>(state.range(0)),
+      benchmark::Counter::kIsIterationInvariantRate);
+}
+
+void BM_from_string(benchmark::State &state) {
+  const std::string s = random_digits(digits(state), 1);
+  for (auto _ : state) {
+    bigint a(s);
+    benchmark::DoNotOptimize(a);
+  }
+  report(state, bigint(s));
+}
+BENCHMARK(BM_from_string)->Apply(digit_sizes);
+
+void BM_from_int64(benchmark::State &state) {
+  std::int64_t v = -1234567890123456789;
+  for (auto _ : state) {
+    bigint a(v);
+    benchmark::DoNotOptimize(a);
+    v++;
+  }
+}
+BENCHMARK(BM_from_int64);
+
+void BM_add(benchmark::State &state) {
+  const bigint a = random_bigint(digits(state), 1);
+  const bigint b = random_bigint(digits(state), 2);
+  for (auto _ : state) {
+    bigint c = a + b;
+    benchmark::DoNotOptimize(c);
+  }
+  report(state, a);
+}
+BENCHMARK(BM_add)->Apply(digit_sizes);
+
+void BM_sub(benchmark::State &state) {
+  const bigint a = random_bigint(digits(state), 1);
+  const bigint b = random_bigint(digits(state), 2);
+  for (auto _ : state) {
+    bigint c = a - b;
+    benchmark::DoNotOptimize(c);
+  }
+  report(state, a);
+}
+BENCHMARK(BM_sub)->Apply(digit_sizes);
+
+void BM_mul(benchmark::State &state) {
+  const bigint a = random_bigint(digits(state), 1);
+  const bigint b = random_bigint(digits(state), 2);
+  for (auto _ : state) {
+    bigint c = a * b;
+    benchmark::DoNotOptimize(c);
+  }
+  report(state, a);
+}
+BENCHMARK(BM_mul)->Apply(digit_sizes);
+
+void BM_square(benchmark::State &state) {
+  const bigint a = random_bigint(digits(state), 1);
+  for (auto _ : state) {
+    bigint c = a * a;
+    benchmark::DoNotOptimize(c);
+  }
+  report(state, a);
+}
+BENCHMARK(BM_square)->Apply(digit_sizes);
+
+// equal up to the last limb, the worst case for a comparison
+void BM_compare(benchmark::State &state) {
+  const bigint a = random_bigint(digits(state), 1);
+  const bigint b = a + bigint(1);
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(a < b);
+  }
+  report(state, a);
+}
+BENCHMARK(BM_compare)->Apply(digit_sizes);
+
+void BM_to_stream(benchmark::State &state) {
+  const bigint a = random_bigint(digits(state), 1);
+  for (auto _ : state) {
+    std::ostringstream os;
+    os << a;
+    benchmark::DoNotOptimize(os);
+  }
+  report(state, a);
+}
+BENCHMARK(BM_to_stream)->Apply(digit_sizes);
+} // namespace
+
+int main(int argc, char **argv) {
+  // JSON by default; a --benchmark_format given later on the command line
+  // takes precedence
+  std::vector<char *> args{argv[0]};
+  std::string json = "--benchmark_format=json";
+  args.push_back(json.data());
+  for (int i = 1; i < argc; i++) {
+    args.push_back(argv[i]);
+  }
+  int n = static_cast<int>(args.size());
+  benchmark::Initialize(&n, args.data());
+  if (benchmark::ReportUnrecognizedArguments(n, args.data())) {
+    return 1;
+  }
+  benchmark::RunSpecifiedBenchmarks();
+  benchmark::Shutdown();
+  return 0;
+}
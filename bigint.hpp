@@ -1,611 +1,8622 @@
 #pragma once
 
-#include <cctype>
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
 #include <charconv>
+#include <condition_variable>
 #include <cmath>
+#include <compare>
+#include <concepts>
+#include <coroutine>
 #include <cstddef>
 #include <cstdint>
 #include <cstdlib>
-#include <iomanip>
+#include <cstring>
+#include <deque>
+#include <execution>
+#include <functional>
+#include <initializer_list>
+#include <memory>
+#include <memory_resource>
+#include <mutex>
+#include <numeric>
+#include <limits>
 #include <ostream>
 #include <ranges>
+#include <span>
 #include <sstream>
 #include <stdexcept>
 #include <string>
 #include <string_view>
+#include <thread>
+#include <tuple>
+#include <utility>
 #include <vector>
 
+#if (defined(__x86_64__) || defined(__i386__)) &&                            \
+    (defined(__GNUC__) || defined(__clang__)) && !defined(BIGINT_NO_SIMD)
+#include <immintrin.h>
+#endif
+
 #ifdef DOCTEST
 #include "doctest.h"
 #endif
 
-class bigint {
-  using WORD = std::int32_t;
+// Low-level kernels operating on little-endian arrays of limbs. Every kernel
+// takes raw pointers and explicit lengths so that the bigint class (and the
+// faster algorithms built on top of it) can share them without temporaries.
+namespace bigint_detail {
+using limb = std::uint32_t;
+using dlimb = std::uint64_t;
+inline constexpr unsigned LIMB_BITS = std::numeric_limits<limb>::digits;
+
+// r[0..n) = a[0..n) + b[0..n) + carry, returns the carry out
+inline limb add_nc(limb *r, const limb *a, const limb *b, std::size_t n,
+                   limb carry) noexcept {
+  for (std::size_t i = 0; i < n; i++) {
+    const dlimb s = dlimb{a[i]} + b[i] + carry;
+    r[i] = static_cast<limb>(s);
+    carry = static_cast<limb>(s >> LIMB_BITS);
+  }
+  return carry;
+}
+
+// r[0..n) = a[0..n) - b[0..n) - borrow, returns the borrow out
+inline limb sub_nc(limb *r, const limb *a, const limb *b, std::size_t n,
+                   limb borrow) noexcept {
+  for (std::size_t i = 0; i < n; i++) {
+    const dlimb d = dlimb{a[i]} - b[i] - borrow;
+    r[i] = static_cast<limb>(d);
+    borrow = static_cast<limb>(d >> (2 * LIMB_BITS - 1));
+  }
+  return borrow;
+}
+
+// Vector kernels for x86, selected at runtime from the CPU features. A block
+// of lanes is added (or subtracted) without carries, then the carries are
+// resolved across the block with carry-lookahead on bit masks: lane i
+// generates a carry when its sum wrapped around and propagates one when its
+// sum is all ones. With G and P the generate and propagate masks and c the
+// carry into the block, ((G << 1 | c) + P) ^ P has a bit set for every lane
+// that receives a carry, and the bit above the block is the carry out.
+// Subtraction works the same way with borrows, where a difference of zero
+// propagates. Define BIGINT_NO_SIMD to build only the portable kernels.
+enum class simd_level { none, avx2, avx512 };
+
+#if (defined(__x86_64__) || defined(__i386__)) &&                            \
+    (defined(__GNUC__) || defined(__clang__)) && !defined(BIGINT_NO_SIMD)
+#define BIGINT_X86_SIMD 1
+
+inline simd_level detect_simd() noexcept {
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx512f"))
+    return simd_level::avx512;
+  if (__builtin_cpu_supports("avx2"))
+    return simd_level::avx2;
+  return simd_level::none;
+}
+
+// the best level this CPU supports
+inline const simd_level simd_supported = detect_simd();
+#else
+inline constexpr simd_level simd_supported = simd_level::none;
+#endif
+
+// The kernels used by add_n, sub_n and cmp_n. It can be lowered, for example
+// to compare results, but never above simd_supported. Until it is initialized
+// during static initialization it reads as simd_level::none.
+inline simd_level simd_dispatch = simd_supported;
+
+// below this many limbs the portable kernels are faster
+inline constexpr std::size_t SIMD_MIN_LIMBS = 16;
+
+#ifdef BIGINT_X86_SIMD
+// lanes of 1 << i, to expand an 8-bit lane mask into a vector
+__attribute__((target("avx2"))) inline __m256i avx2_expand(unsigned m) noexcept {
+  const __m256i bits = _mm256_setr_epi32(1, 2, 4, 8, 16, 32, 64, 128);
+  const __m256i v = _mm256_set1_epi32(static_cast<int>(m));
+  return _mm256_cmpeq_epi32(_mm256_and_si256(v, bits), bits);
+}
+
+__attribute__((target("avx2"))) inline limb
+add_n_avx2(limb *r, const limb *a, const limb *b, std::size_t n) noexcept {
+  // unsigned comparison through a signed one on biased values
+  const __m256i bias = _mm256_set1_epi32(std::numeric_limits<int>::min());
+  const __m256i ones = _mm256_set1_epi32(-1);
+  unsigned carry = 0;
+  std::size_t i = 0;
+  for (; i + 8 <= n; i += 8) {
+    const __m256i va = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(a + i));
+    const __m256i vb = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(b + i));
+    const __m256i s = _mm256_add_epi32(va, vb);
+    const __m256i g = _mm256_cmpgt_epi32(_mm256_xor_si256(va, bias),
+                                         _mm256_xor_si256(s, bias));
+    const __m256i p = _mm256_cmpeq_epi32(s, ones);
+    const auto gm = static_cast<unsigned>(_mm256_movemask_ps(_mm256_castsi256_ps(g)));
+    const auto pm = static_cast<unsigned>(_mm256_movemask_ps(_mm256_castsi256_ps(p)));
+    const unsigned t = ((gm << 1) | carry) + pm;
+    carry = t >> 8;
+    // lanes receiving a carry hold -1, so subtracting adds it
+    const __m256i c = avx2_expand((t ^ pm) & 0xff);
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(r + i), _mm256_sub_epi32(s, c));
+  }
+  return add_nc(r + i, a + i, b + i, n - i, carry);
+}
+
+__attribute__((target("avx2"))) inline limb
+sub_n_avx2(limb *r, const limb *a, const limb *b, std::size_t n) noexcept {
+  const __m256i bias = _mm256_set1_epi32(std::numeric_limits<int>::min());
+  const __m256i zero = _mm256_setzero_si256();
+  unsigned borrow = 0;
+  std::size_t i = 0;
+  for (; i + 8 <= n; i += 8) {
+    const __m256i va = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(a + i));
+    const __m256i vb = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(b + i));
+    const __m256i d = _mm256_sub_epi32(va, vb);
+    const __m256i g = _mm256_cmpgt_epi32(_mm256_xor_si256(vb, bias),
+                                         _mm256_xor_si256(va, bias));
+    const __m256i p = _mm256_cmpeq_epi32(d, zero);
+    const auto gm = static_cast<unsigned>(_mm256_movemask_ps(_mm256_castsi256_ps(g)));
+    const auto pm = static_cast<unsigned>(_mm256_movemask_ps(_mm256_castsi256_ps(p)));
+    const unsigned t = ((gm << 1) | borrow) + pm;
+    borrow = t >> 8;
+    // lanes owing a borrow hold -1, so adding subtracts it
+    const __m256i c = avx2_expand((t ^ pm) & 0xff);
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(r + i), _mm256_add_epi32(d, c));
+  }
+  return sub_nc(r + i, a + i, b + i, n - i, borrow);
+}
+
+__attribute__((target("avx512f"))) inline limb
+add_n_avx512(limb *r, const limb *a, const limb *b, std::size_t n) noexcept {
+  const __m512i ones = _mm512_set1_epi32(-1);
+  unsigned carry = 0;
+  std::size_t i = 0;
+  for (; i + 16 <= n; i += 16) {
+    const __m512i va = _mm512_loadu_si512(a + i);
+    const __m512i vb = _mm512_loadu_si512(b + i);
+    const __m512i s = _mm512_add_epi32(va, vb);
+    const unsigned gm = _mm512_cmplt_epu32_mask(s, va);
+    const unsigned pm = _mm512_cmpeq_epu32_mask(s, ones);
+    const unsigned t = ((gm << 1) | carry) + pm;
+    carry = t >> 16;
+    const auto c = static_cast<__mmask16>(t ^ pm);
+    _mm512_storeu_si512(r + i, _mm512_mask_sub_epi32(s, c, s, ones));
+  }
+  return add_nc(r + i, a + i, b + i, n - i, carry);
+}
+
+__attribute__((target("avx512f"))) inline limb
+sub_n_avx512(limb *r, const limb *a, const limb *b, std::size_t n) noexcept {
+  const __m512i ones = _mm512_set1_epi32(-1);
+  const __m512i zero = _mm512_setzero_si512();
+  unsigned borrow = 0;
+  std::size_t i = 0;
+  for (; i + 16 <= n; i += 16) {
+    const __m512i va = _mm512_loadu_si512(a + i);
+    const __m512i vb = _mm512_loadu_si512(b + i);
+    const __m512i d = _mm512_sub_epi32(va, vb);
+    const unsigned gm = _mm512_cmplt_epu32_mask(va, vb);
+    const unsigned pm = _mm512_cmpeq_epu32_mask(d, zero);
+    const unsigned t = ((gm << 1) | borrow) + pm;
+    borrow = t >> 16;
+    const auto c = static_cast<__mmask16>(t ^ pm);
+    _mm512_storeu_si512(r + i, _mm512_mask_add_epi32(d, c, d, ones));
+  }
+  return sub_nc(r + i, a + i, b + i, n - i, borrow);
+}
+
+// returns m with a[m..n) == b[m..n), scanning 8 limbs at a time from the top,
+// so that either a[m - 1] != b[m - 1] or m < 8
+__attribute__((target("avx2"))) inline std::size_t
+skip_equal_avx2(const limb *a, const limb *b, std::size_t n) noexcept {
+  std::size_t i = n;
+  while (i >= 8) {
+    const __m256i va = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(a + i - 8));
+    const __m256i vb = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(b + i - 8));
+    const auto eq = static_cast<unsigned>(
+        _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(va, vb))));
+    if (eq != 0xff)
+      return i - static_cast<std::size_t>(std::countl_zero(~eq << 24));
+    i -= 8;
+  }
+  return i;
+}
+#endif
+
+// r[0..n) = a[0..n) + b[0..n), returns the carry out
+inline limb add_n(limb *r, const limb *a, const limb *b,
+                  std::size_t n) noexcept {
+#ifdef BIGINT_X86_SIMD
+  if (n >= SIMD_MIN_LIMBS) {
+    if (simd_dispatch == simd_level::avx512)
+      return add_n_avx512(r, a, b, n);
+    if (simd_dispatch == simd_level::avx2)
+      return add_n_avx2(r, a, b, n);
+  }
+#endif
+  return add_nc(r, a, b, n, 0);
+}
+
+// r[0..n) = a[0..n) + b, returns the carry out
+inline limb add_1(limb *r, const limb *a, std::size_t n, limb b) noexcept {
+  limb carry = b;
+  std::size_t i = 0;
+  for (; i < n && carry; i++) {
+    const dlimb s = dlimb{a[i]} + carry;
+    r[i] = static_cast<limb>(s);
+    carry = static_cast<limb>(s >> LIMB_BITS);
+  }
+  if (r != a) {
+    for (; i < n; i++)
+      r[i] = a[i];
+  }
+  return carry;
+}
+
+// r[0..n) = a[0..n) - b[0..n), returns the borrow out
+inline limb sub_n(limb *r, const limb *a, const limb *b,
+                  std::size_t n) noexcept {
+#ifdef BIGINT_X86_SIMD
+  if (n >= SIMD_MIN_LIMBS) {
+    if (simd_dispatch == simd_level::avx512)
+      return sub_n_avx512(r, a, b, n);
+    if (simd_dispatch == simd_level::avx2)
+      return sub_n_avx2(r, a, b, n);
+  }
+#endif
+  return sub_nc(r, a, b, n, 0);
+}
+
+// r[0..n) = a[0..n) - b, returns the borrow out
+inline limb sub_1(limb *r, const limb *a, std::size_t n, limb b) noexcept {
+  limb borrow = b;
+  std::size_t i = 0;
+  for (; i < n && borrow; i++) {
+    const dlimb d = dlimb{a[i]} - borrow;
+    r[i] = static_cast<limb>(d);
+    borrow = static_cast<limb>(d >> (2 * LIMB_BITS - 1));
+  }
+  if (r != a) {
+    for (; i < n; i++)
+      r[i] = a[i];
+  }
+  return borrow;
+}
+
+// r[0..n) = a[0..n) * b, returns the high limb
+inline limb mul_1(limb *r, const limb *a, std::size_t n, limb b) noexcept {
+  limb carry = 0;
+  for (std::size_t i = 0; i < n; i++) {
+    const dlimb p = dlimb{a[i]} * b + carry;
+    r[i] = static_cast<limb>(p);
+    carry = static_cast<limb>(p >> LIMB_BITS);
+  }
+  return carry;
+}
+
+// r[0..n) += a[0..n) * b, returns the high limb
+inline limb addmul_1(limb *r, const limb *a, std::size_t n, limb b) noexcept {
+  limb carry = 0;
+  for (std::size_t i = 0; i < n; i++) {
+    const dlimb p = dlimb{a[i]} * b + r[i] + carry;
+    r[i] = static_cast<limb>(p);
+    carry = static_cast<limb>(p >> LIMB_BITS);
+  }
+  return carry;
+}
+
+// Scratch space for the internals of multiplication and division, handed
+// out as a stack of frames: a frame remembers the top of the stack and
+// releases everything allocated through it when it is destroyed. The blocks
+// behind the stack are kept, so once a computation has run at some size,
+// repeating it takes no heap allocations. Each thread has its own workspace,
+// available through local().
+class workspace {
+public:
+  class frame {
+  public:
+    explicit frame(workspace &w) noexcept
+        : w_(w), block_(w.block_), top_(w.top_), used_(w.used_) {}
+    ~frame() {
+      w_.block_ = block_;
+      w_.top_ = top_;
+      w_.used_ = used_;
+      if (!used_)
+        w_.consolidate();
+    }
+    frame(const frame &) = delete;
+    frame &operator=(const frame &) = delete;
+
+    // n uninitialized limbs, valid until the frame is destroyed
+    [[nodiscard]] limb *alloc(std::size_t n) noexcept { return w_.alloc(n); }
+
+  private:
+    workspace &w_;
+    std::size_t block_;
+    std::size_t top_;
+    std::size_t used_;
+  };
+
+  workspace() noexcept = default;
+  workspace(const workspace &) = delete;
+  workspace &operator=(const workspace &) = delete;
+
+  // the workspace of the calling thread
+  [[nodiscard]] static workspace &local() noexcept {
+    thread_local workspace w;
+    return w;
+  }
+
+  // limbs handed out by the frames that are currently alive
+  [[nodiscard]] std::size_t in_use() const noexcept { return used_; }
+  // the most limbs in use at once since construction or reset_peak()
+  [[nodiscard]] std::size_t peak() const noexcept { return peak_; }
+  void reset_peak() noexcept { peak_ = used_; }
+  // limbs held in blocks, in use or not
+  [[nodiscard]] std::size_t capacity() const noexcept {
+    std::size_t c = 0;
+    for (const block &b : blocks_)
+      c += b.size;
+    return c;
+  }
+
+  // frees every block, which requires that no frame is alive
+  void release() noexcept {
+    blocks_.clear();
+    block_ = 0;
+    top_ = 0;
+  }
+
+private:
+  struct block {
+    std::unique_ptr<limb[]> data;
+    std::size_t size;
+  };
+  static constexpr std::size_t MIN_BLOCK = 1024;
+
+  std::vector<block> blocks_;
+  // the block being allocated from and the limbs taken from it
+  std::size_t block_ = 0;
+  std::size_t top_ = 0;
+  std::size_t used_ = 0;
+  std::size_t peak_ = 0;
+
+  limb *alloc(std::size_t n) noexcept {
+    if (block_ >= blocks_.size() || top_ + n > blocks_[block_].size) {
+      // the blocks above the current one are free
+      if (block_ < blocks_.size())
+        block_++;
+      top_ = 0;
+      if (block_ == blocks_.size()) {
+        blocks_.push_back(new_block(n));
+      } else if (blocks_[block_].size < n) {
+        blocks_[block_] = new_block(n);
+      }
+    }
+    limb *const p = blocks_[block_].data.get() + top_;
+    top_ += n;
+    used_ += n;
+    peak_ = std::max(peak_, used_);
+    return p;
+  }
+
+  [[nodiscard]] block new_block(std::size_t n) const noexcept {
+    const std::size_t size = std::max({n, MIN_BLOCK, capacity()});
+    return {std::make_unique_for_overwrite<limb[]>(size), size};
+  }
+
+  // once the stack is empty, merges the blocks into one that fits the peak,
+  // so that later computations stay within a single block
+  void consolidate() noexcept {
+    if (blocks_.size() > 1) {
+      const std::size_t size = std::max(capacity(), peak_);
+      blocks_.clear();
+      blocks_.push_back({std::make_unique_for_overwrite<limb[]>(size), size});
+    }
+    block_ = 0;
+    top_ = 0;
+  }
+};
+
+// Worker threads for fork-join parallelism. run(n, threads, fn) calls fn(i)
+// for every i in [0, n) on the calling thread and up to threads - 1 workers,
+// and returns once every call is done. Jobs may nest: the caller works
+// through its own job as well, so it can only ever wait for calls that are
+// already running. Workers are started on demand and live until exit.
+class thread_pool {
+public:
+  [[nodiscard]] static thread_pool &instance() noexcept {
+    static thread_pool pool;
+    return pool;
+  }
+
+  thread_pool() noexcept = default;
+  thread_pool(const thread_pool &) = delete;
+  thread_pool &operator=(const thread_pool &) = delete;
+
+  ~thread_pool() {
+    {
+      const std::lock_guard<std::mutex> lock(m_);
+      stop_ = true;
+    }
+    work_cv_.notify_all();
+    for (std::thread &t : workers_)
+      t.join();
+  }
+
+  template <typename F>
+  void run(std::size_t n, std::size_t threads, const F &fn) noexcept {
+    if (n <= 1 || threads <= 1) {
+      for (std::size_t i = 0; i < n; i++)
+        fn(i);
+      return;
+    }
+    job j{[](const void *f, std::size_t i) { (*static_cast<const F *>(f))(i); },
+          &fn, n, std::min(threads, n) - 1};
+    std::unique_lock<std::mutex> lock(m_);
+    while (workers_.size() < j.helpers)
+      workers_.emplace_back([this] { work(); });
+    jobs_.push_back(&j);
+    work_cv_.notify_all();
+    while (j.next < n) {
+      const std::size_t i = claim(j);
+      lock.unlock();
+      fn(i);
+      lock.lock();
+      j.done++;
+    }
+    done_cv_.wait(lock, [&j] { return j.done == j.n; });
+  }
+
+private:
+  struct job {
+    void (*call)(const void *, std::size_t);
+    const void *fn;
+    std::size_t n;
+    // the most workers that may join, besides the caller
+    std::size_t helpers;
+    std::size_t joined = 0;
+    std::size_t next = 0;
+    std::size_t done = 0;
+  };
+
+  std::mutex m_;
+  std::condition_variable work_cv_;
+  std::condition_variable done_cv_;
+  std::deque<job *> jobs_;
+  std::vector<std::thread> workers_;
+  bool stop_ = false;
+
+  // the next index of j, with m_ held, dropping j from the queue once every
+  // index is taken
+  std::size_t claim(job &j) noexcept {
+    const std::size_t i = j.next++;
+    if (j.next == j.n)
+      jobs_.erase(std::find(jobs_.begin(), jobs_.end(), &j));
+    return i;
+  }
+
+  void work() noexcept {
+    std::unique_lock<std::mutex> lock(m_);
+    for (;;) {
+      job *j = nullptr;
+      work_cv_.wait(lock, [&] {
+        if (stop_)
+          return true;
+        for (job *q : jobs_) {
+          if (q->joined < q->helpers) {
+            j = q;
+            return true;
+          }
+        }
+        return false;
+      });
+      if (stop_)
+        return;
+      // j stays alive while m_ is held and some of its calls are not done
+      j->joined++;
+      while (j->next < j->n) {
+        const std::size_t i = claim(*j);
+        lock.unlock();
+        j->call(j->fn, i);
+        lock.lock();
+        if (++j->done == j->n)
+          done_cv_.notify_all();
+      }
+    }
+  }
+};
+
+// r[0..an+bn) = a[0..an) * b[0..bn), schoolbook. r must not overlap a or b.
+inline void mul_basecase(limb *r, const limb *a, std::size_t an, const limb *b,
+                         std::size_t bn) noexcept {
+  r[an] = mul_1(r, a, an, b[0]);
+  for (std::size_t i = 1; i < bn; i++) {
+    r[i + an] = addmul_1(r + i, a, an, b[i]);
+  }
+}
+
+// Number-theoretic transform over Z/PZ for a prime P = c 2^k + 1 < 2^32 with
+// primitive root G. Transforms of length n need 2^k >= n.
+template <limb P, limb G> struct ntt_field {
+  static constexpr limb MOD = P;
+
+  static constexpr limb add(limb a, limb b) noexcept {
+    const dlimb s = dlimb{a} + b;
+    return static_cast<limb>(s >= P ? s - P : s);
+  }
+
+  static constexpr limb sub(limb a, limb b) noexcept {
+    return a >= b ? a - b : a + (P - b);
+  }
+
+  static constexpr limb mul(limb a, limb b) noexcept {
+    return static_cast<limb>(dlimb{a} * b % P);
+  }
+
+  static constexpr limb pow(limb a, dlimb e) noexcept {
+    limb r = 1;
+    for (; e; e >>= 1) {
+      if (e & 1)
+        r = mul(r, a);
+      a = mul(a, a);
+    }
+    return r;
+  }
+
+  // rt[h + j] = w^j for j in [lo, hi), where w is a primitive 2h-th root of
+  // unity (or its inverse)
+  static void root_range(limb *rt, std::size_t h, std::size_t lo,
+                         std::size_t hi, bool inverse) noexcept {
+    limb w = pow(G, (P - 1) / (2 * h));
+    if (inverse)
+      w = pow(w, P - 2);
+    rt[h + lo] = pow(w, lo);
+    for (std::size_t j = lo + 1; j < hi; j++)
+      rt[h + j] = mul(rt[h + j - 1], w);
+  }
+
+  // root_range for every power of two h < n
+  static void roots(limb *rt, std::size_t n, bool inverse) noexcept {
+    for (std::size_t h = 1; h < n; h <<= 1)
+      root_range(rt, h, 0, h, inverse);
+  }
+
+  // the butterflies j in [lo, hi) of the stage with half-length h, in every
+  // block of a[0..n)
+  static void forward_stage(limb *a, std::size_t n, const limb *rt,
+                            std::size_t h, std::size_t lo,
+                            std::size_t hi) noexcept {
+    for (std::size_t i = 0; i < n; i += 2 * h) {
+      for (std::size_t j = lo; j < hi; j++) {
+        const limb u = a[i + j];
+        const limb v = a[i + j + h];
+        a[i + j] = add(u, v);
+        a[i + j + h] = mul(sub(u, v), rt[h + j]);
+      }
+    }
+  }
+
+  static void inverse_stage(limb *a, std::size_t n, const limb *irt,
+                            std::size_t h, std::size_t lo,
+                            std::size_t hi) noexcept {
+    for (std::size_t i = 0; i < n; i += 2 * h) {
+      for (std::size_t j = lo; j < hi; j++) {
+        const limb u = a[i + j];
+        const limb v = mul(a[i + j + h], irt[h + j]);
+        a[i + j] = add(u, v);
+        a[i + j + h] = sub(u, v);
+      }
+    }
+  }
+
+  // decimation in frequency: natural order in, bit-reversed order out
+  static void forward(limb *a, std::size_t n, const limb *rt) noexcept {
+    for (std::size_t h = n / 2; h >= 1; h >>= 1)
+      forward_stage(a, n, rt, h, 0, h);
+  }
+
+  // decimation in time: bit-reversed order in, natural order out, before the
+  // scaling by 1/n
+  static void inverse_unscaled(limb *a, std::size_t n,
+                               const limb *irt) noexcept {
+    for (std::size_t h = 1; h < n; h <<= 1)
+      inverse_stage(a, n, irt, h, 0, h);
+  }
+
+  // Both transforms on up to `threads` threads. The stages close to the full
+  // length split their butterflies between the threads, and below them the
+  // blocks are independent transforms of their own.
+  static void forward(limb *a, std::size_t n, const limb *rt,
+                      std::size_t threads) noexcept {
+    thread_pool &pool = thread_pool::instance();
+    std::size_t len = n;
+    for (; len > 1 && n / len < threads; len >>= 1) {
+      const std::size_t h = len / 2;
+      pool.run(threads, threads, [=](std::size_t t) {
+        forward_stage(a, n, rt, h, h * t / threads, h * (t + 1) / threads);
+      });
+    }
+    pool.run(n / len, threads,
+             [=](std::size_t i) { forward(a + i * len, len, rt); });
+  }
+
+  static void inverse_unscaled(limb *a, std::size_t n, const limb *irt,
+                               std::size_t threads) noexcept {
+    thread_pool &pool = thread_pool::instance();
+    std::size_t len = n;
+    while (len > 1 && n / len < threads)
+      len >>= 1;
+    pool.run(n / len, threads,
+             [=](std::size_t i) { inverse_unscaled(a + i * len, len, irt); });
+    for (std::size_t h = len; h < n; h <<= 1) {
+      pool.run(threads, threads, [=](std::size_t t) {
+        inverse_stage(a, n, irt, h, h * t / threads, h * (t + 1) / threads);
+      });
+    }
+  }
+
+  // inverse(forward(a)) == a
+  static void inverse(limb *a, std::size_t n, const limb *irt,
+                      std::size_t threads = 1) noexcept {
+    if (threads > 1)
+      inverse_unscaled(a, n, irt, threads);
+    else
+      inverse_unscaled(a, n, irt);
+    const limb n_inv = pow(static_cast<limb>(n % P), P - 2);
+    for (std::size_t i = 0; i < n; i++)
+      a[i] = mul(a[i], n_inv);
+  }
+
+  // c[0..n) = cyclic convolution of a[0..an) and b[0..bn) mod P, where b ==
+  // nullptr squares a, with the transforms on up to `threads` threads
+  static void convolve(limb *c, std::size_t n, const limb *a, std::size_t an,
+                       const limb *b, std::size_t bn, std::size_t threads) {
+    const auto transform = [n, threads](limb *x, const limb *rt) {
+      if (threads > 1)
+        forward(x, n, rt, threads);
+      else
+        forward(x, n, rt);
+    };
+    workspace::frame f(workspace::local());
+    limb *const rt = f.alloc(n);
+    roots(rt, n, false);
+    for (std::size_t i = 0; i < n; i++)
+      c[i] = i < an ? a[i] % P : 0;
+    transform(c, rt);
+    if (b) {
+      limb *const fb = f.alloc(n);
+      for (std::size_t i = 0; i < n; i++)
+        fb[i] = i < bn ? b[i] % P : 0;
+      transform(fb, rt);
+      for (std::size_t i = 0; i < n; i++)
+        c[i] = mul(c[i], fb[i]);
+    } else {
+      for (std::size_t i = 0; i < n; i++)
+        c[i] = mul(c[i], c[i]);
+    }
+    roots(rt, n, true);
+    inverse(c, n, rt, threads);
+  }
+};
+
+// The three NTT primes. Their product exceeds 2^94, which bounds every
+// convolution coefficient n (2^32 - 1)^2 for n <= NTT_MAX_LEN.
+using ntt_p0 = ntt_field<3221225473, 5>; // 3 * 2^30 + 1
+using ntt_p1 = ntt_field<3489660929, 3>; // 13 * 2^28 + 1
+using ntt_p2 = ntt_field<3892314113, 3>; // 29 * 2^27 + 1
+inline constexpr std::size_t NTT_MAX_LEN = std::size_t{1} << 27;
+
+// Garner: x = r0 + P0 t1 + P0 P1 t2, accumulated into r[lo..hi) in base 2^32
+// from the residues c0, c1, c2 of an n-point convolution, with the running
+// carry held as carry_lo + carry_hi 2^32 between calls
+inline void ntt_garner(limb *r, std::size_t lo, std::size_t hi, std::size_t n,
+                       const limb *c0, const limb *c1, const limb *c2,
+                       dlimb &carry_lo, dlimb &carry_hi) noexcept {
+  constexpr dlimb P0 = 3221225473;
+  constexpr dlimb P1 = 3489660929;
+  constexpr dlimb P2 = 3892314113;
+  constexpr limb P0_INV = ntt_p1::pow(static_cast<limb>(P0), P1 - 2);
+  constexpr dlimb P01 = P0 * P1;
+  constexpr limb P01_INV = ntt_p2::pow(static_cast<limb>(P01 % P2), P2 - 2);
+  for (std::size_t i = lo; i < hi; i++) {
+    dlimb v0 = carry_lo;
+    dlimb v1 = carry_hi;
+    dlimb v2 = 0;
+    if (i < n) {
+      const limb t1 = ntt_p1::mul(ntt_p1::sub(c1[i], c0[i]), P0_INV);
+      const dlimb x = c0[i] + P0 * t1;
+      const limb t2 = ntt_p2::mul(
+          ntt_p2::sub(c2[i], static_cast<limb>(x % P2)), P01_INV);
+      const dlimb lo_t = (P01 & 0xffffffff) * t2;
+      const dlimb hi_t = (P01 >> LIMB_BITS) * t2;
+      v0 += (x & 0xffffffff) + (lo_t & 0xffffffff);
+      v1 += (x >> LIMB_BITS) + (lo_t >> LIMB_BITS) + (hi_t & 0xffffffff);
+      v2 += hi_t >> LIMB_BITS;
+    }
+    r[i] = static_cast<limb>(v0);
+    carry_lo = (v0 >> LIMB_BITS) + v1;
+    carry_hi = v2 + (carry_lo >> LIMB_BITS);
+    carry_lo &= 0xffffffff;
+  }
+}
+
+// r[0..an+bn) = a[0..an) * b[0..bn) through three NTTs and CRT
+// reconstruction, requires an + bn <= NTT_MAX_LEN. Passing b == a with
+// bn == an takes the squaring path with one forward transform per prime.
+// With threads > 1 the three primes are handled in parallel, each with a
+// share of the threads for its transforms.
+inline void mul_ntt(limb *r, const limb *a, std::size_t an, const limb *b,
+                    std::size_t bn, std::size_t threads = 1) {
+  const std::size_t rn = an + bn;
+  const std::size_t n = std::bit_ceil(rn - 1);
+  const limb *const sb = (a == b && an == bn) ? nullptr : b;
+  workspace::frame f(workspace::local());
+  limb *const c0 = f.alloc(n);
+  limb *const c1 = f.alloc(n);
+  limb *const c2 = f.alloc(n);
+  const std::size_t share = std::max<std::size_t>(threads / 3, 1);
+  thread_pool::instance().run(3, threads, [&](std::size_t p) {
+    if (p == 0)
+      ntt_p0::convolve(c0, n, a, an, sb, bn, share);
+    else if (p == 1)
+      ntt_p1::convolve(c1, n, a, an, sb, bn, share);
+    else
+      ntt_p2::convolve(c2, n, a, an, sb, bn, share);
+  });
+
+  dlimb carry_lo = 0;
+  dlimb carry_hi = 0;
+  ntt_garner(r, 0, rn, n, c0, c1, c2, carry_lo, carry_hi);
+}
+
+// r[0..n) -= a[0..n) * b, returns the borrow out of the top limb
+inline limb submul_1(limb *r, const limb *a, std::size_t n, limb b) noexcept {
+  limb borrow = 0;
+  for (std::size_t i = 0; i < n; i++) {
+    const dlimb p = dlimb{a[i]} * b + borrow;
+    const limb lo = static_cast<limb>(p);
+    borrow = static_cast<limb>(p >> LIMB_BITS) + (r[i] < lo);
+    r[i] -= lo;
+  }
+  return borrow;
+}
+
+// r[0..n) = a[0..n) << cnt for 0 < cnt < LIMB_BITS, returns the bits shifted
+// out. It runs from the top down, so r may alias a or start above it.
+inline limb lshift(limb *r, const limb *a, std::size_t n, unsigned cnt) noexcept {
+  if (n == 0)
+    return 0;
+  const limb out = a[n - 1] >> (LIMB_BITS - cnt);
+  for (std::size_t i = n - 1; i > 0; i--)
+    r[i] = static_cast<limb>(a[i] << cnt) | (a[i - 1] >> (LIMB_BITS - cnt));
+  r[0] = static_cast<limb>(a[0] << cnt);
+  return out;
+}
+
+// r[0..n) = a[0..n) >> cnt for 0 < cnt < LIMB_BITS, returns the bits shifted
+// out in the high end of a limb. It runs from the bottom up, so r may alias a
+// or start below it.
+inline limb rshift(limb *r, const limb *a, std::size_t n, unsigned cnt) noexcept {
+  if (n == 0)
+    return 0;
+  const limb out = static_cast<limb>(a[0] << (LIMB_BITS - cnt));
+  for (std::size_t i = 0; i + 1 < n; i++)
+    r[i] = (a[i] >> cnt) | static_cast<limb>(a[i + 1] << (LIMB_BITS - cnt));
+  r[n - 1] = a[n - 1] >> cnt;
+  return out;
+}
+
+// q[0..n) = a[0..n) / d, returns a[0..n) % d. q may alias a.
+inline limb divrem_1(limb *q, const limb *a, std::size_t n, limb d) noexcept {
+  dlimb rem = 0;
+  for (std::size_t i = n; i-- > 0;) {
+    const dlimb cur = (rem << LIMB_BITS) | a[i];
+    q[i] = static_cast<limb>(cur / d);
+    rem = cur % d;
+  }
+  return static_cast<limb>(rem);
+}
+
+// Knuth's algorithm D: q[0..an-bn+1) = a / b and r[0..bn) = a % b, requires
+// an >= bn >= 2 and b[bn-1] != 0
+inline void divrem_knuth(limb *q, limb *r, const limb *a, std::size_t an,
+                         const limb *b, std::size_t bn) {
+  constexpr dlimb B = dlimb{1} << LIMB_BITS;
+  // normalize so that the top bit of the divisor is set
+  const auto s = static_cast<unsigned>(std::countl_zero(b[bn - 1]));
+  workspace::frame f(workspace::local());
+  limb *const un = f.alloc(an + 1);
+  limb *const vn = f.alloc(bn);
+  if (s) {
+    lshift(vn, b, bn, s);
+    un[an] = lshift(un, a, an, s);
+  } else {
+    std::copy(b, b + bn, vn);
+    std::copy(a, a + an, un);
+    un[an] = 0;
+  }
+  const dlimb v1 = vn[bn - 1];
+  const dlimb v2 = vn[bn - 2];
+  for (std::size_t j = an - bn + 1; j-- > 0;) {
+    const dlimb num = (dlimb{un[j + bn]} << LIMB_BITS) | un[j + bn - 1];
+    dlimb qhat = num / v1;
+    dlimb rhat = num % v1;
+    while (qhat >= B || qhat * v2 > ((rhat << LIMB_BITS) | un[j + bn - 2])) {
+      qhat--;
+      rhat += v1;
+      if (rhat >= B)
+        break;
+    }
+    const limb borrow = submul_1(un + j, vn, bn, static_cast<limb>(qhat));
+    if (un[j + bn] < borrow) {
+      // qhat was one too large, add the divisor back
+      qhat--;
+      un[j + bn] += add_n(un + j, un + j, vn, bn);
+    }
+    un[j + bn] -= borrow;
+    q[j] = static_cast<limb>(qhat);
+  }
+  if (s) {
+    rshift(r, un, bn, s);
+  } else {
+    std::copy(un, un + bn, r);
+  }
+}
+
+inline constexpr char DIGITS[] = "0123456789abcdefghijklmnopqrstuvwxyz";
+
+// three-way comparison of a[0..n) and b[0..n): -1, 0 or 1
+inline int cmp_n(const limb *a, const limb *b, std::size_t n) noexcept {
+#ifdef BIGINT_X86_SIMD
+  // both AVX levels use the AVX2 scan, which is bound by memory anyway
+  if (n >= SIMD_MIN_LIMBS && simd_dispatch != simd_level::none)
+    n = skip_equal_avx2(a, b, n);
+#endif
+  for (std::size_t i = n; i-- > 0;) {
+    if (a[i] != b[i])
+      return a[i] < b[i] ? -1 : 1;
+  }
+  return 0;
+}
+
+// -m0^-1 mod 2^LIMB_BITS for odd m0, by Newton iteration: m0 is its own
+// inverse mod 8 and every step doubles the number of correct bits
+constexpr limb mont_inverse(limb m0) noexcept {
+  limb x = m0;
+  for (int i = 0; i < 4; i++)
+    x *= 2 - m0 * x;
+  return 0 - x;
+}
+
+// q[0..n) = a[0..n) / d mod 2^(LIMB_BITS n) for odd d, which is the exact
+// quotient whenever the two's complement value a[0..n) is divisible by d. q
+// may alias a.
+inline void divexact_1(limb *q, const limb *a, std::size_t n, limb d) noexcept {
+  const limb inv = 0 - mont_inverse(d);
+  limb c = 0;
+  for (std::size_t i = 0; i < n; i++) {
+    const limb l = a[i] - c;
+    c = l > a[i];
+    q[i] = l * inv;
+    c += static_cast<limb>((dlimb{q[i]} * d) >> LIMB_BITS);
+  }
+}
+
+// a[0..n) >>= 1 for a two's complement value, rounding toward minus infinity
+inline void sar_1(limb *a, std::size_t n) noexcept {
+  const limb top = a[n - 1] & (limb{1} << (LIMB_BITS - 1));
+  rshift(a, a, n, 1);
+  a[n - 1] |= top;
+}
+
+// a[0..n) = -a[0..n) mod 2^(LIMB_BITS n)
+inline void neg_n(limb *a, std::size_t n) noexcept {
+  for (std::size_t i = 0; i < n; i++)
+    a[i] = ~a[i];
+  add_1(a, a, n, 1);
+}
+
+// The values at 1, -1 and -2 of x = x2 B^2k + x1 B^k + x0 for Toom-3, where x2
+// has xn - 2k limbs, 1 <= xn - 2k <= k. e[0..k] = x(1), e[k+1..2k+1] =
+// |x(-1)| and e[2k+2..3k+2] = |x(-2)|, and the result tells which of the last
+// two are negative. t is scratch space of k + 1 limbs.
+inline std::pair<bool, bool> toom3_eval(limb *e, const limb *x, std::size_t xn,
+                                        std::size_t k, limb *t) noexcept {
+  limb *const p1 = e;
+  limb *const pm1 = e + k + 1;
+  limb *const pm2 = e + 2 * (k + 1);
+  const limb *const x0 = x;
+  const limb *const x1 = x + k;
+  const limb *const x2 = x + 2 * k;
+  const std::size_t l2 = xn - 2 * k;
+
+  // t = x0 + x2, x(1) = t + x1 and x(-1) = t - x1
+  limb c = add_n(t, x0, x2, l2);
+  t[k] = add_1(t + l2, x0 + l2, k - l2, c);
+  p1[k] = t[k] + add_n(p1, t, x1, k);
+  bool neg1 = false;
+  if (!t[k] && cmp_n(t, x1, k) < 0) {
+    sub_n(pm1, x1, t, k);
+    pm1[k] = 0;
+    neg1 = true;
+  } else {
+    pm1[k] = t[k] - sub_n(pm1, t, x1, k);
+  }
+
+  // u = x(-1) + x2, below 3 B^k in absolute value
+  bool negu = false;
+  if (!neg1) {
+    c = add_n(pm2, pm1, x2, l2);
+    pm2[k] = pm1[k] + add_1(pm2 + l2, pm1 + l2, k - l2, c);
+  } else {
+    // |x(-1)| < B^k here
+    std::copy(x2, x2 + l2, t);
+    std::fill(t + l2, t + k, limb{0});
+    if (cmp_n(t, pm1, k) < 0) {
+      sub_n(pm2, pm1, t, k);
+      negu = true;
+    } else {
+      sub_n(pm2, t, pm1, k);
+    }
+    pm2[k] = 0;
+  }
+
+  // x(-2) = 2 u - x0
+  lshift(pm2, pm2, k + 1, 1);
+  bool neg2 = negu;
+  if (negu) {
+    pm2[k] += add_n(pm2, pm2, x0, k);
+  } else if (!pm2[k] && cmp_n(pm2, x0, k) < 0) {
+    sub_n(pm2, x0, pm2, k);
+    neg2 = true;
+  } else {
+    pm2[k] -= sub_n(pm2, pm2, x0, k);
+  }
+  return {neg1, neg2};
+}
+
+// r[0..n) = a b / 2^(LIMB_BITS n) mod m by Montgomery multiplication with
+// coarsely integrated operand scanning, for a, b < m with m odd and
+// minv = mont_inverse(m[0]). t is scratch space of n + 2 limbs. r may alias a
+// or b. The sequence of operations and memory accesses does not depend on
+// the values of a and b.
+inline void mont_mul(limb *r, const limb *a, const limb *b, const limb *m,
+                     std::size_t n, limb minv, limb *t) noexcept {
+  std::fill(t, t + n + 2, limb{0});
+  for (std::size_t i = 0; i < n; i++) {
+    // t += a b[i]
+    limb carry = 0;
+    for (std::size_t j = 0; j < n; j++) {
+      const dlimb s = dlimb{a[j]} * b[i] + t[j] + carry;
+      t[j] = static_cast<limb>(s);
+      carry = static_cast<limb>(s >> LIMB_BITS);
+    }
+    dlimb s = dlimb{t[n]} + carry;
+    t[n] = static_cast<limb>(s);
+    t[n + 1] = static_cast<limb>(s >> LIMB_BITS);
+    // t = (t + q m) / 2^LIMB_BITS, where q makes the low limb vanish
+    const limb q = t[0] * minv;
+    s = dlimb{m[0]} * q + t[0];
+    carry = static_cast<limb>(s >> LIMB_BITS);
+    for (std::size_t j = 1; j < n; j++) {
+      s = dlimb{m[j]} * q + t[j] + carry;
+      t[j - 1] = static_cast<limb>(s);
+      carry = static_cast<limb>(s >> LIMB_BITS);
+    }
+    s = dlimb{t[n]} + carry;
+    t[n - 1] = static_cast<limb>(s);
+    t[n] = t[n + 1] + static_cast<limb>(s >> LIMB_BITS);
+  }
+  // t < 2m, so subtract m once when t >= m, choosing by mask, not branch
+  const limb borrow = sub_n(r, t, m, n);
+  const limb keep = 0 - ((t[n] | (borrow ^ 1)) & 1);
+  for (std::size_t j = 0; j < n; j++)
+    r[j] = (r[j] & keep) | (t[j] & ~keep);
+}
+
+// r[0..n) = t[0..2n) / 2^(LIMB_BITS n) mod m by Montgomery reduction, for
+// t < m 2^(LIMB_BITS n) and minv = mont_inverse(m[0]). t is overwritten.
+// Unlike mont_mul, the running time depends on the values.
+inline void mont_redc(limb *r, limb *t, const limb *m, std::size_t n,
+                      limb minv) noexcept {
+  // the sum below stays under 2 m 2^(LIMB_BITS n), so one carry bit is left
+  limb top = 0;
+  for (std::size_t i = 0; i < n; i++) {
+    const limb carry = addmul_1(t + i, m, n, t[i] * minv);
+    top += add_1(t + i + n, t + i + n, n - i, carry);
+  }
+  if (top || cmp_n(t + n, m, n) >= 0) {
+    sub_n(r, t + n, m, n);
+  } else {
+    std::copy(t + n, t + 2 * n, r);
+  }
+}
+
+// x^e by left-to-right sliding-window exponentiation, for e[0..en) with a
+// nonzero top limb. mul(r, a, b) sets r = a b and must allow r to alias a or
+// b. Squarings pass the same value as a and b.
+template <typename T, typename Mul>
+T window_pow(const T &x, const limb *e, std::size_t en, Mul mul) {
+  const std::size_t bits =
+      en * LIMB_BITS - static_cast<std::size_t>(std::countl_zero(e[en - 1]));
+  const std::size_t k = bits > 671 ? 6
+                        : bits > 239 ? 5
+                        : bits > 79  ? 4
+                        : bits > 23  ? 3
+                        : bits > 7   ? 2
+                                     : 1;
+  const auto bit = [e](std::size_t i) -> unsigned {
+    return (e[i / LIMB_BITS] >> (i % LIMB_BITS)) & 1;
+  };
+  // x, x^3, ..., x^(2^k - 1)
+  std::vector<T> odd(std::size_t{1} << (k - 1), x);
+  if (k > 1) {
+    T x2 = x;
+    mul(x2, x, x);
+    for (std::size_t i = 1; i < odd.size(); i++)
+      mul(odd[i], odd[i - 1], x2);
+  }
+  // the top bit is set, so the first window starts the result
+  T r = x;
+  bool started = false;
+  for (std::size_t i = bits; i > 0;) {
+    if (!bit(i - 1)) {
+      mul(r, r, r);
+      i--;
+      continue;
+    }
+    // the longest window of at most k bits below i that ends in a one
+    std::size_t lo = i > k ? i - k : 0;
+    while (!bit(lo))
+      lo++;
+    std::size_t w = 0;
+    for (std::size_t j = i; j-- > lo;) {
+      w = 2 * w + bit(j);
+      if (started)
+        mul(r, r, r);
+    }
+    if (started) {
+      mul(r, r, odd[w >> 1]);
+    } else {
+      r = odd[w >> 1];
+      started = true;
+    }
+    i = lo;
+  }
+  return r;
+}
+
+// The cofactors of a run of Euclid steps on u >= v: afterwards (u, v)
+// becomes (a u + b v, c u + d v). a and b have opposite signs, as do c and
+// d, and odd is set when the number of steps is odd, so that ad - bc = -1.
+struct lehmer_step {
+  std::int64_t a, b, c, d;
+  bool odd;
+};
+
+// Knuth's algorithm L on x >= y, the leading bits of u and v cut at the same
+// position with x < 2^62. It takes each step whose quotient both bounds of
+// the truncated values agree on, while the cofactors fit in a limb. Returns
+// false when not a single step is certain.
+inline bool lehmer(std::uint64_t x0, std::uint64_t y0, lehmer_step &s) noexcept {
+  constexpr std::int64_t LIMIT = std::int64_t{1} << LIMB_BITS;
+  auto x = static_cast<std::int64_t>(x0);
+  auto y = static_cast<std::int64_t>(y0);
+  std::int64_t a = 1, b = 0, c = 0, d = 1;
+  bool odd = false;
+  while (y + c != 0 && y + d != 0) {
+    const std::int64_t q = (x + a) / (y + c);
+    if (q != (x + b) / (y + d))
+      break;
+    // by the alternating signs, |a - q c| = |a| + q |c|
+    if ((c && q > (LIMIT - 1 - std::abs(a)) / std::abs(c)) ||
+        (d && q > (LIMIT - 1 - std::abs(b)) / std::abs(d)))
+      break;
+    std::int64_t t = a - q * c;
+    a = c;
+    c = t;
+    t = b - q * d;
+    b = d;
+    d = t;
+    t = x - q * y;
+    x = y;
+    y = t;
+    odd = !odd;
+  }
+  s = {a, b, c, d, odd};
+  return b != 0;
+}
+
+// the value of each character as a digit, or 0xff when it is not one. A
+// table keeps parsing free of locale-dependent <cctype> calls.
+inline constexpr auto DIGIT_VALUE = [] {
+  std::array<std::uint8_t, 256> t{};
+  t.fill(0xff);
+  for (int i = 0; i < 10; i++)
+    t[static_cast<std::size_t>('0' + i)] = static_cast<std::uint8_t>(i);
+  for (int i = 0; i < 26; i++) {
+    t[static_cast<std::size_t>('a' + i)] = static_cast<std::uint8_t>(10 + i);
+    t[static_cast<std::size_t>('A' + i)] = static_cast<std::uint8_t>(10 + i);
+  }
+  return t;
+}();
+
+// the largest power of base that fits a limb, and its exponent
+struct radix_chunk {
+  limb power;
+  std::size_t digits;
+};
+
+inline constexpr radix_chunk chunk_of(int base) noexcept {
+  const auto b = static_cast<limb>(base);
+  radix_chunk c{b, 1};
+  while (c.power <= std::numeric_limits<limb>::max() / b) {
+    c.power *= b;
+    c.digits++;
+  }
+  return c;
+}
+
+// Digits of a power of two base map to bit fields of the limbs, so they are
+// converted without arithmetic on the value. Hexadecimal, with eight digits
+// to a limb, also has AVX2 kernels that classify, pack and print 32 digits
+// at a time.
+
+#ifdef BIGINT_X86_SIMD
+// bytes of v in [lo, hi], as signed bytes, which leaves out bytes >= 0x80
+__attribute__((target("avx2"))) inline __m256i
+avx2_in_range(__m256i v, char lo, char hi) noexcept {
+  return _mm256_and_si256(_mm256_cmpgt_epi8(v, _mm256_set1_epi8(static_cast<char>(lo - 1))),
+                          _mm256_cmpgt_epi8(_mm256_set1_epi8(static_cast<char>(hi + 1)), v));
+}
+
+__attribute__((target("avx2"))) inline const char *
+hex_span_avx2(const char *p, const char *last) noexcept {
+  const __m256i lower = _mm256_set1_epi8(0x20);
+  while (last - p >= 32) {
+    const __m256i c = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p));
+    const __m256i ok =
+        _mm256_or_si256(avx2_in_range(c, '0', '9'),
+                        avx2_in_range(_mm256_or_si256(c, lower), 'a', 'f'));
+    const auto m = static_cast<unsigned>(_mm256_movemask_epi8(ok));
+    if (m != 0xffffffffu)
+      return p + std::countr_zero(~m);
+    p += 32;
+  }
+  return p;
+}
+
+// r[0..4) from the 32 hexadecimal digits at s, most significant first
+__attribute__((target("avx2"))) inline void hex32_avx2(limb *r,
+                                                       const char *s) noexcept {
+  const __m256i c = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(s));
+  // (c & 15) + 9 for letters, which have bit 6 set
+  const __m256i letter =
+      _mm256_srli_epi16(_mm256_and_si256(c, _mm256_set1_epi8(0x40)), 6);
+  const __m256i v = _mm256_add_epi8(
+      _mm256_and_si256(c, _mm256_set1_epi8(0x0f)),
+      _mm256_add_epi8(_mm256_slli_epi16(letter, 3), letter));
+  // pairs of digits to bytes, then the 16 bytes in little-endian order
+  const __m256i pairs = _mm256_maddubs_epi16(v, _mm256_set1_epi16(0x0110));
+  const __m256i bytes = _mm256_permute4x64_epi64(
+      _mm256_packus_epi16(pairs, pairs), 0x08);
+  const __m128i reverse =
+      _mm_setr_epi8(15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0);
+  _mm_storeu_si128(reinterpret_cast<__m128i *>(r),
+                   _mm_shuffle_epi8(_mm256_castsi256_si128(bytes), reverse));
+}
+
+// the 32 hexadecimal digits of a[0..4), most significant first
+__attribute__((target("avx2"))) inline void hex32_out_avx2(char *out,
+                                                           const limb *a) noexcept {
+  const __m128i reverse =
+      _mm_setr_epi8(15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0);
+  const __m128i table = _mm_setr_epi8('0', '1', '2', '3', '4', '5', '6', '7',
+                                      '8', '9', 'a', 'b', 'c', 'd', 'e', 'f');
+  const __m128i mask = _mm_set1_epi8(0x0f);
+  const __m128i x = _mm_shuffle_epi8(
+      _mm_loadu_si128(reinterpret_cast<const __m128i *>(a)), reverse);
+  const __m128i hi = _mm_and_si128(_mm_srli_epi16(x, 4), mask);
+  const __m128i lo = _mm_and_si128(x, mask);
+  _mm_storeu_si128(reinterpret_cast<__m128i *>(out),
+                   _mm_shuffle_epi8(table, _mm_unpacklo_epi8(hi, lo)));
+  _mm_storeu_si128(reinterpret_cast<__m128i *>(out + 16),
+                   _mm_shuffle_epi8(table, _mm_unpackhi_epi8(hi, lo)));
+}
+#endif
+
+// the end of the run of hexadecimal digits starting at p
+inline const char *hex_span(const char *p, const char *last) noexcept {
+#ifdef BIGINT_X86_SIMD
+  if (simd_dispatch != simd_level::none)
+    p = hex_span_avx2(p, last);
+#endif
+  while (p != last && DIGIT_VALUE[static_cast<unsigned char>(*p)] < 16)
+    p++;
+  return p;
+}
+
+// r[0..ceil(len / 8)) from the hexadecimal digits s[0..len), most significant
+// first
+inline void hex_to_limbs(limb *r, const char *s, std::size_t len) noexcept {
+  const char *end = s + len;
+#ifdef BIGINT_X86_SIMD
+  if (simd_dispatch != simd_level::none) {
+    for (; end - s >= 32; r += 4) {
+      end -= 32;
+      hex32_avx2(r, end);
+    }
+  }
+#endif
+  for (; s != end; r++) {
+    const char *const begin = end - std::min<std::ptrdiff_t>(end - s, 8);
+    limb v = 0;
+    for (const char *p = begin; p != end; p++)
+      v = v << 4 | DIGIT_VALUE[static_cast<unsigned char>(*p)];
+    *r = v;
+    end = begin;
+  }
+}
+
+// the 8 n hexadecimal digits of a[0..n), most significant first
+inline void limbs_to_hex(char *out, const limb *a, std::size_t n) noexcept {
+#ifdef BIGINT_X86_SIMD
+  if (simd_dispatch != simd_level::none) {
+    for (; n >= 4; out += 32) {
+      n -= 4;
+      hex32_out_avx2(out, a + n);
+    }
+  }
+#endif
+  while (n-- > 0) {
+    for (int j = 28; j >= 0; j -= 4)
+      *out++ = DIGITS[(a[n] >> j) & 15];
+  }
+}
+
+// r[0..ceil(len k / 32)) from the digits s[0..len) of base 2^k, most
+// significant first
+inline void pow2_to_limbs(limb *r, const char *s, std::size_t len,
+                          unsigned k) noexcept {
+  dlimb acc = 0;
+  unsigned bits = 0;
+  for (const char *p = s + len; p != s;) {
+    acc |= dlimb{DIGIT_VALUE[static_cast<unsigned char>(*--p)]} << bits;
+    bits += k;
+    if (bits >= LIMB_BITS) {
+      *r++ = static_cast<limb>(acc);
+      acc >>= LIMB_BITS;
+      bits -= LIMB_BITS;
+    }
+  }
+  if (bits)
+    *r = static_cast<limb>(acc);
+}
+
+// the low digits digits of base 2^k of a[0..n), most significant first
+inline void limbs_to_pow2(char *out, const limb *a, std::size_t n,
+                          std::size_t digits, unsigned k) noexcept {
+  while (digits-- > 0) {
+    const std::size_t pos = digits * k;
+    const std::size_t i = pos / LIMB_BITS;
+    dlimb x = a[i];
+    if (i + 1 < n)
+      x |= dlimb{a[i + 1]} << LIMB_BITS;
+    *out++ = DIGITS[(x >> (pos % LIMB_BITS)) & ((1u << k) - 1)];
+  }
+}
+// Statistics of the hot paths, counted when BIGINT_STATS is defined before
+// bigint.hpp is included and compiled away otherwise.
+#ifdef BIGINT_STATS
+inline constexpr bool stats_enabled = true;
+#else
+inline constexpr bool stats_enabled = false;
+#endif
+
+enum class stat : std::size_t {
+  plus_calls,
+  plus_limbs,
+  monus_calls,
+  monus_limbs,
+  mult_calls,
+  mult_limbs,
+  parse_calls,
+  parse_chars,
+  print_calls,
+  print_chars,
+  allocations,
+  reallocations,
+  mul_basecase,
+  mul_karatsuba,
+  mul_toom3,
+  mul_ntt,
+  mul_unbalanced,
+  count
+};
+
+using stat_array = std::array<std::uint64_t, static_cast<std::size_t>(stat::count)>;
+
+// Every thread counts into its own block, which only that thread writes, so
+// the counters need no read-modify-write instructions. Readers sum the live
+// blocks under the registry lock, and a block is folded into the retired
+// totals when its thread exits.
+struct stat_block {
+  std::array<std::atomic<std::uint64_t>, static_cast<std::size_t>(stat::count)>
+      c{};
+};
+
+class stat_registry {
+public:
+  // Never destroyed, since threads that exit during static destruction,
+  // such as the workers of thread_pool, still fold their blocks into it.
+  static stat_registry &instance() noexcept {
+    static stat_registry *const r = new stat_registry;
+    return *r;
+  }
+
+  void attach(const stat_block *b) noexcept {
+    const std::lock_guard lock(m);
+    live.push_back(b);
+  }
+
+  void detach(const stat_block *b) noexcept {
+    const std::lock_guard lock(m);
+    for (std::size_t i = 0; i < retired.size(); i++)
+      retired[i] += b->c[i].load(std::memory_order_relaxed);
+    std::erase(live, b);
+  }
+
+  // the counts since the last reset
+  [[nodiscard]] stat_array totals() noexcept {
+    const std::lock_guard lock(m);
+    stat_array t = sum();
+    for (std::size_t i = 0; i < t.size(); i++)
+      t[i] -= baseline[i];
+    return t;
+  }
+
+  void reset() noexcept {
+    const std::lock_guard lock(m);
+    baseline = sum();
+  }
+
+private:
+  std::mutex m;
+  std::vector<const stat_block *> live;
+  stat_array retired{};
+  stat_array baseline{};
+
+  [[nodiscard]] stat_array sum() const noexcept {
+    stat_array t = retired;
+    for (const stat_block *b : live)
+      for (std::size_t i = 0; i < t.size(); i++)
+        t[i] += b->c[i].load(std::memory_order_relaxed);
+    return t;
+  }
+};
+
+struct stat_slot {
+  stat_block block;
+  stat_slot() noexcept { stat_registry::instance().attach(&block); }
+  ~stat_slot() { stat_registry::instance().detach(&block); }
+  stat_slot(const stat_slot &) = delete;
+  stat_slot &operator=(const stat_slot &) = delete;
+};
+
+inline void count(const stat s, const std::uint64_t n = 1) noexcept {
+  if constexpr (stats_enabled) {
+    thread_local stat_slot slot;
+    std::atomic<std::uint64_t> &c = slot.block.c[static_cast<std::size_t>(s)];
+    c.store(c.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+  }
+}
+
+// The memory resource that limb vectors constructed on this thread allocate
+// from, where nullptr stands for std::allocator. See bigint_memory_scope.
+inline thread_local std::pmr::memory_resource *current_resource = nullptr;
+
+// A vector of limbs that stores up to INLINE_LIMBS limbs inside the object and
+// only moves to heap storage once it grows past that, so small values never
+// allocate. It provides the subset of the std::vector interface bigint needs.
+//
+// Heap storage comes from the memory resource that was current when the
+// vector was constructed. As with std::pmr containers, a copy takes the
+// resource current at the time of the copy, a move constructor takes over
+// the source's resource, and a move assignment between different resources
+// copies the limbs.
+class limb_vector {
+public:
+  static constexpr std::size_t INLINE_LIMBS = 4;
+
+  limb_vector() noexcept
+      : size_(0), cap_(INLINE_LIMBS), res_(current_resource) {}
+
+  limb_vector(std::initializer_list<limb> init) noexcept : limb_vector() {
+    assign(init.begin(), init.end());
+  }
+
+  explicit limb_vector(std::size_t n, limb v = 0) noexcept : limb_vector() {
+    assign(n, v);
+  }
+
+  limb_vector(const limb_vector &other) noexcept : limb_vector() {
+    assign(other.begin(), other.end());
+  }
+
+  limb_vector(limb_vector &&other) noexcept
+      : size_(0), cap_(INLINE_LIMBS), res_(other.res_) {
+    steal(other);
+  }
+
+  limb_vector &operator=(const limb_vector &other) noexcept {
+    if (this != &other)
+      assign(other.begin(), other.end());
+    return *this;
+  }
+
+  limb_vector &operator=(limb_vector &&other) noexcept {
+    if (this == &other)
+      return *this;
+    if (other.on_heap() && res_ != other.res_) {
+      assign(other.begin(), other.end());
+    } else {
+      release();
+      steal(other);
+    }
+    return *this;
+  }
+
+  ~limb_vector() { release(); }
+
+  [[nodiscard]] limb *data() noexcept { return on_heap() ? heap_ : inline_; }
+  [[nodiscard]] const limb *data() const noexcept {
+    return on_heap() ? heap_ : inline_;
+  }
+  [[nodiscard]] std::size_t size() const noexcept { return size_; }
+  [[nodiscard]] std::size_t capacity() const noexcept { return cap_; }
+  [[nodiscard]] std::pmr::memory_resource *resource() const noexcept {
+    return res_;
+  }
+  [[nodiscard]] bool empty() const noexcept { return !size_; }
+
+  [[nodiscard]] limb *begin() noexcept { return data(); }
+  [[nodiscard]] limb *end() noexcept { return data() + size_; }
+  [[nodiscard]] const limb *begin() const noexcept { return data(); }
+  [[nodiscard]] const limb *end() const noexcept { return data() + size_; }
+
+  [[nodiscard]] limb &operator[](std::size_t i) noexcept { return data()[i]; }
+  [[nodiscard]] const limb &operator[](std::size_t i) const noexcept {
+    return data()[i];
+  }
+  [[nodiscard]] const limb &at(std::size_t i) const noexcept(false) {
+    if (i >= size_)
+      throw std::out_of_range("limb_vector::at");
+    return data()[i];
+  }
+  [[nodiscard]] limb &back() noexcept { return data()[size_ - 1]; }
+  [[nodiscard]] const limb &back() const noexcept {
+    return data()[size_ - 1];
+  }
+
+  void reserve(std::size_t n) noexcept {
+    if (n > cap_)
+      reallocate(n);
+  }
+
+  void resize(std::size_t n, limb v = 0) noexcept {
+    grow(n);
+    if (n > size_)
+      std::fill(data() + size_, data() + n, v);
+    size_ = n;
+  }
+
+  void push_back(limb v) noexcept {
+    grow(size_ + 1);
+    data()[size_++] = v;
+  }
+
+  void pop_back() noexcept { size_--; }
+  void clear() noexcept { size_ = 0; }
+
+  void assign(std::size_t n, limb v) noexcept {
+    size_ = 0;
+    resize(n, v);
+  }
+
+  void assign(const limb *first, const limb *last) noexcept {
+    const auto n = static_cast<std::size_t>(last - first);
+    if (n > cap_) {
+      size_ = 0;
+      reallocate(n);
+    }
+    std::copy(first, last, data());
+    size_ = n;
+  }
+
+  // inserts n copies of v before pos
+  limb *insert(const limb *pos, std::size_t n, limb v) noexcept {
+    const auto i = static_cast<std::size_t>(pos - data());
+    grow(size_ + n);
+    limb *const p = data() + i;
+    std::memmove(p + n, p, (size_ - i) * sizeof(limb));
+    std::fill(p, p + n, v);
+    size_ += n;
+    return p;
+  }
+
+  limb *erase(const limb *pos) noexcept {
+    const auto i = static_cast<std::size_t>(pos - data());
+    limb *const p = data() + i;
+    std::memmove(p, p + 1, (size_ - i - 1) * sizeof(limb));
+    size_--;
+    return p;
+  }
+
+  // returns heap storage that is no longer needed, moving back inline if the
+  // limbs fit
+  void shrink_to_fit() noexcept {
+    if (on_heap() && size_ < cap_)
+      reallocate(size_);
+  }
+
+  friend bool operator==(const limb_vector &a, const limb_vector &b) noexcept {
+    return a.size_ == b.size_ && std::equal(a.begin(), a.end(), b.begin());
+  }
+
+private:
+  std::size_t size_;
+  std::size_t cap_;
+  std::pmr::memory_resource *res_;
+  union {
+    limb inline_[INLINE_LIMBS];
+    limb *heap_;
+  };
+
+  [[nodiscard]] limb *allocate(std::size_t n) const noexcept {
+    count(stat::allocations);
+    if (!res_)
+      return std::allocator<limb>().allocate(n);
+    return static_cast<limb *>(res_->allocate(n * sizeof(limb), alignof(limb)));
+  }
+
+  void deallocate(limb *p, std::size_t n) const noexcept {
+    if (!res_)
+      std::allocator<limb>().deallocate(p, n);
+    else
+      res_->deallocate(p, n * sizeof(limb), alignof(limb));
+  }
+
+  [[nodiscard]] bool on_heap() const noexcept { return cap_ > INLINE_LIMBS; }
+
+  void grow(std::size_t n) noexcept {
+    if (n > cap_)
+      reallocate(std::max(n, 2 * cap_));
+  }
+
+  // moves the limbs into storage of capacity max(n, INLINE_LIMBS), n >= size_
+  void reallocate(std::size_t n) noexcept {
+    limb *const old = data();
+    const bool was_heap = on_heap();
+    const std::size_t old_cap = cap_;
+    if (n <= INLINE_LIMBS) {
+      if (!was_heap)
+        return;
+      limb *const h = heap_;
+      std::copy(h, h + size_, inline_);
+      cap_ = INLINE_LIMBS;
+      deallocate(h, old_cap);
+      return;
+    }
+    limb *const p = allocate(n);
+    if (size_)
+      count(stat::reallocations);
+    std::copy(old, old + size_, p);
+    if (was_heap)
+      deallocate(old, old_cap);
+    heap_ = p;
+    cap_ = n;
+  }
+
+  void release() noexcept {
+    if (on_heap())
+      deallocate(heap_, cap_);
+    cap_ = INLINE_LIMBS;
+    size_ = 0;
+  }
+
+  // takes over the contents of other, which must be empty-initialized here
+  // and, if other is on the heap, share its resource
+  void steal(limb_vector &other) noexcept {
+    if (other.on_heap()) {
+      heap_ = other.heap_;
+      cap_ = other.cap_;
+      size_ = other.size_;
+      other.cap_ = INLINE_LIMBS;
+      other.size_ = 0;
+    } else {
+      std::memcpy(inline_, other.inline_, sizeof(inline_));
+      size_ = other.size_;
+      other.size_ = 0;
+    }
+  }
+};
+
+#ifdef DOCTEST_LIBRARY_INCLUDED
+TEST_CASE("[limb_vector] inline and heap storage") {
+  limb_vector v{1, 2};
+  const limb *const inline_data = v.data();
+  CHECK_EQ(v.capacity(), limb_vector::INLINE_LIMBS);
+  for (limb i = 3; i <= 4; i++)
+    v.push_back(i);
+  CHECK_EQ(v.data(), inline_data);
+  v.push_back(5);
+  CHECK_NE(v.data(), inline_data);
+  CHECK_EQ(v.size(), 5u);
+  CHECK_EQ(v.back(), 5u);
+
+  limb_vector copy = v;
+  CHECK(copy == v);
+  limb_vector moved = std::move(copy);
+  CHECK(moved == v);
+  CHECK(copy.empty());
+
+  v.insert(v.begin(), 2, 0);
+  CHECK_EQ(v.size(), 7u);
+  CHECK_EQ(v[0], 0u);
+  CHECK_EQ(v[2], 1u);
+  v.erase(v.begin());
+  v.resize(3);
+  v.shrink_to_fit();
+  CHECK_EQ(v.capacity(), limb_vector::INLINE_LIMBS);
+  CHECK(v == limb_vector{0, 1, 2});
+
+  limb_vector small{7};
+  moved = std::move(small);
+  CHECK(moved == limb_vector{7});
+  CHECK_THROWS_AS(static_cast<void>(moved.at(1)), std::out_of_range);
+}
+#endif
+
+#ifdef DOCTEST_LIBRARY_INCLUDED
+TEST_CASE("[kernels] vector add, sub and cmp") {
+  const simd_level saved = simd_dispatch;
+  // runs of all-ones and zero limbs make carries and borrows ripple across
+  // whole vector blocks
+  std::vector<limb> a(77), b(77);
+  for (std::size_t i = 0; i < a.size(); i++) {
+    a[i] = i % 5 == 0 ? 0x9e3779b9u * static_cast<limb>(i) : 0xffffffffu;
+    b[i] = i % 7 == 0 ? 0x7f4a7c15u * static_cast<limb>(i) + 1 : 0;
+  }
+  b[3] = 1;
+  for (std::size_t n = 0; n <= a.size(); n++) {
+    std::vector<limb> sum(n), diff(n), rsum(n), rdiff(n);
+    const limb carry = add_nc(rsum.data(), a.data(), b.data(), n, 0);
+    const limb borrow = sub_nc(rdiff.data(), b.data(), a.data(), n, 0);
+    for (int level = 0; level <= static_cast<int>(simd_supported); level++) {
+      simd_dispatch = static_cast<simd_level>(level);
+      CHECK_EQ(add_n(sum.data(), a.data(), b.data(), n), carry);
+      CHECK(sum == rsum);
+      CHECK_EQ(sub_n(diff.data(), b.data(), a.data(), n), borrow);
+      CHECK(diff == rdiff);
+      CHECK_EQ(cmp_n(a.data(), a.data(), n), 0);
+      if (n > 0) {
+        std::vector<limb> c(a.begin(), a.begin() + static_cast<std::ptrdiff_t>(n));
+        c[0] ^= 1;
+        const int expected = (a[0] & 1) ? 1 : -1;
+        CHECK_EQ(cmp_n(a.data(), c.data(), n), expected);
+        CHECK_EQ(cmp_n(c.data(), a.data(), n), -expected);
+      }
+    }
+  }
+  simd_dispatch = saved;
+}
+#endif
+
+// which residues modulo m are squares
+template <std::size_t M>
+constexpr std::array<bool, M> square_residues() noexcept {
+  std::array<bool, M> t{};
+  for (std::size_t i = 0; i < M; i++)
+    t[i * i % M] = true;
+  return t;
+}
+
+// 255 * 257 divides 2^32 - 1, so residues modulo both follow from a plain
+// sum of the limbs
+inline constexpr auto squares_mod_64 = square_residues<64>();
+inline constexpr auto squares_mod_255 = square_residues<255>();
+inline constexpr auto squares_mod_257 = square_residues<257>();
+
+// a mod (2^32 - 1)
+inline limb mod_limb_max(const limb *a, const std::size_t n) noexcept {
+  constexpr dlimb MASK = std::numeric_limits<limb>::max();
+  dlimb s = 0;
+  for (std::size_t i = 0; i < n; i++)
+    s += a[i];
+  s = (s & MASK) + (s >> LIMB_BITS);
+  s = (s & MASK) + (s >> LIMB_BITS);
+  return static_cast<limb>(s == MASK ? 0 : s);
+}
+
+// the odd primes up to n, by the sieve of Eratosthenes on odd numbers
+inline std::vector<limb> odd_primes(const limb n) noexcept {
+  // composite[i] for 2 i + 1
+  std::vector<bool> composite(n / 2 + 1);
+  for (dlimb i = 1; (2 * i + 1) * (2 * i + 1) <= n; i++) {
+    if (composite[i])
+      continue;
+    for (dlimb j = 2 * i * (i + 1); j <= n / 2; j += 2 * i + 1)
+      composite[j] = true;
+  }
+  std::vector<limb> primes;
+  for (dlimb i = 1; 2 * i + 1 <= n; i++) {
+    if (!composite[i])
+      primes.push_back(static_cast<limb>(2 * i + 1));
+  }
+  return primes;
+}
+
+} // namespace bigint_detail
+
+/**
+ * Directs the heap storage of bigints constructed on this thread to a memory
+ * resource for the lifetime of the scope, so that a whole computation can
+ * allocate from a std::pmr::monotonic_buffer_resource or a pool and release
+ * everything at once. Scopes nest, and the previous resource is restored on
+ * destruction.
+ *
+ * A bigint keeps the resource it was constructed with. Moving it elsewhere
+ * keeps the storage, so results that must outlive the resource should be
+ * copied, or move assigned to a bigint constructed outside the scope, which
+ * copies the limbs into that bigint's own storage.
+ */
+class bigint_memory_scope {
+public:
+  /**
+   * Makes res the current resource of this thread.
+   * @param res The memory resource, or nullptr for std::allocator.
+   */
+  explicit bigint_memory_scope(std::pmr::memory_resource *res) noexcept
+      : prev(bigint_detail::current_resource) {
+    bigint_detail::current_resource = res;
+  }
+
+  ~bigint_memory_scope() { bigint_detail::current_resource = prev; }
+
+  bigint_memory_scope(const bigint_memory_scope &) = delete;
+  bigint_memory_scope &operator=(const bigint_memory_scope &) = delete;
+
+  /**
+   * @return The memory resource used by bigints constructed on this thread,
+   * where nullptr stands for std::allocator.
+   */
+  [[nodiscard]]
+  static std::pmr::memory_resource *current() noexcept {
+    return bigint_detail::current_resource;
+  }
+
+private:
+  std::pmr::memory_resource *prev;
+};
+
+/**
+ * The per-thread scratch space of multiplication and division. Its limbs come
+ * from std::allocator, independently of bigint_memory_scope, and stay
+ * reserved between operations. bigint_workspace::local() reports the peak
+ * scratch use of the calling thread through peak(), and release() returns
+ * the memory once no operation is running on the thread.
+ */
+using bigint_workspace = bigint_detail::workspace;
+
+/**
+ * Counts of calls and limbs through the hot paths, summed over all threads.
+ * They are only collected when BIGINT_STATS is defined before bigint.hpp is
+ * included; otherwise the counting compiles to nothing and every count reads
+ * as zero. The multiplication tiers count each level of the recursion, and
+ * allocations and reallocations count the heap blocks of bigint values, not
+ * the scratch workspace.
+ */
+struct bigint_stats {
+  static constexpr bool enabled = bigint_detail::stats_enabled;
+
+  std::uint64_t plus_calls;     ///< magnitude additions
+  std::uint64_t plus_limbs;     ///< limbs of their results
+  std::uint64_t monus_calls;    ///< magnitude subtractions
+  std::uint64_t monus_limbs;    ///< limbs of their minuends
+  std::uint64_t mult_calls;     ///< bigint by bigint multiplications
+  std::uint64_t mult_limbs;     ///< limbs of their operands
+  std::uint64_t parse_calls;    ///< constructions from strings
+  std::uint64_t parse_chars;    ///< characters parsed
+  std::uint64_t print_calls;    ///< stream insertions
+  std::uint64_t print_chars;    ///< characters written
+  std::uint64_t allocations;    ///< heap blocks allocated
+  std::uint64_t reallocations;  ///< allocations that moved existing limbs
+  std::uint64_t mul_basecase;   ///< products by schoolbook multiplication
+  std::uint64_t mul_karatsuba;  ///< Karatsuba steps
+  std::uint64_t mul_toom3;      ///< Toom-3 steps
+  std::uint64_t mul_ntt;        ///< NTT products
+  std::uint64_t mul_unbalanced; ///< products split into balanced slices
+
+  /**
+   * @return The counts since the last reset, including those of threads that
+   * have exited.
+   */
+  [[nodiscard]]
+  static bigint_stats snapshot() noexcept {
+    using bigint_detail::stat;
+    const bigint_detail::stat_array t =
+        bigint_detail::stat_registry::instance().totals();
+    const auto at = [&t](stat s) { return t[static_cast<std::size_t>(s)]; };
+    return {at(stat::plus_calls),    at(stat::plus_limbs),
+            at(stat::monus_calls),   at(stat::monus_limbs),
+            at(stat::mult_calls),    at(stat::mult_limbs),
+            at(stat::parse_calls),   at(stat::parse_chars),
+            at(stat::print_calls),   at(stat::print_chars),
+            at(stat::allocations),   at(stat::reallocations),
+            at(stat::mul_basecase),  at(stat::mul_karatsuba),
+            at(stat::mul_toom3),     at(stat::mul_ntt),
+            at(stat::mul_unbalanced)};
+  }
+
+  /**
+   * Starts the counts from zero for every thread.
+   */
+  static void reset() noexcept {
+    bigint_detail::stat_registry::instance().reset();
+  }
+};
+
+/**
+ * How bigint::import_bytes and bigint::export_bytes lay out a magnitude, as
+ * in GMP's mpz_import and mpz_export: an array of words of word_size bytes,
+ * each holding 8 word_size - nails bits of the value with the nails top bits
+ * zero. word_order gives the order of the words, with std::endian::big for
+ * the most significant first, and byte_order that of the bytes within each
+ * word. The default is a plain big-endian byte string.
+ */
+struct bigint_layout {
+  std::size_t word_size = 1;
+  std::endian word_order = std::endian::big;
+  std::endian byte_order = std::endian::big;
+  std::size_t nails = 0;
+};
+
+namespace bigint_detail {
+// the built-in integers that bigint operators take directly
+template <typename T>
+concept small_integer = std::integral<T> && !std::same_as<T, bool> &&
+                        sizeof(T) <= sizeof(std::uint64_t);
+
+// |v| and whether v is negative, with INT64_MIN well defined
+template <small_integer T>
+constexpr std::pair<std::uint64_t, bool> magnitude(const T v) noexcept {
+  if constexpr (std::is_signed_v<T>) {
+    if (v < 0)
+      return {0 - static_cast<std::uint64_t>(v), true};
+  }
+  return {static_cast<std::uint64_t>(v), false};
+}
+} // namespace bigint_detail
+
+class bigint;
+class bigint_view;
+template <std::size_t Bits> class fixed_bigint;
+
+namespace bigint_expr {
+template <std::size_t N> struct sum;
+} // namespace bigint_expr
+
+class bigint {
+  using WORD = bigint_detail::limb;
+  using DWORD = bigint_detail::dlimb;
+
+protected:
+  // sign == true if n is negative, sign == false if n is positive
+  bool sign;
+  // val holds the magnitude of bigint as little-endian base 2^32 limbs, with
+  // no leading zero limbs except for the value 0 itself. Values of up to
+  // limb_vector::INLINE_LIMBS limbs are stored without heap allocation.
+  bigint_detail::limb_vector val;
+
+public:
+  /**
+   * Default constructor for bigint. Initializes to 0.
+   */
+  bigint() noexcept : sign(false), val{0} {};
+
+  /**
+   * Constructs a bigint from a 64-bit integer.
+   * @param n The integer to initialize the bigint.
+   */
+  explicit bigint(int64_t n) noexcept;
+
+  /**
+   * A constructor that takes a string and converts the string to an
+   * arbitrary-precision integer.
+   * @param sv the string to convert, an optional '-' followed by digits
+   * @param base the base of the digits, between 2 and 36
+   * @throws std::invalid_argument if sv is not entirely a valid integer
+   */
+  explicit bigint(std::string_view sv, int base = 10) noexcept(false);
+
+  /**
+   * Copies the value a bigint_view refers to.
+   * @param v The view.
+   */
+  explicit bigint(bigint_view v) noexcept;
+
+  /**
+   * Parses an optional '-' followed by digits of the given base from
+   * [first, last), like std::from_chars. Letters of either case are accepted
+   * as digits above 9. Parsing stops at the first character that is not a
+   * digit.
+   * @param first The start of the input.
+   * @param last The end of the input.
+   * @param value Receives the parsed integer, only modified on success.
+   * @param base The base, between 2 and 36.
+   * @return {pointer past the last digit, std::errc{}} on success, or
+   * {first, std::errc::invalid_argument} if there are no digits or the base
+   * is out of range.
+   */
+  static std::from_chars_result from_chars(const char *first, const char *last,
+                                           bigint &value,
+                                           int base = 10) noexcept;
+
+  /**
+   * Adds a single WORD to the bigint.
+   * @param b The WORD to add.
+   * @return A new bigint representing the result.
+   */
+  [[nodiscard]]
+  bigint operator+(WORD b) const noexcept;
+
+  /**
+   * Adds a single WORD to the bigint in-place.
+   * @param b The WORD to add.
+   * @return A reference to the updated bigint.
+   */
+  const bigint &operator+=(WORD b) noexcept;
+
+  /**
+   * Multiplies the bigint by a single WORD.
+   * @param b The WORD to multiply with.
+   * @return A new bigint representing the result.
+   */
+  [[nodiscard]]
+  bigint operator*(WORD b) const noexcept;
+
+  /**
+   * Multiplies the bigint by a single WORD in-place.
+   * @param b The WORD to multiply with.
+   * @return A reference to the updated bigint.
+   */
+  const bigint &operator*=(WORD b) noexcept;
+
+  /**
+   * Adds another bigint to this bigint.
+   * @param b The bigint to add.
+   * @return A new bigint representing the result.
+   */
+  [[nodiscard]]
+  bigint operator+(const bigint &b) const & noexcept;
+
+  /**
+   * Adds another bigint to this temporary bigint, reusing its storage for
+   * the result.
+   * @param b The bigint to add.
+   * @return The updated bigint.
+   */
+  [[nodiscard]]
+  bigint operator+(const bigint &b) && noexcept;
+
+  /**
+   * Adds a temporary bigint to this bigint, reusing the storage of b for
+   * the result.
+   * @param b The bigint to add.
+   * @return The updated b.
+   */
+  [[nodiscard]]
+  bigint operator+(bigint &&b) const & noexcept;
+
+  /**
+   * Adds two temporary bigints, reusing the storage of this one.
+   * @param b The bigint to add.
+   * @return The updated bigint.
+   */
+  [[nodiscard]]
+  bigint operator+(bigint &&b) && noexcept;
+
+  /**
+   * Adds another bigint to this bigint in-place.
+   * @param b The bigint to add.
+   * @return A reference to the updated bigint.
+   */
+  const bigint &operator+=(const bigint &b) noexcept;
+
+  /**
+   * Subtracts another bigint from this bigint.
+   * @param b The bigint to subtract.
+   * @return A new bigint representing the result.
+   */
+  [[nodiscard]]
+  bigint operator-(const bigint &b) const & noexcept;
+
+  /**
+   * Subtracts another bigint from this temporary bigint, reusing its storage
+   * for the result.
+   * @param b The bigint to subtract.
+   * @return The updated bigint.
+   */
+  [[nodiscard]]
+  bigint operator-(const bigint &b) && noexcept;
+
+  /**
+   * Subtracts a temporary bigint from this bigint, reusing the storage of b
+   * for the result.
+   * @param b The bigint to subtract.
+   * @return The updated b.
+   */
+  [[nodiscard]]
+  bigint operator-(bigint &&b) const & noexcept;
+
+  /**
+   * Subtracts a temporary bigint from this temporary bigint, reusing the
+   * storage of this one.
+   * @param b The bigint to subtract.
+   * @return The updated bigint.
+   */
+  [[nodiscard]]
+  bigint operator-(bigint &&b) && noexcept;
+
+  /**
+   * Subtracts another bigint from this bigint in-place.
+   * @param b The bigint to subtract.
+   * @return A reference to the updated bigint.
+   */
+  const bigint &operator-=(const bigint &b) noexcept;
+
+  /**
+   * Multiplies this bigint by another bigint.
+   * @param b The bigint to multiply with.
+   * @return A new bigint representing the result.
+   */
+  [[nodiscard]]
+  bigint operator*(const bigint &b) const & noexcept;
+
+  /**
+   * Multiplies this temporary bigint by another bigint.
+   * @param b The bigint to multiply with.
+   * @return The updated bigint.
+   */
+  [[nodiscard]]
+  bigint operator*(const bigint &b) && noexcept;
+
+  /**
+   * Multiplies this bigint by a temporary bigint.
+   * @param b The bigint to multiply with.
+   * @return The updated b.
+   */
+  [[nodiscard]]
+  bigint operator*(bigint &&b) const & noexcept;
+
+  /**
+   * Multiplies two temporary bigints.
+   * @param b The bigint to multiply with.
+   * @return The updated bigint.
+   */
+  [[nodiscard]]
+  bigint operator*(bigint &&b) && noexcept;
+
+  /**
+   * Multiplies this bigint by another bigint in-place.
+   * @param b The bigint to multiply with.
+   * @return A reference to the updated bigint.
+   */
+  const bigint &operator*=(const bigint &b) noexcept;
+
+  /**
+   * Reserves storage for at least the given number of limbs, so that results
+   * up to that size are written without reallocating.
+   * @param limbs The number of 32-bit limbs.
+   */
+  void reserve(std::size_t limbs) noexcept;
+
+  /**
+   * Returns storage beyond the current value to the memory resource.
+   */
+  void shrink_to_fit() noexcept;
+
+  /**
+   * @return The number of limbs the bigint can hold without reallocating.
+   */
+  [[nodiscard]]
+  std::size_t capacity() const noexcept;
+
+  /**
+   * Stores a + b in dst, reusing the storage of dst when it is large enough.
+   * @param dst The result, which may be a or b.
+   * @param a The first summand.
+   * @param b The second summand.
+   */
+  static void add(bigint &dst, const bigint &a, const bigint &b) noexcept;
+
+  /**
+   * Stores a - b in dst, reusing the storage of dst when it is large enough.
+   * @param dst The result, which may be a or b.
+   * @param a The minuend.
+   * @param b The subtrahend.
+   */
+  static void sub(bigint &dst, const bigint &a, const bigint &b) noexcept;
+
+  /**
+   * Stores a * b in dst. Unless dst is one of the factors, the product is
+   * written straight into the storage of dst, which is only reallocated if
+   * it holds fewer than the limbs of a and b together.
+   * @param dst The result, which may be a or b.
+   * @param a The first factor.
+   * @param b The second factor.
+   */
+  static void mul(bigint &dst, const bigint &a, const bigint &b) noexcept;
+
+  /**
+   * Adds a * b to dst without creating the product as a separate bigint.
+   * Small products are accumulated row by row into the limbs of dst.
+   * @param dst The bigint to update, which may be a or b.
+   * @param a The first factor.
+   * @param b The second factor.
+   */
+  static void addmul(bigint &dst, const bigint &a, const bigint &b) noexcept;
+
+  /**
+   * Subtracts a * b from dst without creating the product as a separate
+   * bigint.
+   * @param dst The bigint to update, which may be a or b.
+   * @param a The first factor.
+   * @param b The second factor.
+   */
+  static void submul(bigint &dst, const bigint &a, const bigint &b) noexcept;
+
+  /**
+   * Multiplies the elements of a range as a balanced product tree, so that
+   * the factors of each multiplication have similar sizes and the fast
+   * algorithms apply. Elements may be bigints or integers.
+   * @param r The range to multiply.
+   * @return The product, which is 1 for an empty range.
+   * @throws Whatever converting an element to bigint throws.
+   */
+  template <std::ranges::input_range R>
+    requires std::constructible_from<bigint, std::ranges::range_reference_t<R>>
+  static bigint product(R &&r) noexcept(false);
+
+  /**
+   * Multiplies the elements of a range as a balanced product tree, reducing
+   * independent subtrees in parallel unless policy is std::execution::seq.
+   * The subtrees run on up to bigint::parallel.threads threads, or on one per
+   * hardware thread when that is 1.
+   * @param policy The execution policy.
+   * @param r The range to multiply.
+   * @return The product, which is 1 for an empty range.
+   * @throws Whatever converting an element to bigint throws.
+   */
+  template <typename P, std::ranges::input_range R>
+    requires std::is_execution_policy_v<std::remove_cvref_t<P>> &&
+             std::constructible_from<bigint, std::ranges::range_reference_t<R>>
+  static bigint product(P &&policy, R &&r) noexcept(false);
+
+  /**
+   * Adds the elements of a range in pairs, as a balanced tree.
+   * @param r The range to add.
+   * @return The sum, which is 0 for an empty range.
+   * @throws Whatever converting an element to bigint throws.
+   */
+  template <std::ranges::input_range R>
+    requires std::constructible_from<bigint, std::ranges::range_reference_t<R>>
+  static bigint sum(R &&r) noexcept(false);
+
+  /**
+   * Adds the elements of a range in pairs, reducing independent subtrees in
+   * parallel unless policy is std::execution::seq, with the threads chosen as
+   * for product.
+   * @param policy The execution policy.
+   * @param r The range to add.
+   * @return The sum, which is 0 for an empty range.
+   * @throws Whatever converting an element to bigint throws.
+   */
+  template <typename P, std::ranges::input_range R>
+    requires std::is_execution_policy_v<std::remove_cvref_t<P>> &&
+             std::constructible_from<bigint, std::ranges::range_reference_t<R>>
+  static bigint sum(P &&policy, R &&r) noexcept(false);
+
+  /**
+   * Computes n! by the prime-swing recursion n! = (n/2)!^2 swing(n), where
+   * the swing is assembled from its prime factorization with a product tree.
+   * @param n The argument.
+   * @return n factorial.
+   */
+  static bigint factorial(std::uint32_t n) noexcept;
+
+  /**
+   * Computes the binomial coefficient from its prime factorization, or for
+   * k much smaller than n as a product of k factors divided by k!.
+   * @param n The number of elements.
+   * @param k The size of the subsets.
+   * @return n choose k, which is 0 for k > n.
+   */
+  static bigint binomial(std::uint64_t n, std::uint64_t k) noexcept;
+
+  /**
+   * Multiplies the primes up to n with a product tree.
+   * @param n The bound.
+   * @return The product of all primes p <= n, which is 1 for n < 2.
+   */
+  static bigint primorial(std::uint32_t n) noexcept;
+
+  /**
+   * Evaluates a lazy expression built with bigint_expr::lazy, adding each of
+   * its terms into the new bigint with no intermediate results.
+   * @param e The expression to evaluate.
+   */
+  template <std::size_t N>
+  bigint(const bigint_expr::sum<N> &e) noexcept;
+
+  /**
+   * Evaluates a lazy expression into this bigint, reusing its storage.
+   * @param e The expression to evaluate, which may refer to this bigint.
+   * @return A reference to the updated bigint.
+   */
+  template <std::size_t N>
+  bigint &operator=(const bigint_expr::sum<N> &e) noexcept;
+
+  /**
+   * Adds each term of a lazy expression to this bigint in-place.
+   * @param e The expression to add, which may refer to this bigint.
+   * @return A reference to the updated bigint.
+   */
+  template <std::size_t N>
+  const bigint &operator+=(const bigint_expr::sum<N> &e) noexcept;
+
+  /**
+   * Subtracts each term of a lazy expression from this bigint in-place.
+   * @param e The expression to subtract, which may refer to this bigint.
+   * @return A reference to the updated bigint.
+   */
+  template <std::size_t N>
+  const bigint &operator-=(const bigint_expr::sum<N> &e) noexcept;
+
+  /**
+   * Divides the bigint by a single WORD, truncating towards zero.
+   * @param b The WORD to divide by.
+   * @return A new bigint representing the quotient.
+   * @throws std::domain_error if b is 0.
+   */
+  [[nodiscard]]
+  bigint operator/(WORD b) const noexcept(false);
+
+  /**
+   * Divides the bigint by a single WORD in-place, truncating towards zero.
+   * @param b The WORD to divide by.
+   * @return A reference to the updated bigint.
+   * @throws std::domain_error if b is 0.
+   */
+  const bigint &operator/=(WORD b) noexcept(false);
+
+  /**
+   * Computes the remainder of the bigint divided by a single WORD. The
+   * remainder takes the sign of this bigint.
+   * @param b The WORD to divide by.
+   * @return A new bigint representing the remainder.
+   * @throws std::domain_error if b is 0.
+   */
+  [[nodiscard]]
+  bigint operator%(WORD b) const noexcept(false);
+
+  /**
+   * Replaces the bigint by its remainder when divided by a single WORD.
+   * @param b The WORD to divide by.
+   * @return A reference to the updated bigint.
+   * @throws std::domain_error if b is 0.
+   */
+  const bigint &operator%=(WORD b) noexcept(false);
+
+  /**
+   * Adds a built-in integer of up to 64 bits, working on the limbs directly
+   * rather than converting b to a bigint first. The same holds for the other
+   * operators taking a built-in integer.
+   * @param b The integer to add.
+   * @return A new bigint representing the result.
+   */
+  template <bigint_detail::small_integer T>
+  [[nodiscard]]
+  bigint operator+(T b) const noexcept;
+
+  /**
+   * Adds a built-in integer in-place.
+   * @param b The integer to add.
+   * @return A reference to the updated bigint.
+   */
+  template <bigint_detail::small_integer T>
+  const bigint &operator+=(T b) noexcept;
+
+  /**
+   * Subtracts a built-in integer.
+   * @param b The integer to subtract.
+   * @return A new bigint representing the result.
+   */
+  template <bigint_detail::small_integer T>
+  [[nodiscard]]
+  bigint operator-(T b) const noexcept;
+
+  /**
+   * Subtracts a built-in integer in-place.
+   * @param b The integer to subtract.
+   * @return A reference to the updated bigint.
+   */
+  template <bigint_detail::small_integer T>
+  const bigint &operator-=(T b) noexcept;
+
+  /**
+   * Multiplies by a built-in integer.
+   * @param b The integer to multiply with.
+   * @return A new bigint representing the result.
+   */
+  template <bigint_detail::small_integer T>
+  [[nodiscard]]
+  bigint operator*(T b) const noexcept;
+
+  /**
+   * Multiplies by a built-in integer in-place.
+   * @param b The integer to multiply with.
+   * @return A reference to the updated bigint.
+   */
+  template <bigint_detail::small_integer T>
+  const bigint &operator*=(T b) noexcept;
+
+  /**
+   * Divides by a built-in integer, truncating towards zero.
+   * @param b The integer to divide by.
+   * @return A new bigint representing the quotient.
+   * @throws std::domain_error if b is 0.
+   */
+  template <bigint_detail::small_integer T>
+  [[nodiscard]]
+  bigint operator/(T b) const noexcept(false);
+
+  /**
+   * Divides by a built-in integer in-place, truncating towards zero.
+   * @param b The integer to divide by.
+   * @return A reference to the updated bigint.
+   * @throws std::domain_error if b is 0.
+   */
+  template <bigint_detail::small_integer T>
+  const bigint &operator/=(T b) noexcept(false);
+
+  /**
+   * Computes the remainder of the division by a built-in integer, which
+   * takes the sign of this bigint.
+   * @param b The integer to divide by.
+   * @return A new bigint representing the remainder.
+   * @throws std::domain_error if b is 0.
+   */
+  template <bigint_detail::small_integer T>
+  [[nodiscard]]
+  bigint operator%(T b) const noexcept(false);
+
+  /**
+   * Replaces the bigint by its remainder when divided by a built-in integer.
+   * @param b The integer to divide by.
+   * @return A reference to the updated bigint.
+   * @throws std::domain_error if b is 0.
+   */
+  template <bigint_detail::small_integer T>
+  const bigint &operator%=(T b) noexcept(false);
+
+  /**
+   * Divides this bigint by another bigint, truncating towards zero.
+   * @param b The bigint to divide by.
+   * @return A new bigint representing the quotient.
+   * @throws std::domain_error if b is 0.
+   */
+  [[nodiscard]]
+  bigint operator/(const bigint &b) const noexcept(false);
+
+  /**
+   * Divides this bigint by another bigint in-place, truncating towards zero.
+   * @param b The bigint to divide by.
+   * @return A reference to the updated bigint.
+   * @throws std::domain_error if b is 0.
+   */
+  const bigint &operator/=(const bigint &b) noexcept(false);
+
+  /**
+   * Computes the remainder of this bigint divided by another bigint. The
+   * remainder takes the sign of this bigint, so that
+   * (a / b) * b + a % b == a.
+   * @param b The bigint to divide by.
+   * @return A new bigint representing the remainder.
+   * @throws std::domain_error if b is 0.
+   */
+  [[nodiscard]]
+  bigint operator%(const bigint &b) const noexcept(false);
+
+  /**
+   * Replaces this bigint by its remainder when divided by another bigint.
+   * @param b The bigint to divide by.
+   * @return A reference to the updated bigint.
+   * @throws std::domain_error if b is 0.
+   */
+  const bigint &operator%=(const bigint &b) noexcept(false);
+
+  /**
+   * Computes the truncated quotient and the remainder in one division.
+   * @param a The dividend.
+   * @param b The divisor.
+   * @return The pair (a / b, a % b).
+   * @throws std::domain_error if b is 0.
+   */
+  friend std::pair<bigint, bigint> divmod(const bigint &a,
+                                          const bigint &b) noexcept(false);
+
+  /**
+   * Raises a bigint to a power by repeated squaring.
+   * @param base The base.
+   * @param exp The exponent.
+   * @return base to the power exp, where any base to the power 0 is 1.
+   */
+  friend bigint pow(const bigint &base, std::uint64_t exp) noexcept;
+
+  /**
+   * Computes base^exp mod |mod| by sliding-window exponentiation, using
+   * Montgomery multiplication when mod is odd. To raise many values modulo
+   * the same odd number, a montgomery_context saves redoing its setup.
+   * @param base The base, which may be negative.
+   * @param exp The exponent.
+   * @param mod The modulus.
+   * @return The result, in [0, |mod|).
+   * @throws std::domain_error if mod is 0 or exp is negative.
+   */
+  friend bigint powmod(const bigint &base, const bigint &exp,
+                       const bigint &mod) noexcept(false);
+
+  friend class montgomery_context;
+  friend class bigint_view;
+  template <std::size_t Bits> friend class fixed_bigint;
+  friend class bigint_batch;
+  friend class bigint_operation;
+
+  /**
+   * @return The number of bytes serialize writes for this value.
+   */
+  [[nodiscard]]
+  std::size_t serialized_size() const noexcept;
+
+  /**
+   * Writes the value in the binary format of bigint_view: an 8-byte
+   * little-endian header holding 2 n + s for n limbs and the sign bit s,
+   * followed by the n limbs as little-endian 32-bit words, least significant
+   * first. Zero has no limbs, and the top limb of any other value is not 0.
+   * @param out The buffer, of at least serialized_size() bytes.
+   * @return The number of bytes written.
+   * @throws std::length_error if out is too small.
+   */
+  std::size_t serialize(std::span<std::byte> out) const noexcept(false);
+
+  /**
+   * Reads a value written by serialize from the start of a buffer. The size
+   * of the record is serialized_size() of the result.
+   * @param in The buffer.
+   * @return The value.
+   * @throws std::invalid_argument if the buffer is truncated or the record is
+   * not in canonical form.
+   */
+  static bigint deserialize(std::span<const std::byte> in) noexcept(false);
+
+  /**
+   * Constructs a non-negative bigint from an array of words, like GMP's
+   * mpz_import. The nail bits of each word are ignored.
+   * @param in The words, a whole number of them.
+   * @param layout The layout of the words.
+   * @return The value.
+   * @throws std::invalid_argument if the layout has no value bits or in is
+   * not a whole number of words.
+   */
+  static bigint import_bytes(std::span<const std::byte> in,
+                             const bigint_layout &layout = {}) noexcept(false);
+
+  /**
+   * @param layout The layout of the words.
+   * @return The number of bytes export_bytes writes for |*this|, which is 0
+   * for the value 0.
+   * @throws std::invalid_argument if the layout has no value bits.
+   */
+  [[nodiscard]]
+  std::size_t export_size(const bigint_layout &layout = {}) const noexcept(false);
+
+  /**
+   * Writes |*this| as the fewest words that hold it, like GMP's mpz_export.
+   * The sign is not written.
+   * @param out The buffer, of at least export_size(layout) bytes.
+   * @param layout The layout of the words.
+   * @return The number of bytes written.
+   * @throws std::invalid_argument if the layout has no value bits.
+   * @throws std::length_error if out is too small.
+   */
+  std::size_t export_bytes(std::span<std::byte> out,
+                           const bigint_layout &layout = {}) const noexcept(false);
+
+  /**
+   * Computes the greatest common divisor, by Lehmer's algorithm for moderate
+   * sizes and by a recursive half-gcd for large operands.
+   * @param a The first operand.
+   * @param b The second operand.
+   * @return gcd(|a|, |b|), which is 0 only when both are 0.
+   */
+  friend bigint gcd(const bigint &a, const bigint &b) noexcept;
+
+  /**
+   * Computes the least common multiple.
+   * @param a The first operand.
+   * @param b The second operand.
+   * @return lcm(|a|, |b|), which is 0 when either is 0.
+   */
+  friend bigint lcm(const bigint &a, const bigint &b) noexcept;
+
+  /**
+   * Computes the greatest common divisor g with Bezout coefficients x and y
+   * such that a x + b y = g.
+   * @param a The first operand.
+   * @param b The second operand.
+   * @return The tuple (g, x, y) with g = gcd(|a|, |b|) and, when b != 0,
+   * 0 <= x < |b| / g.
+   */
+  friend std::tuple<bigint, bigint, bigint>
+  extended_gcd(const bigint &a, const bigint &b) noexcept;
+
+  /**
+   * Computes the inverse of a modulo m.
+   * @param a The value to invert.
+   * @param m The modulus.
+   * @return The x in [0, |m|) with a x = 1 mod m.
+   * @throws std::domain_error if m is 0 or gcd(a, m) != 1.
+   */
+  friend bigint mod_inverse(const bigint &a, const bigint &m) noexcept(false);
+
+  /**
+   * Computes the integer square root by Newton iteration, with the starting
+   * value taken from the square root of the leading half.
+   * @param a The radicand.
+   * @return The largest r with r^2 <= a.
+   * @throws std::domain_error if a is negative.
+   */
+  friend bigint isqrt(const bigint &a) noexcept(false);
+
+  /**
+   * Computes the integer k-th root by Newton iteration, with the starting
+   * value taken from the root of the leading bits.
+   * @param a The radicand, which may be negative when k is odd.
+   * @param k The degree of the root.
+   * @return The k-th root of a rounded toward zero.
+   * @throws std::domain_error if k is 0, or if a is negative and k is even.
+   */
+  friend bigint iroot(const bigint &a, std::uint64_t k) noexcept(false);
+
+  /**
+   * Tests whether a bigint is a square. Most non-squares are rejected by
+   * their residues modulo 64, 255 and 257 without taking a root.
+   * @param a The value to test.
+   * @return Whether a = r^2 for some integer r.
+   */
+  friend bool is_perfect_square(const bigint &a) noexcept;
+
+  /**
+   * Tests whether a bigint is a perfect power, trying the prime exponents
+   * that its bit length and trailing zeros allow.
+   * @param a The value to test.
+   * @return Whether a = r^k for some integers r and k >= 2. This includes 0,
+   * 1 and -1.
+   */
+  friend bool is_perfect_power(const bigint &a) noexcept;
+
+  /**
+   * Computes the negation of this bigint.
+   * @return A new bigint representing the negated value.
+   */
+  [[nodiscard]]
+  bigint operator-() const & noexcept;
+
+  /**
+   * Negates this temporary bigint in place.
+   * @return The negated bigint.
+   */
+  [[nodiscard]]
+  bigint operator-() && noexcept;
+
+  /**
+   * Checks equality between two bigints.
+   * @param b The bigint to compare with.
+   * @return True if the two bigints are equal, false otherwise.
+   */
+  [[nodiscard]]
+  bool operator==(const bigint &b) const noexcept;
+
+  /**
+   * Checks inequality between two bigints.
+   * @param b The bigint to compare with.
+   * @return True if the two bigints are not equal, false otherwise.
+   */
+  [[nodiscard]]
+  bool operator!=(const bigint &b) const noexcept;
+
+  /**
+   * Checks if this bigint is less than another bigint.
+   * @param b The bigint to compare with.
+   * @return True if this bigint is less than the given bigint, false otherwise.
+   */
+  [[nodiscard]]
+  bool operator<(const bigint &b) const noexcept;
+
+  /**
+   * Checks if this bigint is greater than another bigint.
+   * @param b The bigint to compare with.
+   * @return True if this bigint is greater than the given bigint, false
+   * otherwise.
+   */
+  [[nodiscard]]
+  bool operator>(const bigint &b) const noexcept;
+
+  /**
+   * Checks if this bigint is less than or equal to another bigint.
+   * @param b The bigint to compare with.
+   * @return True if this bigint is less than or equal to the given bigint,
+   * false otherwise.
+   */
+  [[nodiscard]]
+  bool operator<=(const bigint &b) const noexcept;
+
+  /**
+   * Checks if this bigint is greater than or equal to another bigint.
+   * @param b The bigint to compare with.
+   * @return True if this bigint is greater than or equal to the given bigint,
+   * false otherwise.
+   */
+  [[nodiscard]]
+  bool operator>=(const bigint &b) const noexcept;
+
+  /**
+   * Compares two bigints in a single pass over the limbs.
+   * @param b The bigint to compare with.
+   * @return The ordering of this bigint relative to b.
+   */
+  [[nodiscard]]
+  std::strong_ordering operator<=>(const bigint &b) const noexcept;
+
+  /**
+   * Checks equality with a built-in integer.
+   * @param b The integer to compare with.
+   * @return True if the values are equal, false otherwise.
+   */
+  template <bigint_detail::small_integer T>
+  [[nodiscard]]
+  bool operator==(T b) const noexcept;
+
+  /**
+   * Compares with a built-in integer, which also provides <, >, <= and >=
+   * with the integer on either side.
+   * @param b The integer to compare with.
+   * @return The ordering of this bigint relative to b.
+   */
+  template <bigint_detail::small_integer T>
+  [[nodiscard]]
+  std::strong_ordering operator<=>(T b) const noexcept;
+
+  /**
+   * Prefix increment operator.
+   * @return A reference to the updated bigint.
+   */
+  [[nodiscard]]
+  const bigint &operator++() noexcept;
+
+  /**
+   * Postfix increment operator.
+   * @return A new bigint representing the value before the increment.
+   */
+  [[nodiscard]]
+  bigint operator++(int) noexcept;
+
+  /**
+   * Prefix decrement operator.
+   * @return A reference to the updated bigint.
+   */
+  [[nodiscard]]
+  const bigint &operator--() noexcept;
+
+  /**
+   * Postfix decrement operator.
+   * @return A new bigint representing the value before the decrement.
+   */
+  [[nodiscard]]
+  bigint operator--(int) noexcept;
+
+  /**
+   * Shifts the bigint left, multiplying it by 2^n.
+   * @param n The number of bits to shift by.
+   * @return A new bigint representing the result.
+   */
+  [[nodiscard]]
+  bigint operator<<(std::size_t n) const noexcept;
+
+  /**
+   * Shifts the bigint left in-place, multiplying it by 2^n.
+   * @param n The number of bits to shift by.
+   * @return A reference to the updated bigint.
+   */
+  const bigint &operator<<=(std::size_t n) noexcept;
+
+  /**
+   * Shifts the bigint right arithmetically, dividing it by 2^n and rounding
+   * towards negative infinity like a two's complement shift would.
+   * @param n The number of bits to shift by.
+   * @return A new bigint representing the result.
+   */
+  [[nodiscard]]
+  bigint operator>>(std::size_t n) const noexcept;
+
+  /**
+   * Shifts the bigint right arithmetically in-place.
+   * @param n The number of bits to shift by.
+   * @return A reference to the updated bigint.
+   */
+  const bigint &operator>>=(std::size_t n) noexcept;
+
+  /**
+   * Bitwise and. Negative values behave as infinitely sign-extended two's
+   * complement numbers, as in Python and GMP, and so do |, ^ and ~.
+   * @param b The bigint to combine with.
+   * @return A new bigint representing the result.
+   */
+  [[nodiscard]]
+  bigint operator&(const bigint &b) const noexcept;
+
+  /**
+   * Bitwise and in-place.
+   * @param b The bigint to combine with.
+   * @return A reference to the updated bigint.
+   */
+  const bigint &operator&=(const bigint &b) noexcept;
+
+  /**
+   * Bitwise or.
+   * @param b The bigint to combine with.
+   * @return A new bigint representing the result.
+   */
+  [[nodiscard]]
+  bigint operator|(const bigint &b) const noexcept;
+
+  /**
+   * Bitwise or in-place.
+   * @param b The bigint to combine with.
+   * @return A reference to the updated bigint.
+   */
+  const bigint &operator|=(const bigint &b) noexcept;
+
+  /**
+   * Bitwise exclusive or.
+   * @param b The bigint to combine with.
+   * @return A new bigint representing the result.
+   */
+  [[nodiscard]]
+  bigint operator^(const bigint &b) const noexcept;
+
+  /**
+   * Bitwise exclusive or in-place.
+   * @param b The bigint to combine with.
+   * @return A reference to the updated bigint.
+   */
+  const bigint &operator^=(const bigint &b) noexcept;
+
+  /**
+   * Bitwise complement, which equals -x - 1.
+   * @return A new bigint representing the result.
+   */
+  [[nodiscard]]
+  bigint operator~() const noexcept;
+
+  /**
+   * @return The number of one bits in |x|.
+   */
+  [[nodiscard]]
+  std::size_t popcount() const noexcept;
+
+  /**
+   * @return The number of bits needed to represent |x|, 0 for 0.
+   */
+  [[nodiscard]]
+  std::size_t bit_length() const noexcept;
+
+  /**
+   * Tests a bit of the two's complement representation, so that the bits of a
+   * negative value are eventually all set.
+   * @param i The index of the bit, 0 for the least significant.
+   * @return Whether the bit is set.
+   */
+  [[nodiscard]]
+  bool test_bit(std::size_t i) const noexcept;
+
+  /**
+   * @return The number of trailing zero bits, the index of the lowest set
+   * bit, or 0 for 0.
+   */
+  [[nodiscard]]
+  std::size_t countr_zero() const noexcept;
+
+  /**
+   * Outputs the bigint to the given output stream.
+   * @param os The output stream.
+   * @param a The bigint to output.
+   * @return The output stream.
+   */
+  friend std::ostream &operator<<(std::ostream &os, const bigint &a) noexcept;
+
+  /**
+   * Converts the bigint to a string in the given base. Digits above 9 are
+   * written as lowercase letters.
+   * @param base The base, between 2 and 36.
+   * @return The string representation.
+   * @throws std::invalid_argument if base is out of range.
+   */
+  [[nodiscard]]
+  std::string to_string(int base = 10) const noexcept(false);
+
+  /**
+   * Writes the bigint into [first, last) in the given base, without a
+   * terminating null character, like std::to_chars.
+   * @param first The start of the output buffer.
+   * @param last The end of the output buffer.
+   * @param base The base, between 2 and 36.
+   * @return {end of the written characters, std::errc{}} on success,
+   * {last, std::errc::value_too_large} if the buffer is too small and
+   * {first, std::errc::invalid_argument} if base is out of range.
+   */
+  std::to_chars_result to_chars(char *first, char *last,
+                                int base = 10) const noexcept;
+
+  /**
+   * Operand sizes, in limbs, at which multiplication switches algorithm.
+   * Products whose smaller operand has fewer than `karatsuba` limbs use the
+   * schoolbook method, those below `toom3` use Karatsuba, those below `ntt`
+   * use Toom-3 and larger ones use a three-prime number-theoretic transform.
+   * Karatsuba is never used below 4 limbs. The best values depend on the
+   * machine; see tune.cpp.
+   */
+  struct mul_thresholds {
+    std::size_t karatsuba;
+    std::size_t toom3;
+    std::size_t ntt;
+  };
+  static inline mul_thresholds thresholds{24, 400, 5000};
+
+  /**
+   * Multithreading of large multiplications. Products whose smaller operand
+   * has at least `min_limbs` limbs run their sub-products, or the transforms
+   * of the NTT, on up to `threads` threads, including the calling one, and
+   * smaller products stay on the calling thread without any
+   * synchronization. The workers are shared by all threads and started on
+   * first use. The default of one thread disables the parallel path. The
+   * settings should not change while a multiplication is running.
+   */
+  struct parallel_config {
+    std::size_t threads;
+    std::size_t min_limbs;
+  };
+  static inline parallel_config parallel{1, 2000};
+
+  /**
+   * Divisor size, in limbs, from which division recurses with the
+   * Burnikel-Ziegler algorithm instead of running Knuth's algorithm D on the
+   * whole operands.
+   */
+  static inline std::size_t div_threshold = 48;
+
+  /**
+   * Size, in limbs, from which gcd and its relatives reduce the operands with
+   * a recursive half-gcd on their leading bits instead of Lehmer's algorithm.
+   * Values below 2 are treated as 2.
+   */
+  static inline std::size_t gcd_threshold = 150;
+
+private:
+  static constexpr WORD WORD_MAX = std::numeric_limits<WORD>::max();
+  static constexpr unsigned WORD_BITS = bigint_detail::LIMB_BITS;
+
+  void val_plus(const bigint &b, std::size_t offset = 0) noexcept;
+  void val_monus(const bigint &b) noexcept;
+  void val_mult(const bigint &b) noexcept;
+  void val_divexact(WORD d) noexcept;
+  void val_rmonus(const bigint &b) noexcept;
+  void add_signed(const bigint &b, bool b_sign) noexcept;
+  void add_small(std::uint64_t m, bool m_sign) noexcept;
+  void mul_small(std::uint64_t m, bool m_sign) noexcept;
+  void div_small(std::uint64_t m, bool m_sign, bool remainder) noexcept(false);
+  [[nodiscard]]
+  std::strong_ordering cmp_small(std::uint64_t m, bool m_sign) const noexcept;
+  void addmul_signed(const bigint &a, const bigint &b, bool s) noexcept;
+  template <std::size_t N>
+  void add_expr(const bigint_expr::sum<N> &e, bool negate) noexcept;
+  [[nodiscard]]
+  bigint copy_with_capacity(std::size_t limbs) const noexcept;
+  void val_shl_limbs(std::size_t k) noexcept;
+  [[nodiscard]]
+  bigint_detail::limb_vector twos_complement(std::size_t n) const noexcept;
+  template <typename Op>
+  [[nodiscard]]
+  static bigint bitwise(const bigint &a, const bigint &b, Op op) noexcept;
+
+  struct gcd_matrix;
+  struct gcd_cofactors;
+  struct gcd_untracked;
+  [[nodiscard]]
+  std::uint64_t bits_at(std::size_t shift) const noexcept;
+  static void lehmer_comb(bigint_detail::limb_vector &r, const bigint &u,
+                          const bigint &v, std::int64_t x,
+                          std::int64_t y) noexcept;
+  template <typename Track>
+  static void gcd_division_step(bigint &a, bigint &b, Track &track) noexcept;
+  template <typename Track>
+  static void gcd_lehmer(bigint &a, bigint &b, std::size_t s,
+                         Track &track) noexcept;
+  template <typename Track>
+  static void hgcd(bigint &a, bigint &b, Track &track) noexcept;
+  template <typename Track>
+  static void gcd_reduce(bigint &a, bigint &b, std::size_t s,
+                         Track &track) noexcept;
+  static std::pair<bigint, bigint> gcd_cofactor(const bigint &a,
+                                                const bigint &b) noexcept;
+  static bigint isqrt_abs(const bigint &a) noexcept;
+  static bigint iroot_abs(const bigint &a, std::uint64_t k) noexcept;
+  static void val_divmod(const bigint &a, const bigint &b, bigint &q,
+                         bigint &r) noexcept;
+  static void val_divmod_basecase(const bigint &a, const bigint &b, bigint &q,
+                                  bigint &r) noexcept;
+  static void bz_div2n1n(const bigint &a, const bigint &b, std::size_t n,
+                         bigint &q, bigint &r) noexcept;
+  static void bz_div3n2n(const bigint &a12, const bigint &a3, const bigint &b,
+                         const bigint &b1, const bigint &b2, std::size_t n,
+                         bigint &q, bigint &r) noexcept;
+  static bigint limb_slice(const bigint &x, std::size_t lo,
+                           std::size_t hi) noexcept;
+
+  // limbs above which radix conversion splits the value in two
+  static constexpr std::size_t RADIX_DC_LIMBS = 40;
+  [[nodiscard]]
+  std::size_t max_digits(int base) const noexcept;
+  static const bigint &radix_power(int base, std::size_t i) noexcept;
+  static bigint from_radix_chunks(const WORD *c, std::size_t m,
+                                  int base) noexcept;
+  static void write_radix(char *&out, const bigint &x, int base,
+                          std::size_t width) noexcept;
+  static void write_pow2(char *&out, const bigint &x, unsigned k) noexcept;
+
+  static bigint from_limbs(const WORD *a, std::size_t n) noexcept;
+  // the value bits per word of a layout
+  static std::size_t layout_bits(const bigint_layout &layout) noexcept(false);
+  static void mul_limbs(WORD *r, const WORD *a, std::size_t an, const WORD *b,
+                        std::size_t bn) noexcept;
+  [[nodiscard]]
+  static std::size_t mul_threads(std::size_t bn) noexcept;
+  template <typename P>
+  [[nodiscard]]
+  static std::size_t policy_threads(const P &policy) noexcept;
+  template <typename E>
+  [[nodiscard]]
+  static bigint from_element(E &&e) noexcept(false);
+  template <typename R, typename Tree>
+  static bigint reduce_range(R &&r, std::size_t threads, Tree tree) noexcept(false);
+  static bigint product_tree(const bigint *x, std::size_t n,
+                             std::size_t threads) noexcept;
+  static bigint sum_tree(const bigint *x, std::size_t n,
+                         std::size_t threads) noexcept;
+  static bigint word_product(const std::uint64_t *f, std::size_t n) noexcept;
+  static bigint odd_factorial(std::uint32_t n,
+                              const std::vector<WORD> &primes) noexcept;
+  static void mul_karatsuba(WORD *r, const WORD *a, std::size_t an,
+                            const WORD *b, std::size_t bn) noexcept;
+  static void mul_toom3(WORD *r, const WORD *a, std::size_t an, const WORD *b,
+                        std::size_t bn) noexcept;
+
+  [[nodiscard]]
+  bool val_less(const bigint &b) const noexcept;
+  [[nodiscard]]
+  bool val_more(const bigint &b) const noexcept;
+  [[nodiscard]]
+  bool is_zero() const noexcept;
+  void trim() noexcept;
+};
+
+/**
+ * Adds a bigint to a built-in integer.
+ * @param a The integer.
+ * @param b The bigint.
+ * @return A new bigint representing the result.
+ */
+template <bigint_detail::small_integer T>
+[[nodiscard]]
+bigint operator+(const T a, bigint b) noexcept {
+  b += a;
+  return b;
+}
+
+/**
+ * Subtracts a bigint from a built-in integer.
+ * @param a The integer.
+ * @param b The bigint.
+ * @return A new bigint representing the result.
+ */
+template <bigint_detail::small_integer T>
+[[nodiscard]]
+bigint operator-(const T a, bigint b) noexcept {
+  b -= a;
+  return -std::move(b);
+}
+
+/**
+ * Multiplies a built-in integer by a bigint.
+ * @param a The integer.
+ * @param b The bigint.
+ * @return A new bigint representing the result.
+ */
+template <bigint_detail::small_integer T>
+[[nodiscard]]
+bigint operator*(const T a, bigint b) noexcept {
+  b *= a;
+  return b;
+}
+
+/**
+ * A read-only reference to the limbs of an integer owned elsewhere: a bigint,
+ * or a record in the serialize format inside a buffer such as a memory
+ * mapped file. Comparisons and +, - and * read the limbs in place, and a
+ * bigint converts to a view implicitly, so both can be mixed. Like
+ * std::string_view, a view must not outlive the storage it refers to.
+ */
+class bigint_view {
+  using WORD = bigint_detail::limb;
+
+public:
+  /**
+   * Views the value 0.
+   */
+  constexpr bigint_view() noexcept = default;
+
+  /**
+   * Views the limbs of a bigint, until it is next modified.
+   * @param x The bigint.
+   */
+  bigint_view(const bigint &x) noexcept;
+
+  /**
+   * Views a serialized record in place. The buffer must be aligned to 4
+   * bytes, as consecutive records are when the first one is, and the host
+   * must be little-endian.
+   * @param in The buffer, starting with the record.
+   * @return The view.
+   * @throws std::invalid_argument if the buffer is truncated or misaligned,
+   * the record is not in canonical form, or the host is not little-endian.
+   */
+  static bigint_view deserialize(std::span<const std::byte> in) noexcept(false);
+
+  /**
+   * @return The magnitude, least significant limb first and empty for 0.
+   */
+  [[nodiscard]]
+  std::span<const WORD> limbs() const noexcept {
+    return {limbs_, size_};
+  }
+
+  /**
+   * @return Whether the value is negative.
+   */
+  [[nodiscard]]
+  bool is_negative() const noexcept {
+    return sign_;
+  }
+
+  /**
+   * @return The number of bytes the record takes, which is also where the
+   * next record of a buffer starts.
+   */
+  [[nodiscard]]
+  std::size_t serialized_size() const noexcept {
+    return HEADER + size_ * sizeof(WORD);
+  }
+
+  /**
+   * Writes the value in the format described at bigint::serialize.
+   * @param out The buffer, of at least serialized_size() bytes.
+   * @return The number of bytes written.
+   * @throws std::length_error if out is too small.
+   */
+  std::size_t serialize(std::span<std::byte> out) const noexcept(false);
+
+  /**
+   * Converts the value to a string.
+   * @param base The base, between 2 and 36.
+   * @return The digits, preceded by '-' for a negative value.
+   * @throws std::invalid_argument if the base is out of range.
+   */
+  [[nodiscard]]
+  std::string to_string(int base = 10) const noexcept(false) {
+    return bigint(*this).to_string(base);
+  }
+
+  /**
+   * Compares the values of two views.
+   * @param a The first view.
+   * @param b The second view.
+   * @return Whether they are equal.
+   */
+  friend bool operator==(bigint_view a, bigint_view b) noexcept;
+
+  /**
+   * Orders the values of two views.
+   * @param a The first view.
+   * @param b The second view.
+   * @return The ordering of a relative to b.
+   */
+  friend std::strong_ordering operator<=>(bigint_view a, bigint_view b) noexcept;
+
+  /**
+   * Adds the values of two views.
+   * @param a The first summand.
+   * @param b The second summand.
+   * @return a + b.
+   */
+  friend bigint operator+(bigint_view a, bigint_view b) noexcept;
+
+  /**
+   * Subtracts the values of two views.
+   * @param a The minuend.
+   * @param b The subtrahend.
+   * @return a - b.
+   */
+  friend bigint operator-(bigint_view a, bigint_view b) noexcept;
+
+  /**
+   * Multiplies the values of two views.
+   * @param a The first factor.
+   * @param b The second factor.
+   * @return a * b.
+   */
+  friend bigint operator*(bigint_view a, bigint_view b) noexcept;
+
+  friend class bigint;
+
+private:
+  static constexpr std::size_t HEADER = 8;
+
+  const WORD *limbs_ = nullptr;
+  std::size_t size_ = 0;
+  bool sign_ = false;
+
+  constexpr bigint_view(const WORD *limbs, std::size_t n, bool neg) noexcept
+      : limbs_(limbs), size_(n), sign_(neg) {}
+
+  static std::size_t read_header(std::span<const std::byte> in, bool &neg) noexcept(false);
+  static int cmp_abs(bigint_view a, bigint_view b) noexcept;
+  static bigint add_signed(bigint_view a, bigint_view b, bool b_sign) noexcept;
+  static bigint multiply(bigint_view a, bigint_view b) noexcept;
+};
+
+inline bigint::bigint(int64_t n) noexcept : sign(n < 0) {
+  // negate in unsigned arithmetic so that INT64_MIN is well defined
+  std::uint64_t m = sign ? 0 - static_cast<std::uint64_t>(n)
+                         : static_cast<std::uint64_t>(n);
+  do {
+    val.push_back(static_cast<WORD>(m));
+    m >>= WORD_BITS;
+  } while (m);
+}
+
+inline bigint::bigint(std::string_view sv, int base) noexcept(false)
+    : bigint() {
+  bigint_detail::count(bigint_detail::stat::parse_calls);
+  bigint_detail::count(bigint_detail::stat::parse_chars, sv.size());
+  const char *const last = sv.data() + sv.size();
+  const auto [ptr, ec] = from_chars(sv.data(), last, *this, base);
+  if (ec == std::errc{} && ptr == last)
+    return;
+  if (base < 2 || base > 36)
+    throw std::invalid_argument("base must be between 2 and 36");
+  const char *bad = ptr;
+  if (ec != std::errc{} && bad != last && *bad == '-')
+    bad++;
+  if (bad == last)
+    throw std::invalid_argument("no digits found");
+  const std::string ch = "\"" + std::string{*bad} + "\"";
+  if (bigint_detail::DIGIT_VALUE[static_cast<unsigned char>(*bad)] != 0xff)
+    throw std::invalid_argument("invalid character " + ch +
+                                " used for integer of base " +
+                                std::to_string(base));
+  throw std::invalid_argument("invalid character " + ch + " found");
+}
+
+inline std::from_chars_result bigint::from_chars(const char *first,
+                                                 const char *last,
+                                                 bigint &value,
+                                                 const int base) noexcept {
+  if (base < 2 || base > 36)
+    return {first, std::errc::invalid_argument};
+  const char *p = first;
+  const bool neg = p != last && *p == '-';
+  if (neg)
+    p++;
+  const char *const digits = p;
+
+  if (std::has_single_bit(static_cast<unsigned>(base))) {
+    // digits are bit fields of the limbs
+    const auto k = static_cast<unsigned>(std::countr_zero(static_cast<unsigned>(base)));
+    if (k == 4) {
+      p = bigint_detail::hex_span(p, last);
+    } else {
+      while (p != last &&
+             bigint_detail::DIGIT_VALUE[static_cast<unsigned char>(*p)] < base)
+        p++;
+    }
+    if (p == digits)
+      return {first, std::errc::invalid_argument};
+    const auto len = static_cast<std::size_t>(p - digits);
+    bigint res;
+    res.val.resize((len * k + WORD_BITS - 1) / WORD_BITS);
+    if (k == 4)
+      bigint_detail::hex_to_limbs(res.val.data(), digits, len);
+    else
+      bigint_detail::pow2_to_limbs(res.val.data(), digits, len, k);
+    res.trim();
+    res.sign = neg && !res.is_zero();
+    value = std::move(res);
+    return {p, std::errc{}};
+  }
+
+  // validate and accumulate limb-sized chunks in the same pass
+  const auto chunk = bigint_detail::chunk_of(base);
+  const auto b = static_cast<WORD>(base);
+  std::vector<WORD> chunks;
+  chunks.reserve(static_cast<std::size_t>(last - p) / chunk.digits);
+  WORD cur = 0;
+  WORD cur_power = 1;
+  for (; p != last; p++) {
+    const WORD d = bigint_detail::DIGIT_VALUE[static_cast<unsigned char>(*p)];
+    if (d >= b)
+      break;
+    cur = cur * b + d;
+    cur_power *= b;
+    if (cur_power == chunk.power) {
+      chunks.push_back(cur);
+      cur = 0;
+      cur_power = 1;
+    }
+  }
+  if (p == digits)
+    return {first, std::errc::invalid_argument};
+
+  bigint res = from_radix_chunks(chunks.data(), chunks.size(), base);
+  if (cur_power > 1) {
+    res *= cur_power;
+    res += cur;
+  }
+  res.sign = neg && !res.is_zero();
+  value = std::move(res);
+  return {p, std::errc{}};
+}
+
+#ifdef DOCTEST_LIBRARY_INCLUDED
+TEST_CASE("[bigint] constructor") {
+  CHECK_NOTHROW(bigint _("111111111222222222"));
+  CHECK_NOTHROW(bigint _("1111111112222222223"));
+}
+
+TEST_CASE("[bigint] constructor long strings") {
+  // 10^2000 built by multiplication, parsed through the divide-and-conquer
+  // path with leading zeros and both signs
+  bigint p(1);
+  for (int i = 0; i < 2000; i++) {
+    p *= 10;
+  }
+  const std::string digits = "1" + std::string(2000, '0');
+  CHECK_EQ(bigint(digits), p);
+  CHECK_EQ(bigint("-000" + digits), -p);
+  CHECK_EQ(bigint(std::string(2001, '9')), p * 10 - bigint(1));
+  CHECK_EQ(bigint(std::string(3000, '0')), bigint(0));
+  CHECK_EQ(bigint("-" + std::string(3000, '0')), bigint(0));
+  CHECK_EQ(bigint("101", 2), bigint(5));
+  CHECK_EQ(bigint(std::string(64, '1'), 2), bigint("18446744073709551615"));
+}
+
+TEST_CASE("[bigint] spaces should throw invalid_argument") {
+  CHECK_THROWS_AS(bigint _(" 12"), std::invalid_argument);
+  CHECK_THROWS_AS(bigint _("   12"), std::invalid_argument);
+  CHECK_THROWS_AS(bigint _("12   "), std::invalid_argument);
+  CHECK_THROWS_AS(bigint _("1   2"), std::invalid_argument);
+  CHECK_THROWS_AS(bigint _(" 1  2"), std::invalid_argument);
+}
+
+TEST_CASE("[bigint] invalid \"-\" sign should throw invalid_argument") {
+  CHECK_THROWS_AS(bigint _("--12"), std::invalid_argument);
+  CHECK_THROWS_AS(bigint _("-1-2"), std::invalid_argument);
+  CHECK_THROWS_AS(bigint _("-12-"), std::invalid_argument);
+  CHECK_THROWS_AS(bigint _("12-"), std::invalid_argument);
+  CHECK_THROWS_AS(bigint _("12--"), std::invalid_argument);
+}
+
+TEST_CASE("[bigint] invalid character should throw invalid_argument") {
+  CHECK_THROWS_AS(bigint _("12?"), std::invalid_argument);
+  CHECK_THROWS_AS(bigint _("1?2"), std::invalid_argument);
+  CHECK_THROWS_AS(bigint _("?12"), std::invalid_argument);
+  CHECK_THROWS_AS(bigint _("*)?"), std::invalid_argument);
+  CHECK_THROWS_AS(bigint _("12a"), std::invalid_argument);
+  CHECK_THROWS_AS(bigint _("12", 40), std::invalid_argument);
+}
+
+TEST_CASE("[bigint] empty input should throw invalid_argument") {
+  CHECK_THROWS_AS(bigint _(""), std::invalid_argument);
+  CHECK_THROWS_AS(bigint _("-"), std::invalid_argument);
+}
+
+TEST_CASE("[bigint] constructor bases") {
+  CHECK_EQ(bigint("ff", 16), bigint(255));
+  CHECK_EQ(bigint("-FF", 16), bigint(-255));
+  CHECK_EQ(bigint("zz", 36), bigint(1295));
+  CHECK_EQ(bigint("777", 8), bigint(511));
+  CHECK_THROWS_AS(bigint _("8", 8), std::invalid_argument);
+  CHECK_THROWS_AS(bigint _("g", 16), std::invalid_argument);
+}
+
+TEST_CASE("[bigint] from_chars") {
+  bigint a(7);
+  std::string_view sv = "-12345xyz";
+  auto res = bigint::from_chars(sv.data(), sv.data() + sv.size(), a);
+  CHECK(res.ec == std::errc{});
+  CHECK_EQ(res.ptr, sv.data() + 6);
+  CHECK_EQ(a, bigint(-12345));
+
+  sv = "1234567891011121314151617181920";
+  res = bigint::from_chars(sv.data(), sv.data() + sv.size(), a);
+  CHECK(res.ec == std::errc{});
+  CHECK_EQ(res.ptr, sv.data() + sv.size());
+  CHECK_EQ(a, bigint(sv));
+
+  sv = "-0";
+  res = bigint::from_chars(sv.data(), sv.data() + sv.size(), a);
+  CHECK(res.ec == std::errc{});
+  CHECK_EQ(a, bigint());
+
+  // failures leave the value untouched
+  for (const std::string_view bad : {"", "-", "--1", " 1", "x"}) {
+    res = bigint::from_chars(bad.data(), bad.data() + bad.size(), a);
+    CHECK(res.ec == std::errc::invalid_argument);
+    CHECK_EQ(res.ptr, bad.data());
+    CHECK_EQ(a, bigint());
+  }
+  sv = "10";
+  res = bigint::from_chars(sv.data(), sv.data() + sv.size(), a, 1);
+  CHECK(res.ec == std::errc::invalid_argument);
+}
+#endif
+
+// addition operator
+
+inline bigint bigint::operator+(const WORD b) const noexcept {
+  bigint res = copy_with_capacity(val.size() + 1);
+  res += b;
+  return res;
+}
+
+inline const bigint &bigint::operator+=(const WORD b) noexcept {
+  add_small(b, false);
+  return *this;
+}
+
+inline bigint bigint::operator+(const bigint &b) const & noexcept {
+  // room for the carry, so the sum does not reallocate
+  bigint res = copy_with_capacity(std::max(val.size(), b.val.size()) + 1);
+  res += b;
+  return res;
+}
+
+inline bigint bigint::operator+(const bigint &b) && noexcept {
+  *this += b;
+  return std::move(*this);
+}
+
+inline bigint bigint::operator+(bigint &&b) const & noexcept {
+  b += *this;
+  return std::move(b);
+}
+
+inline bigint bigint::operator+(bigint &&b) && noexcept {
+  *this += b;
+  return std::move(*this);
+}
+
+inline const bigint &bigint::operator+=(const bigint &b) noexcept {
+  add_signed(b, b.sign);
+  return *this;
+}
+
+// *this += |b| with the sign b_sign, so that subtraction needs no negated
+// copy of b
+inline void bigint::add_signed(const bigint &b, const bool b_sign) noexcept {
+  if (b.is_zero())
+    return;
+  if (is_zero()) {
+    val = b.val;
+    sign = b_sign;
+  } else if (sign == b_sign) {
+    val_plus(b);
+  } else if (val_less(b)) {
+    val_rmonus(b);
+    sign = b_sign;
+  } else {
+    val_monus(b);
+    if (is_zero()) {
+      sign = false;
+    }
+  }
+}
+
+inline bigint bigint::copy_with_capacity(const std::size_t limbs) const noexcept {
+  bigint res;
+  res.val.reserve(limbs);
+  res.val.assign(val.begin(), val.end());
+  res.sign = sign;
+  return res;
+}
+
+#ifdef DOCTEST_LIBRARY_INCLUDED
+TEST_CASE("[bigint] additions") {
+  // Addition of zero
+  CHECK_EQ(bigint(0) + bigint(0), bigint(0));
+  CHECK_EQ(bigint(12345) + bigint(0), bigint(12345));
+  CHECK_EQ(bigint(0) + bigint(12345), bigint(12345));
+
+  // Positive number addition
+  CHECK_EQ(bigint(12345) + bigint(67890), bigint(80235));
+  CHECK_EQ(bigint(999999) + bigint(1), bigint(1000000));
+
+  // Negative number addition
+  CHECK_EQ(bigint(-12345) + bigint(-67890), bigint(-80235));
+  CHECK_EQ(bigint(-999999) + bigint(-1), bigint(-1000000));
+
+  // Mixed sign addition
+  CHECK_EQ(bigint(12345) + bigint(-67890), bigint(-55545));
+  CHECK_EQ(bigint(-12345) + bigint(67890), bigint(55545));
+  CHECK_EQ(bigint(67890) + bigint(-12345), bigint(55545));
+
+  // Addition resulting in zero
+  CHECK_EQ(bigint(12345) + bigint(-12345), bigint(0));
+  CHECK_EQ(bigint(-12345) + bigint(12345), bigint(0));
+
+  // Large number addition
+  CHECK_EQ(bigint("1234567891011121314151617181920") +
+               bigint("987654321098765432101234567890"),
+           bigint("2222222212109886746252851749810"));
+  CHECK_EQ(bigint("999999999999999999999999999999") + bigint("1"),
+           bigint("1000000000000000000000000000000"));
+}
+
+TEST_CASE("[bigint] addition across limb boundaries") {
+  CHECK_EQ(bigint(4294967295) + bigint(1), bigint(4294967296));
+  CHECK_EQ(bigint("18446744073709551615") + bigint(1),
+           bigint("18446744073709551616"));
+  CHECK_EQ(bigint("-18446744073709551616") + bigint(1),
+           bigint("-18446744073709551615"));
+  CHECK_EQ(bigint(INT64_MIN) + bigint(INT64_MAX), bigint(-1));
+  CHECK_EQ(bigint(INT64_MIN), bigint("-9223372036854775808"));
+}
+
+TEST_CASE("[bigint] addition chaining") {
+  CHECK_EQ(bigint(12345) + bigint(67890) + bigint(11111), bigint(91346));
+  CHECK_EQ(bigint(12345) + bigint(-12345) + bigint(67890), bigint(67890));
+  CHECK_EQ(bigint(12345) + bigint(0) + bigint(-12345), bigint(0));
+}
+
+TEST_CASE("[bigint] addition edge cases") {
+  CHECK_EQ(bigint("123456789123456789123456789") +
+               bigint("987654321987654321987654321"),
+           bigint("1111111111111111111111111110"));
+  CHECK_EQ(bigint("-123456789123456789123456789") +
+               bigint("987654321987654321987654321"),
+           bigint("864197532864197532864197532"));
+  CHECK_EQ(bigint("-1000000000000000000000000") + bigint(1),
+           bigint("-999999999999999999999999"));
+  CHECK_EQ(bigint("1000000000000000000000000") + bigint(-1),
+           bigint("999999999999999999999999"));
+}
+#endif
+
+// multiplication operator
+
+inline bigint bigint::operator*(const WORD b) const noexcept {
+  bigint res = copy_with_capacity(val.size() + 1);
+  res *= b;
+  return res;
+}
+
+inline const bigint &bigint::operator*=(const WORD b) noexcept {
+  if (is_zero())
+    return *this;
+  if (!b) {
+    val.clear();
+    val.push_back(0);
+    sign = false;
+    return *this;
+  }
+  const WORD carry =
+      bigint_detail::mul_1(val.data(), val.data(), val.size(), b);
+  if (carry > 0) {
+    val.push_back(carry);
+  }
+
+  return *this;
+}
+
+inline bigint bigint::operator*(const bigint &b) const & noexcept {
+  bigint res = *this;
+  // keep a * a recognisable as a squaring
+  res *= (&b == this) ? res : b;
+  return res;
+}
+
+inline bigint bigint::operator*(const bigint &b) && noexcept {
+  *this *= b;
+  return std::move(*this);
+}
+
+inline bigint bigint::operator*(bigint &&b) const & noexcept {
+  b *= *this;
+  return std::move(b);
+}
+
+inline bigint bigint::operator*(bigint &&b) && noexcept {
+  *this *= b;
+  return std::move(*this);
+}
+
+inline const bigint &bigint::operator*=(const bigint &b) noexcept {
+  sign = (sign != b.sign);
+  val_mult(b);
+  if (is_zero()) {
+    sign = false;
+  }
+  return *this;
+}
+
+#ifdef DOCTEST_LIBRARY_INCLUDED
+TEST_CASE("[bigint] multiplications") {
+  // Multiplication with zero
+  CHECK_EQ(bigint(0) * bigint(0), bigint(0));
+  CHECK_EQ(bigint(12345) * bigint(0), bigint(0));
+  CHECK_EQ(bigint(0) * bigint(12345), bigint(0));
+
+  // Multiplication with one
+  CHECK_EQ(bigint(12345) * bigint(1), bigint(12345));
+  CHECK_EQ(bigint(1) * bigint(12345), bigint(12345));
+
+  // Positive number multiplication
+  CHECK_EQ(bigint(123) * bigint(456), bigint(56088));
+  CHECK_EQ(bigint(999) * bigint(999), bigint(998001));
+
+  // Negative number multiplication
+  CHECK_EQ(bigint(-123) * bigint(456), bigint(-56088));
+  CHECK_EQ(bigint(123) * bigint(-456), bigint(-56088));
+  CHECK_EQ(bigint(-123) * bigint(-456), bigint(56088));
+}
+
+TEST_CASE("[bigint] multiplication across limb boundaries") {
+  CHECK_EQ(bigint(4294967295) * bigint(4294967295),
+           bigint("18446744065119617025"));
+  CHECK_EQ(bigint("18446744073709551615") * bigint("18446744073709551615"),
+           bigint("340282366920938463426481119284349108225"));
+  CHECK_EQ(bigint("340282366920938463463374607431768211456") * bigint(-1),
+           bigint("-340282366920938463463374607431768211456"));
+}
+
+TEST_CASE("[bigint] multiplication algorithm tiers") {
+  const auto saved = bigint::thresholds;
+  // (10^900 - 1)^2 and (10^900 - 1)(10^200 - 1), about 94 and 21 limbs
+  const bigint a(std::string(900, '9'));
+  const bigint b(std::string(200, '9'));
+  const bigint a2(std::string(899, '9') + "8" + std::string(899, '0') + "1");
+  const bigint ab(std::string(199, '9') + "8" + std::string(700, '9') +
+                  std::string(199, '0') + "1");
+  for (const auto t : {bigint::mul_thresholds{1000, 1000, 1000},
+                       bigint::mul_thresholds{4, 1000, 1000},
+                       bigint::mul_thresholds{4, 6, 1000},
+                       bigint::mul_thresholds{8, 24, 1000},
+                       bigint::mul_thresholds{4, 6, 12},
+                       bigint::mul_thresholds{1000, 1000, 1}}) {
+    bigint::thresholds = t;
+    CHECK_EQ(a * a, a2);
+    CHECK_EQ(a * b, ab);
+    CHECK_EQ(b * -a, -ab);
+    bigint sq = a;
+    sq *= sq;
+    CHECK_EQ(sq, a2);
+  }
+  bigint::thresholds = saved;
+}
+
+TEST_CASE("[bigint] parallel multiplication") {
+  const auto saved = bigint::thresholds;
+  const auto saved_parallel = bigint::parallel;
+  const bigint a = pow(bigint(3), 30000) - bigint(1);
+  const bigint b = pow(bigint(7), 2000) + bigint(1);
+  const bigint c = pow(bigint(5), 20000) + bigint(3);
+  const bigint ab = a * b;
+  const bigint ac = a * c;
+  const bigint aa = a * a;
+  // the sub-products of each tier, split down to small sizes
+  for (const auto t : {bigint::mul_thresholds{4, 1000, 100000},
+                       bigint::mul_thresholds{8, 24, 100000},
+                       bigint::mul_thresholds{24, 400, 64}}) {
+    bigint::thresholds = t;
+    for (const std::size_t threads : std::initializer_list<std::size_t>{2, 3, 8}) {
+      bigint::parallel = {threads, 16};
+      CHECK_EQ(a * b, ab);
+      CHECK_EQ(a * c, ac);
+      CHECK_EQ(a * a, aa);
+    }
+  }
+  bigint::thresholds = saved;
+  bigint::parallel = saved_parallel;
+}
+
+TEST_CASE("[bigint] multiplication chaining") {
+  CHECK_EQ(bigint(2) * bigint(3) * bigint(4), bigint(24));
+  CHECK_EQ(bigint(10) * bigint(-5) * bigint(2), bigint(-100));
+  CHECK_EQ(bigint(-2) * bigint(-3) * bigint(-4), bigint(-24));
+}
+
+TEST_CASE("[bigint] multiplication edge cases") {
+  CHECK_EQ(bigint("123456789123456789123456789123456789") *
+               bigint("987654321987654321987654321987654321"),
+           bigint("121932631356500531591068431825636331816338969581771069347203"
+                  "169112635269"));
+  CHECK_EQ(bigint("1000000000000000000") * bigint(-1),
+           bigint("-1000000000000000000"));
+  CHECK_EQ(bigint(1) * bigint("999999999999999999"),
+           bigint("999999999999999999"));
+  CHECK_EQ(bigint("-1") * bigint("999999999999999999"),
+           bigint("-999999999999999999"));
+}
+#endif
+
+// fused multiply-add
+
+// *this += |a| * |b| with the sign s
+inline void bigint::addmul_signed(const bigint &a, const bigint &b,
+                                  const bool s) noexcept {
+  if (a.is_zero() || b.is_zero())
+    return;
+  const bigint &x = a.val.size() >= b.val.size() ? a : b;
+  const bigint &y = &x == &a ? b : a;
+  const std::size_t n = x.val.size();
+  const std::size_t m = y.val.size();
+  // rows are added straight into val, so they must not read from it
+  const bool rows = m < thresholds.karatsuba && this != &a && this != &b;
+  if (rows && (is_zero() || sign == s)) {
+    sign = s;
+    val.resize(std::max(val.size(), n + m) + 1, 0);
+    WORD *const r = val.data();
+    for (std::size_t i = 0; i < m; i++) {
+      const WORD carry = bigint_detail::addmul_1(r + i, x.val.data(), n, y.val[i]);
+      bigint_detail::add_1(r + i + n, r + i + n, val.size() - i - n, carry);
+    }
+    trim();
+  } else if (rows && val.size() > n + m) {
+    // |*this| > |a b|, so no partial difference goes negative
+    WORD *const r = val.data();
+    for (std::size_t i = 0; i < m; i++) {
+      const WORD borrow = bigint_detail::submul_1(r + i, x.val.data(), n, y.val[i]);
+      bigint_detail::sub_1(r + i + n, r + i + n, val.size() - i - n, borrow);
+    }
+    trim();
+  } else {
+    bigint prod;
+    prod.val.resize(n + m);
+    mul_limbs(prod.val.data(), x.val.data(), n, y.val.data(), m);
+    prod.trim();
+    if (is_zero()) {
+      val = std::move(prod.val);
+      sign = s;
+    } else {
+      add_signed(prod, s);
+    }
+  }
+}
+
+inline void bigint::addmul(bigint &dst, const bigint &a,
+                           const bigint &b) noexcept {
+  dst.addmul_signed(a, b, a.sign != b.sign);
+}
+
+inline void bigint::submul(bigint &dst, const bigint &a,
+                           const bigint &b) noexcept {
+  dst.addmul_signed(a, b, a.sign == b.sign);
+}
+
+// Lazy sums of products. bigint_expr::lazy(a) marks an operand, and the
+// expressions built from it with +, - and * only record pointers to their
+// operands. Converting one to a bigint evaluates it term by term with
+// bigint::addmul, so that
+//
+//   bigint r = lazy(a) * b + lazy(c) * d - e;
+//
+// creates no bigint for a * b, c * d or the partial sums. Only sums of
+// products of two operands can be expressed. An expression refers to its
+// operands, so it must be evaluated before they go out of scope and should
+// not be kept in an auto variable.
+namespace bigint_expr {
+// a signed term of a sum, a * b, or a alone when b is nullptr
+struct term {
+  const bigint *a;
+  const bigint *b;
+  bool negate;
+};
+
+template <std::size_t N> struct sum {
+  std::array<term, N> terms;
+
+  // whether x is one of the operands
+  [[nodiscard]]
+  constexpr bool refers_to(const bigint &x) const noexcept {
+    return std::ranges::any_of(terms, [&x](const term &t) {
+      return t.a == &x || t.b == &x;
+    });
+  }
+};
+
+// an operand marked by lazy, not yet part of a sum
+struct operand {
+  const bigint *x;
+};
+
+/**
+ * Marks a bigint as the start of a lazy expression.
+ * @param x The operand, which must outlive the expression.
+ * @return An operand that builds a lazy expression with +, - and *.
+ */
+[[nodiscard]]
+constexpr operand lazy(const bigint &x) noexcept {
+  return {&x};
+}
+
+template <typename T> inline constexpr bool is_sum = false;
+template <std::size_t N> inline constexpr bool is_sum<sum<N>> = true;
+
+template <typename T>
+concept summand = std::same_as<T, operand> || is_sum<T>;
+
+template <typename T>
+concept term_operand = summand<T> || std::same_as<T, bigint>;
+
+template <typename T>
+concept factor = std::same_as<T, operand> || std::same_as<T, bigint>;
+
+constexpr const bigint *address(const operand &o) noexcept { return o.x; }
+constexpr const bigint *address(const bigint &x) noexcept { return &x; }
+
+template <std::size_t N>
+constexpr const sum<N> &as_sum(const sum<N> &e) noexcept {
+  return e;
+}
+constexpr sum<1> as_sum(const operand &o) noexcept {
+  return {{term{o.x, nullptr, false}}};
+}
+constexpr sum<1> as_sum(const bigint &x) noexcept {
+  return {{term{&x, nullptr, false}}};
+}
+
+// the terms of l followed by those of r, negated when negate is set
+template <std::size_t N, std::size_t M>
+constexpr sum<N + M> join(const sum<N> &l, const sum<M> &r,
+                          const bool negate) noexcept {
+  sum<N + M> res{};
+  std::ranges::copy(l.terms, res.terms.begin());
+  for (std::size_t i = 0; i < M; i++) {
+    res.terms[N + i] = r.terms[i];
+    res.terms[N + i].negate = r.terms[i].negate != negate;
+  }
+  return res;
+}
+
+template <factor L, factor R>
+  requires(std::same_as<L, operand> || std::same_as<R, operand>)
+[[nodiscard]]
+constexpr sum<1> operator*(const L &l, const R &r) noexcept {
+  return {{term{address(l), address(r), false}}};
+}
+
+template <term_operand L, term_operand R>
+  requires(summand<L> || summand<R>)
+[[nodiscard]]
+constexpr auto operator+(const L &l, const R &r) noexcept {
+  return join(as_sum(l), as_sum(r), false);
+}
+
+template <term_operand L, term_operand R>
+  requires(summand<L> || summand<R>)
+[[nodiscard]]
+constexpr auto operator-(const L &l, const R &r) noexcept {
+  return join(as_sum(l), as_sum(r), true);
+}
+
+template <summand E>
+[[nodiscard]]
+constexpr auto operator-(const E &e) noexcept {
+  return join(sum<0>{}, as_sum(e), true);
+}
+} // namespace bigint_expr
+
+template <std::size_t N>
+void bigint::add_expr(const bigint_expr::sum<N> &e,
+                      const bool negate) noexcept {
+  for (const bigint_expr::term &t : e.terms) {
+    const bool neg = t.negate != negate;
+    if (t.b) {
+      addmul_signed(*t.a, *t.b, (t.a->sign != t.b->sign) != neg);
+    } else {
+      add_signed(*t.a, t.a->sign != neg);
+    }
+  }
+}
+
+template <std::size_t N>
+bigint::bigint(const bigint_expr::sum<N> &e) noexcept : bigint() {
+  add_expr(e, false);
+}
+
+template <std::size_t N>
+bigint &bigint::operator=(const bigint_expr::sum<N> &e) noexcept {
+  // later terms must see the operands as they were before the assignment
+  if (e.refers_to(*this))
+    return *this = bigint(e);
+  val.clear();
+  val.push_back(0);
+  sign = false;
+  add_expr(e, false);
+  return *this;
+}
+
+template <std::size_t N>
+const bigint &bigint::operator+=(const bigint_expr::sum<N> &e) noexcept {
+  if (e.refers_to(*this)) {
+    const bigint res(e);
+    add_signed(res, res.sign);
+  } else {
+    add_expr(e, false);
+  }
+  return *this;
+}
+
+template <std::size_t N>
+const bigint &bigint::operator-=(const bigint_expr::sum<N> &e) noexcept {
+  if (e.refers_to(*this)) {
+    const bigint res(e);
+    add_signed(res, !res.sign);
+  } else {
+    add_expr(e, true);
+  }
+  return *this;
+}
+
+#ifdef DOCTEST_LIBRARY_INCLUDED
+TEST_CASE("[bigint] addmul and submul") {
+  const bigint a("123456789123456789123456789");
+  const bigint b("-987654321987654321");
+  const bigint c("5555555555555555555555555555555555555555555555555555555");
+  bigint d = c;
+  bigint::addmul(d, a, b);
+  CHECK_EQ(d, c + a * b);
+  d = c;
+  bigint::submul(d, a, b);
+  CHECK_EQ(d, c - a * b);
+  d = bigint(0);
+  bigint::addmul(d, a, b);
+  CHECK_EQ(d, a * b);
+  d = bigint(7);
+  bigint::addmul(d, a, b);
+  CHECK_EQ(d, a * b + bigint(7));
+  d = a * b;
+  bigint::submul(d, a, b);
+  CHECK_EQ(d, bigint(0));
+  bigint::addmul(d, a, bigint(0));
+  CHECK_EQ(d, bigint(0));
+
+  // the destination as a factor
+  d = a;
+  bigint::addmul(d, d, b);
+  CHECK_EQ(d, a + a * b);
+  d = b;
+  bigint::submul(d, d, d);
+  CHECK_EQ(d, b - b * b);
+
+  // products above the schoolbook threshold
+  const bigint x(std::string(600, '7'));
+  const bigint y("-" + std::string(500, '3'));
+  d = c;
+  bigint::addmul(d, x, y);
+  CHECK_EQ(d, c + x * y);
+  bigint::submul(d, x, y);
+  CHECK_EQ(d, c);
+}
+
+TEST_CASE("[bigint] lazy expressions") {
+  using bigint_expr::lazy;
+  const bigint a("123456789123456789123456789");
+  const bigint b("-987654321987654321");
+  const bigint c("5555555555555555555555555555555555555555555555555555555");
+  const bigint d(-42);
+
+  bigint r = lazy(a) * b + lazy(c) * d - a;
+  CHECK_EQ(r, a * b + c * d - a);
+  r = lazy(a) * lazy(a) - c;
+  CHECK_EQ(r, a * a - c);
+  r = c - b * lazy(d) + a;
+  CHECK_EQ(r, c - b * d + a);
+  r = -(lazy(a) * b) - lazy(c);
+  CHECK_EQ(r, -(a * b) - c);
+  r = lazy(a) * b - lazy(b) * a;
+  CHECK_EQ(r, bigint(0));
+
+  // expressions that refer to the destination
+  r = a;
+  r = lazy(r) * b + r;
+  CHECK_EQ(r, a * b + a);
+  r = a;
+  r += lazy(c) * d + lazy(r) * r;
+  CHECK_EQ(r, a + c * d + a * a);
+  r = a;
+  r -= lazy(r) * b - c;
+  CHECK_EQ(r, a - a * b + c);
+  r = c;
+  r += lazy(a) * b;
+  CHECK_EQ(r, c + a * b);
+  r -= lazy(a) * b;
+  CHECK_EQ(r, c);
+}
+#endif
+
+// products and sums over ranges
+
+template <typename P>
+inline std::size_t bigint::policy_threads(const P &) noexcept {
+  if constexpr (std::is_same_v<P, std::execution::sequenced_policy>)
+    return 1;
+  else if (parallel.threads > 1)
+    return parallel.threads;
+  else
+    return std::max(std::thread::hardware_concurrency(), 1u);
+}
+
+template <typename E>
+inline bigint bigint::from_element(E &&e) noexcept(false) {
+  using T = std::remove_cvref_t<E>;
+  if constexpr (std::unsigned_integral<T> && sizeof(T) >= sizeof(std::int64_t)) {
+    // above the range of the int64_t constructor
+    bigint res(static_cast<std::int64_t>(e >> 1));
+    res <<= 1;
+    res.val[0] |= static_cast<WORD>(e & 1);
+    return res;
+  } else if constexpr (std::integral<T>) {
+    return bigint(static_cast<std::int64_t>(e));
+  } else {
+    return bigint(std::forward<E>(e));
+  }
+}
+
+// Reduces r with tree, reading contiguous bigints in place and converting
+// anything else to bigints first.
+template <typename R, typename Tree>
+inline bigint bigint::reduce_range(R &&r, const std::size_t threads,
+                                   Tree tree) noexcept(false) {
+  if constexpr (std::ranges::contiguous_range<R> &&
+                std::same_as<std::ranges::range_value_t<R>, bigint>) {
+    return tree(std::ranges::data(r), std::ranges::size(r), threads);
+  } else {
+    std::vector<bigint> x;
+    if constexpr (std::ranges::sized_range<R>)
+      x.reserve(std::ranges::size(r));
+    for (auto &&e : r)
+      x.push_back(from_element(std::forward<decltype(e)>(e)));
+    return tree(x.data(), x.size(), threads);
+  }
+}
+
+// the product of x[0..n), with the two halves of each node reduced on their
+// own share of the threads
+inline bigint bigint::product_tree(const bigint *x, const std::size_t n,
+                                   const std::size_t threads) noexcept {
+  constexpr std::size_t LEAF = 8;
+  if (n <= LEAF) {
+    bigint res(1);
+    for (std::size_t i = 0; i < n; i++)
+      res *= x[i];
+    return res;
+  }
+  const std::size_t h = n / 2;
+  bigint lo, hi;
+  bigint_detail::thread_pool::instance().run(2, threads, [&](std::size_t i) {
+    if (i == 0)
+      lo = product_tree(x, h, threads / 2);
+    else
+      hi = product_tree(x + h, n - h, threads - threads / 2);
+  });
+  return std::move(lo) * std::move(hi);
+}
+
+inline bigint bigint::sum_tree(const bigint *x, const std::size_t n,
+                               const std::size_t threads) noexcept {
+  constexpr std::size_t LEAF = 8;
+  if (n <= LEAF) {
+    bigint res;
+    for (std::size_t i = 0; i < n; i++)
+      res += x[i];
+    return res;
+  }
+  const std::size_t h = n / 2;
+  bigint lo, hi;
+  bigint_detail::thread_pool::instance().run(2, threads, [&](std::size_t i) {
+    if (i == 0)
+      lo = sum_tree(x, h, threads / 2);
+    else
+      hi = sum_tree(x + h, n - h, threads - threads / 2);
+  });
+  return std::move(lo) + std::move(hi);
+}
+
+template <std::ranges::input_range R>
+  requires std::constructible_from<bigint, std::ranges::range_reference_t<R>>
+inline bigint bigint::product(R &&r) noexcept(false) {
+  return reduce_range(std::forward<R>(r), 1, product_tree);
+}
+
+template <typename P, std::ranges::input_range R>
+  requires std::is_execution_policy_v<std::remove_cvref_t<P>> &&
+           std::constructible_from<bigint, std::ranges::range_reference_t<R>>
+inline bigint bigint::product(P &&policy, R &&r) noexcept(false) {
+  return reduce_range(std::forward<R>(r), policy_threads(policy), product_tree);
+}
+
+template <std::ranges::input_range R>
+  requires std::constructible_from<bigint, std::ranges::range_reference_t<R>>
+inline bigint bigint::sum(R &&r) noexcept(false) {
+  return reduce_range(std::forward<R>(r), 1, sum_tree);
+}
+
+template <typename P, std::ranges::input_range R>
+  requires std::is_execution_policy_v<std::remove_cvref_t<P>> &&
+           std::constructible_from<bigint, std::ranges::range_reference_t<R>>
+inline bigint bigint::sum(P &&policy, R &&r) noexcept(false) {
+  return reduce_range(std::forward<R>(r), policy_threads(policy), sum_tree);
+}
+
+#ifdef DOCTEST_LIBRARY_INCLUDED
+TEST_CASE("[bigint] product and sum over ranges") {
+  bigint f(1);
+  for (std::int64_t i = 2; i <= 1000; i++)
+    f *= bigint(i);
+  const auto numbers = std::views::iota(1, 1001);
+  CHECK_EQ(bigint::product(numbers), f);
+  CHECK_EQ(bigint::product(std::execution::par, numbers), f);
+  CHECK_EQ(bigint::product(std::execution::seq, numbers), f);
+  CHECK_EQ(bigint::sum(numbers), bigint(500500));
+  CHECK_EQ(bigint::sum(std::execution::par_unseq, numbers), bigint(500500));
+
+  CHECK_EQ(bigint::product(std::vector<int>{}), bigint(1));
+  CHECK_EQ(bigint::sum(std::vector<int>{}), bigint(0));
+  CHECK_EQ(bigint::product(std::vector<int>{-3, 5, -7}), bigint(105));
+  CHECK_EQ(bigint::sum(std::vector<long>{-3, 5, -7}), bigint(-5));
+  const std::vector<std::uint64_t> big{UINT64_MAX, UINT64_MAX};
+  CHECK_EQ(bigint::sum(big), bigint("36893488147419103230"));
+  CHECK_EQ(bigint::product(big),
+           bigint("340282366920938463426481119284349108225"));
+  const std::vector<std::string> strings{"123456789123456789", "-2", "10"};
+  CHECK_EQ(bigint::product(strings), bigint("-2469135782469135780"));
+  CHECK_THROWS_AS(static_cast<void>(bigint::sum(std::vector<std::string>{"1", "x"})),
+                  std::invalid_argument);
+
+  // contiguous bigint elements are read in place, while other ranges of
+  // bigints, such as a deque or a reversed view, are copied first
+  std::vector<bigint> powers;
+  for (int i = 0; i < 300; i++)
+    powers.push_back(pow(bigint(3), static_cast<std::uint64_t>(i)));
+  const bigint p = pow(bigint(3), 299 * 300 / 2);
+  const bigint s = (pow(bigint(3), 300) - bigint(1)) / bigint(2);
+  const auto saved = bigint::parallel;
+  for (const std::size_t threads : std::initializer_list<std::size_t>{1, 3, 16}) {
+    bigint::parallel = {threads, 16};
+    CHECK_EQ(bigint::product(powers), p);
+    CHECK_EQ(bigint::product(std::execution::par, powers), p);
+    CHECK_EQ(bigint::sum(std::execution::par, powers), s);
+    CHECK_EQ(bigint::product(std::deque<bigint>(powers.begin(), powers.end())),
+             p);
+    CHECK_EQ(bigint::sum(powers | std::views::reverse), s);
+  }
+  bigint::parallel = saved;
+}
+#endif
+
+// division operators
+
+inline bigint bigint::operator/(const WORD b) const noexcept(false) {
+  bigint res = *this;
+  res /= b;
+  return res;
+}
+
+inline const bigint &bigint::operator/=(const WORD b) noexcept(false) {
+  if (!b)
+    throw std::domain_error("division by zero");
+  bigint_detail::divrem_1(val.data(), val.data(), val.size(), b);
+  trim();
+  if (is_zero()) {
+    sign = false;
+  }
+  return *this;
+}
+
+inline bigint bigint::operator%(const WORD b) const noexcept(false) {
+  if (!b)
+    throw std::domain_error("division by zero");
+  // divrem_1 without storing the quotient
+  DWORD rem = 0;
+  for (const WORD ai : val | std::views::reverse) {
+    rem = ((rem << WORD_BITS) | ai) % b;
+  }
+  bigint res;
+  res.val[0] = static_cast<WORD>(rem);
+  res.sign = sign && rem;
+  return res;
+}
+
+inline const bigint &bigint::operator%=(const WORD b) noexcept(false) {
+  *this = *this % b;
+  return *this;
+}
+
+inline std::pair<bigint, bigint> divmod(const bigint &a,
+                                        const bigint &b) noexcept(false) {
+  if (b.is_zero())
+    throw std::domain_error("division by zero");
+  std::pair<bigint, bigint> res;
+  auto &[q, r] = res;
+  bigint::val_divmod(a, b, q, r);
+  q.sign = !q.is_zero() && a.sign != b.sign;
+  r.sign = !r.is_zero() && a.sign;
+  return res;
+}
+
+inline bigint bigint::operator/(const bigint &b) const noexcept(false) {
+  return divmod(*this, b).first;
+}
+
+inline const bigint &bigint::operator/=(const bigint &b) noexcept(false) {
+  *this = divmod(*this, b).first;
+  return *this;
+}
+
+inline bigint bigint::operator%(const bigint &b) const noexcept(false) {
+  return divmod(*this, b).second;
+}
+
+inline const bigint &bigint::operator%=(const bigint &b) noexcept(false) {
+  *this = divmod(*this, b).second;
+  return *this;
+}
+
+#ifdef DOCTEST_LIBRARY_INCLUDED
+TEST_CASE("[bigint] divisions") {
+  // Division by zero
+  CHECK_THROWS_AS(bigint _ = bigint(1) / bigint(0), std::domain_error);
+  CHECK_THROWS_AS(bigint _ = bigint(1) % bigint(0), std::domain_error);
+  CHECK_THROWS_AS(bigint _ = bigint(1) / 0, std::domain_error);
+  CHECK_THROWS_AS(bigint _ = bigint(1) % 0, std::domain_error);
+
+  // Division of zero
+  CHECK_EQ(bigint(0) / bigint(12345), bigint(0));
+  CHECK_EQ(bigint(0) % bigint(-12345), bigint(0));
+
+  // Truncation towards zero, remainder takes the sign of the dividend
+  CHECK_EQ(bigint(7) / bigint(2), bigint(3));
+  CHECK_EQ(bigint(7) % bigint(2), bigint(1));
+  CHECK_EQ(bigint(-7) / bigint(2), bigint(-3));
+  CHECK_EQ(bigint(-7) % bigint(2), bigint(-1));
+  CHECK_EQ(bigint(7) / bigint(-2), bigint(-3));
+  CHECK_EQ(bigint(7) % bigint(-2), bigint(1));
+  CHECK_EQ(bigint(-7) / bigint(-2), bigint(3));
+  CHECK_EQ(bigint(-7) % bigint(-2), bigint(-1));
+  CHECK_EQ(bigint(-6) % bigint(3), bigint(0));
+  CHECK_EQ(bigint(12345) / bigint(67890), bigint(0));
+  CHECK_EQ(bigint(-12345) % bigint(67890), bigint(-12345));
+
+  // Single WORD divisors
+  CHECK_EQ(bigint("1000000000000000000000000000000") / 7,
+           bigint("142857142857142857142857142857"));
+  CHECK_EQ(bigint("1000000000000000000000000000000") % 7, bigint(1));
+  CHECK_EQ(bigint("-1000000000000000000000000000000") % 7, bigint(-1));
+  CHECK_EQ(bigint("-1000000000000000000000000000000") / 4294967295,
+           bigint("-232830643708079737543"));
+
+  // Multi-limb divisors
+  CHECK_EQ(bigint("121932631356500531591068431825636331816338969581771069347203"
+                  "169112635269") /
+               bigint("987654321987654321987654321987654321"),
+           bigint("123456789123456789123456789123456789"));
+  CHECK_EQ(bigint("340282366920938463463374607431768211455") /
+               bigint("18446744073709551616"),
+           bigint("18446744073709551615"));
+  CHECK_EQ(bigint("340282366920938463463374607431768211455") %
+               bigint("18446744073709551616"),
+           bigint("18446744073709551615"));
+}
+
+TEST_CASE("[bigint] division algorithm tiers") {
+  const auto saved = bigint::div_threshold;
+  // (10^900 - 1)(10^200 - 1) + 10^150 divided both ways
+  const bigint a(std::string(900, '9'));
+  const bigint b(std::string(200, '9'));
+  const bigint r("1" + std::string(150, '0'));
+  const bigint n = a * b + r;
+  for (const std::size_t t : std::vector<std::size_t>{1000, 2, 3, 8}) {
+    bigint::div_threshold = t;
+    CHECK_EQ(n / a, b);
+    CHECK_EQ(n % a, r);
+    CHECK_EQ(n / b, a);
+    CHECK_EQ(n % b, r);
+    const auto [q, m] = divmod(-n, b);
+    CHECK_EQ(q, -a);
+    CHECK_EQ(m, -r);
+    CHECK_EQ((a * a) / a, a);
+    CHECK_EQ((a * a - bigint(1)) / a, a - bigint(1));
+  }
+  bigint::div_threshold = saved;
+}
+#endif
+
+// exponentiation
+
+inline bigint pow(const bigint &base, const std::uint64_t exp) noexcept {
+  if (!exp)
+    return bigint(1);
+  bigint res = base;
+  for (int i = 62 - std::countl_zero(exp); i >= 0; i--) {
+    res *= res;
+    if ((exp >> i) & 1)
+      res *= base;
+  }
+  return res;
+}
+
+/**
+ * Constants for arithmetic modulo a fixed odd number by Montgomery
+ * multiplication, computed once so that many exponentiations with the same
+ * modulus share them. A context is not modified after construction and can
+ * be used from several threads at once.
+ */
+class montgomery_context {
+public:
+  /**
+   * Prepares arithmetic modulo mod.
+   * @param mod The modulus, which must be positive and odd.
+   * @throws std::domain_error if mod is not positive and odd.
+   */
+  explicit montgomery_context(const bigint &mod) noexcept(false);
+
+  /**
+   * @return The modulus.
+   */
+  [[nodiscard]]
+  const bigint &modulus() const noexcept;
+
+  /**
+   * Computes base^exp mod modulus() by sliding-window exponentiation.
+   * @param base The base, which may be negative or exceed the modulus.
+   * @param exp The exponent.
+   * @return The result, in [0, modulus()).
+   * @throws std::domain_error if exp is negative.
+   */
+  [[nodiscard]]
+  bigint pow(const bigint &base, const bigint &exp) const noexcept(false);
+
+  /**
+   * Computes base^exp mod modulus() with a fixed 4-bit window, for secret
+   * exponents or bases. The operations and memory accesses depend only on the
+   * limb counts of exp and the modulus, not on their values or the value of
+   * base. A base outside [0, modulus()) is first reduced by division, which
+   * does not share this property.
+   * @param base The base.
+   * @param exp The exponent.
+   * @return The result, in [0, modulus()).
+   * @throws std::domain_error if exp is negative.
+   */
+  [[nodiscard]]
+  bigint pow_ct(const bigint &base, const bigint &exp) const noexcept(false);
+
+private:
+  using limb = bigint_detail::limb;
+  // a value in Montgomery form, x 2^(LIMB_BITS n) mod m in exactly n limbs
+  using residue = std::vector<limb>;
+
+  bigint mod_;
+  // mont_inverse(m[0])
+  limb minv_;
+  // the Montgomery forms of 1 and of 2^(LIMB_BITS n)
+  residue one_;
+  residue r2_;
+
+  [[nodiscard]]
+  std::size_t size() const noexcept;
+  [[nodiscard]]
+  residue padded(const bigint &x) const noexcept;
+  [[nodiscard]]
+  residue to_residue(const bigint &x) const noexcept;
+  [[nodiscard]]
+  bigint from_residue(const residue &x) const noexcept;
+  void mul(residue &r, const residue &a, const residue &b,
+           residue &t) const noexcept;
+  void mul_fast(residue &r, const residue &a, const residue &b,
+                residue &t) const noexcept;
+};
+
+inline montgomery_context::montgomery_context(const bigint &mod) noexcept(false)
+    : mod_(mod), minv_(0) {
+  if (mod.sign || !(mod.val[0] & 1))
+    throw std::domain_error("modulus must be positive and odd");
+  minv_ = bigint_detail::mont_inverse(mod.val[0]);
+  // 2^(LIMB_BITS n) mod m, then its square
+  bigint r;
+  r.val.assign(size(), 0);
+  r.val.push_back(1);
+  r %= mod_;
+  one_ = padded(r);
+  r *= r;
+  r %= mod_;
+  r2_ = padded(r);
+}
+
+inline const bigint &montgomery_context::modulus() const noexcept {
+  return mod_;
+}
+
+inline std::size_t montgomery_context::size() const noexcept {
+  return mod_.val.size();
+}
+
+// |x| < m zero extended to the size of the modulus
+inline montgomery_context::residue
+montgomery_context::padded(const bigint &x) const noexcept {
+  residue res(size(), 0);
+  std::ranges::copy(x.val, res.begin());
+  return res;
+}
+
+inline montgomery_context::residue
+montgomery_context::to_residue(const bigint &x) const noexcept {
+  bigint y = x % mod_;
+  if (y.sign)
+    y += mod_;
+  residue res = padded(y);
+  residue t(size() + 2);
+  mul(res, res, r2_, t);
+  return res;
+}
+
+inline bigint montgomery_context::from_residue(const residue &x) const noexcept {
+  // multiplying by 1 divides out the Montgomery factor
+  residue unit(size(), 0);
+  unit[0] = 1;
+  residue res(size()), t(size() + 2);
+  mul(res, x, unit, t);
+  return bigint::from_limbs(res.data(), res.size());
+}
+
+inline void montgomery_context::mul(residue &r, const residue &a,
+                                    const residue &b,
+                                    residue &t) const noexcept {
+  bigint_detail::mont_mul(r.data(), a.data(), b.data(), mod_.val.data(),
+                          size(), minv_, t.data());
+}
+
+// Above the Karatsuba threshold the product is cheaper through mul_limbs,
+// here with squarings recognised, followed by a separate reduction. t holds
+// 2n limbs.
+inline void montgomery_context::mul_fast(residue &r, const residue &a,
+                                         const residue &b,
+                                         residue &t) const noexcept {
+  const std::size_t n = size();
+  if (n < bigint::thresholds.karatsuba) {
+    mul(r, a, b, t);
+    return;
+  }
+  bigint::mul_limbs(t.data(), a.data(), n, b.data(), n);
+  bigint_detail::mont_redc(r.data(), t.data(), mod_.val.data(), n, minv_);
+}
+
+inline bigint montgomery_context::pow(const bigint &base,
+                                      const bigint &exp) const noexcept(false) {
+  if (exp.sign)
+    throw std::domain_error("negative exponent");
+  if (exp.is_zero())
+    return from_residue(one_);
+  residue t(2 * size() + 2);
+  const residue res = bigint_detail::window_pow(
+      to_residue(base), exp.val.data(), exp.val.size(),
+      [this, &t](residue &r, const residue &a, const residue &b) {
+        mul_fast(r, a, b, t);
+      });
+  return from_residue(res);
+}
+
+inline bigint montgomery_context::pow_ct(const bigint &base,
+                                         const bigint &exp) const
+    noexcept(false) {
+  if (exp.sign)
+    throw std::domain_error("negative exponent");
+  constexpr std::size_t K = 4;
+  static_assert(bigint_detail::LIMB_BITS % K == 0);
+  const std::size_t n = size();
+  residue t(n + 2);
+  std::vector<residue> table(std::size_t{1} << K, one_);
+  table[1] = to_residue(base);
+  for (std::size_t i = 2; i < table.size(); i++)
+    mul(table[i], table[i - 1], table[1], t);
+
+  residue res = one_, pick(n);
+  for (std::size_t i = exp.val.size() * bigint_detail::LIMB_BITS; i > 0;
+       i -= K) {
+    for (std::size_t k = 0; k < K; k++)
+      mul(res, res, res, t);
+    const limb w = (exp.val[(i - K) / bigint_detail::LIMB_BITS] >>
+                    ((i - K) % bigint_detail::LIMB_BITS)) &
+                   ((limb{1} << K) - 1);
+    // read every entry, keeping the one at w by mask
+    std::ranges::fill(pick, limb{0});
+    for (limb j = 0; j < table.size(); j++) {
+      const auto keep = static_cast<limb>(
+          (bigint_detail::dlimb{j ^ w} - 1) >> bigint_detail::LIMB_BITS);
+      for (std::size_t l = 0; l < n; l++)
+        pick[l] |= table[j][l] & keep;
+    }
+    mul(res, res, pick, t);
+  }
+  return from_residue(res);
+}
+
+inline bigint powmod(const bigint &base, const bigint &exp,
+                     const bigint &mod) noexcept(false) {
+  if (mod.is_zero())
+    throw std::domain_error("division by zero");
+  if (exp.sign)
+    throw std::domain_error("negative exponent");
+  const bigint m = mod.sign ? -mod : mod;
+  if (m.val[0] & 1)
+    return montgomery_context(m).pow(base, exp);
+  // Montgomery reduction needs an odd modulus, so reduce by division
+  if (exp.is_zero())
+    return bigint(1);
+  bigint x = base % m;
+  if (x.sign)
+    x += m;
+  return bigint_detail::window_pow(
+      x, exp.val.data(), exp.val.size(),
+      [&m](bigint &r, const bigint &a, const bigint &b) { r = a * b % m; });
+}
+
+#ifdef DOCTEST_LIBRARY_INCLUDED
+TEST_CASE("[bigint] pow") {
+  CHECK_EQ(pow(bigint(3), 200),
+           bigint("26561398887587476933878132203577962682923345265339449597457"
+                  "4961739092490901302182994384699044001"));
+  CHECK_EQ(pow(bigint(-7), 33), bigint("-7730993719707444524137094407"));
+  CHECK_EQ(pow(bigint(-7), 0), bigint(1));
+  CHECK_EQ(pow(bigint(0), 0), bigint(1));
+  CHECK_EQ(pow(bigint(0), 5), bigint(0));
+  CHECK_EQ(pow(bigint(2), 100), bigint("1267650600228229401496703205376"));
+  CHECK_EQ(pow(bigint(-1), 12345), bigint(-1));
+}
+
+TEST_CASE("[bigint] powmod") {
+  const bigint a("123456789123456789123456789");
+  const bigint e("98765432109876543211");
+  const bigint m("1000000000000000000000000000057");
+  CHECK_EQ(powmod(a, e - bigint(1), m),
+           bigint("755215427680198881120832376503"));
+  CHECK_EQ(powmod(-a, e, m), bigint("345785291070609930961621146300"));
+  CHECK_EQ(powmod(-a, e, -m), bigint("345785291070609930961621146300"));
+  CHECK_EQ(powmod(-a, e, m * 2), bigint("1345785291070609930961621146357"));
+  CHECK_EQ(powmod(a, e, pow(bigint(2), 100)),
+           bigint("807617582364654548032859767437"));
+  CHECK_EQ(powmod(a, bigint(0), m), bigint(1));
+  CHECK_EQ(powmod(a, bigint(0), bigint(1)), bigint(0));
+  CHECK_EQ(powmod(a, e, bigint(1)), bigint(0));
+  CHECK_EQ(powmod(bigint(0), e, m), bigint(0));
+  CHECK_THROWS_AS(bigint _ = powmod(a, e, bigint(0)), std::domain_error);
+  CHECK_THROWS_AS(bigint _ = powmod(a, -e, m), std::domain_error);
+
+  // Fermat's little theorem for the Mersenne primes 2^127 - 1 and 2^521 - 1
+  for (const std::uint64_t k : {127u, 521u}) {
+    const bigint p = pow(bigint(2), k) - bigint(1);
+    CHECK_EQ(powmod(bigint(3), p - bigint(1), p), bigint(1));
+    CHECK_EQ(powmod(a, p, p), a % p);
+  }
+}
+
+TEST_CASE("[bigint] montgomery_context") {
+  const bigint p = pow(bigint(2), 521) - bigint(1);
+  const montgomery_context ctx(p);
+  CHECK_EQ(ctx.modulus(), p);
+  const bigint a("123456789123456789123456789");
+  const bigint e = pow(bigint(3), 300);
+  const bigint expected = ctx.pow(a, e);
+  CHECK_EQ(expected, powmod(a, e, p * 2) % p);
+  CHECK_EQ(ctx.pow_ct(a, e), expected);
+  CHECK_EQ(ctx.pow_ct(a - p, e), expected);
+  CHECK_EQ(ctx.pow_ct(a, bigint(0)), bigint(1));
+  CHECK_EQ(ctx.pow_ct(a, bigint(1)), a);
+  CHECK_EQ(ctx.pow_ct(bigint(0), e), bigint(0));
+  CHECK_EQ(ctx.pow(p - bigint(1), bigint(2)), bigint(1));
+  CHECK_THROWS_AS(bigint _ = ctx.pow(a, bigint(-1)), std::domain_error);
+  CHECK_THROWS_AS(montgomery_context(bigint(10)), std::domain_error);
+  CHECK_THROWS_AS(montgomery_context(bigint(-7)), std::domain_error);
+}
+#endif
+
+// minus operator
+
+inline bigint bigint::operator-(const bigint &b) const & noexcept {
+  bigint res = copy_with_capacity(std::max(val.size(), b.val.size()) + 1);
+  res -= b;
+  return res;
+}
+
+inline bigint bigint::operator-(const bigint &b) && noexcept {
+  *this -= b;
+  return std::move(*this);
+}
+
+inline bigint bigint::operator-(bigint &&b) const & noexcept {
+  // a - b == -b + a
+  if (!b.is_zero()) {
+    b.sign = !b.sign;
+  }
+  b += *this;
+  return std::move(b);
+}
+
+inline bigint bigint::operator-(bigint &&b) && noexcept {
+  *this -= b;
+  return std::move(*this);
+}
+
+inline const bigint &bigint::operator-=(const bigint &b) noexcept {
+  add_signed(b, !b.sign);
+  return *this;
+}
+
+inline bigint bigint::operator-() const & noexcept {
+  bigint res = *this;
+  if (!is_zero()) {
+    res.sign = !res.sign;
+  }
+  return res;
+}
+
+inline bigint bigint::operator-() && noexcept {
+  if (!is_zero()) {
+    sign = !sign;
+  }
+  return std::move(*this);
+}
+
+// pre/post-fix operators
+inline const bigint &bigint::operator++() noexcept {
+  *this += 1;
+  return *this;
+}
+
+inline bigint bigint::operator++(int) noexcept {
+  bigint res = *this;
+  *this += 1;
+  return res;
+}
+
+inline const bigint &bigint::operator--() noexcept {
+  *this -= 1;
+  return *this;
+}
+
+inline bigint bigint::operator--(int) noexcept {
+  bigint res = *this;
+  *this -= 1;
+  return res;
+}
+
+#ifdef DOCTEST_LIBRARY_INCLUDED
+TEST_CASE("[bigint] subtractions") {
+  // Subtraction resulting in zero
+  CHECK_EQ(bigint(0) - bigint(0), bigint(0));
+  CHECK_EQ(bigint(12345) - bigint(12345), bigint(0));
+  CHECK_EQ(bigint(-12345) - bigint(-12345), bigint(0));
+
+  // Subtracting zero
+  CHECK_EQ(bigint(12345) - bigint(0), bigint(12345));
+  CHECK_EQ(bigint(-12345) - bigint(0), bigint(-12345));
+  CHECK_EQ(bigint(0) - bigint(12345), bigint(-12345));
+  CHECK_EQ(bigint(0) - bigint(-12345), bigint(12345));
+
+  // Positive number subtraction
+  CHECK_EQ(bigint(12345) - bigint(54321), bigint(-41976));
+  CHECK_EQ(bigint(54321) - bigint(12345), bigint(41976));
+
+  // Negative number subtraction
+  CHECK_EQ(bigint(-12345) - bigint(54321), bigint(-66666));
+  CHECK_EQ(bigint(12345) - bigint(-54321), bigint(66666));
+  CHECK_EQ(bigint(-12345) - bigint(-54321), bigint(41976));
+}
+
+TEST_CASE("[bigint] temporaries and aliasing") {
+  const bigint a("123456789123456789123456789");
+  const bigint b("-987654321987654321");
+  CHECK_EQ(bigint(a) + b, bigint("123456788135802467135802468"));
+  CHECK_EQ(a + bigint(b), bigint("123456788135802467135802468"));
+  CHECK_EQ(bigint(a) + bigint(b), bigint("123456788135802467135802468"));
+  CHECK_EQ(bigint(a) - b, bigint("123456790111111111111111110"));
+  CHECK_EQ(a - bigint(b), bigint("123456790111111111111111110"));
+  CHECK_EQ(b - bigint(a), bigint("-123456790111111111111111110"));
+  CHECK_EQ(bigint(b) - bigint(a), bigint("-123456790111111111111111110"));
+  CHECK_EQ(bigint(a) * b, a * b);
+  CHECK_EQ(a * bigint(b), b * a);
+  CHECK_EQ(-bigint(a), bigint("-123456789123456789123456789"));
+  CHECK_EQ(-bigint(0), bigint(0));
+  CHECK_EQ(bigint(0) - bigint(a), -a);
+
+  bigint c = a;
+  c += c;
+  CHECK_EQ(c, a * 2);
+  c -= c;
+  CHECK_EQ(c, bigint(0));
+  c = b;
+  c *= c;
+  CHECK_EQ(c, bigint("975461059740893157555403139789971041"));
+  c = a;
+  CHECK_EQ(std::move(c) + a, a * 2);
+}
+
+TEST_CASE("[bigint] subtraction chaining") {
+  CHECK_EQ(bigint(10) - bigint(5) - bigint(2), bigint(3));
+  CHECK_EQ(bigint(100) - bigint(50) - bigint(30), bigint(20));
+  CHECK_EQ(bigint(-10) - bigint(-5) - bigint(-2), bigint(-3));
+}
+
+TEST_CASE("[bigint] subtraction edge cases") {
+  CHECK_EQ(bigint("123456789123456789") - bigint("987654321987654321"),
+           bigint("-864197532864197532"));
+  CHECK_EQ(bigint("987654321987654321") - bigint("123456789123456789"),
+           bigint("864197532864197532"));
+  CHECK_EQ(bigint("123456789123456789") - bigint("-987654321987654321"),
+           bigint("1111111111111111110"));
+  CHECK_EQ(bigint("-123456789123456789") - bigint("987654321987654321"),
+           bigint("-1111111111111111110"));
+  CHECK_EQ(bigint(1) - bigint(1), bigint(0));
+  CHECK_EQ(bigint(-1) - bigint(-1), bigint(0));
+  CHECK_EQ(bigint(-1) - bigint(1), bigint(-2));
+  CHECK_EQ(bigint(1) - bigint(-1), bigint(2));
+}
+#endif
+
+// shift and bitwise operators
+
+inline bigint bigint::operator<<(const std::size_t n) const noexcept {
+  bigint res = copy_with_capacity(val.size() + n / WORD_BITS + 1);
+  res <<= n;
+  return res;
+}
+
+inline const bigint &bigint::operator<<=(const std::size_t n) noexcept {
+  if (is_zero())
+    return *this;
+  const std::size_t k = n / WORD_BITS;
+  const auto cnt = static_cast<unsigned>(n % WORD_BITS);
+  const std::size_t m = val.size();
+  val.resize(m + k + 1, 0);
+  WORD *const r = val.data();
+  // both moves run from the top down, so shifting up in place is safe
+  if (cnt) {
+    r[m + k] = bigint_detail::lshift(r + k, r, m, cnt);
+  } else {
+    std::copy_backward(r, r + m, r + m + k);
+  }
+  std::fill(r, r + k, WORD{0});
+  trim();
+  return *this;
+}
+
+inline bigint bigint::operator>>(const std::size_t n) const noexcept {
+  bigint res = *this;
+  res >>= n;
+  return res;
+}
+
+inline const bigint &bigint::operator>>=(const std::size_t n) noexcept {
+  const std::size_t k = n / WORD_BITS;
+  const auto cnt = static_cast<unsigned>(n % WORD_BITS);
+  if (k >= val.size()) {
+    *this = bigint(sign ? -1 : 0);
+    return *this;
+  }
+  // a negative value rounds away from zero when one bits are shifted out
+  const bool round_up =
+      sign && (std::any_of(val.begin(), val.begin() + static_cast<std::ptrdiff_t>(k),
+                           [](WORD w) { return w != 0; }) ||
+               (cnt && static_cast<WORD>(val[k] << (WORD_BITS - cnt))));
+  const std::size_t m = val.size() - k;
+  WORD *const r = val.data();
+  // both moves run from the bottom up, so shifting down in place is safe
+  if (cnt) {
+    bigint_detail::rshift(r, r + k, m, cnt);
+  } else {
+    std::copy(r + k, r + k + m, r);
+  }
+  val.resize(m);
+  trim();
+  if (round_up) {
+    const WORD carry = bigint_detail::add_1(val.data(), val.data(), val.size(), 1);
+    if (carry)
+      val.push_back(carry);
+  }
+  if (is_zero())
+    sign = false;
+  return *this;
+}
+
+// the low n limbs of the two's complement form of *this, for
+// n > val.size() so that the top limb holds only sign bits
+inline bigint_detail::limb_vector
+bigint::twos_complement(const std::size_t n) const noexcept {
+  bigint_detail::limb_vector res(n, 0);
+  std::ranges::copy(val, res.begin());
+  if (sign) {
+    // -x = ~(x - 1)
+    bigint_detail::sub_1(res.data(), res.data(), n, 1);
+    for (WORD &w : res)
+      w = ~w;
+  }
+  return res;
+}
+
+// op applied limb by limb to the two's complement forms of a and b
+template <typename Op>
+inline bigint bigint::bitwise(const bigint &a, const bigint &b, Op op) noexcept {
+  const std::size_t n = std::max(a.val.size(), b.val.size()) + 1;
+  bigint res;
+  res.val = a.twos_complement(n);
+  const bigint_detail::limb_vector y = b.twos_complement(n);
+  WORD *const r = res.val.data();
+  for (std::size_t i = 0; i < n; i++)
+    r[i] = op(r[i], y[i]);
+  res.sign = r[n - 1] >> (WORD_BITS - 1);
+  if (res.sign) {
+    // |x| = ~x + 1, which cannot carry out as the top bit of ~x is clear
+    for (std::size_t i = 0; i < n; i++)
+      r[i] = ~r[i];
+    bigint_detail::add_1(r, r, n, 1);
+  }
+  res.trim();
+  return res;
+}
+
+inline bigint bigint::operator&(const bigint &b) const noexcept {
+  return bitwise(*this, b, std::bit_and<WORD>());
+}
+
+inline const bigint &bigint::operator&=(const bigint &b) noexcept {
+  *this = *this & b;
+  return *this;
+}
+
+inline bigint bigint::operator|(const bigint &b) const noexcept {
+  return bitwise(*this, b, std::bit_or<WORD>());
+}
+
+inline const bigint &bigint::operator|=(const bigint &b) noexcept {
+  *this = *this | b;
+  return *this;
+}
+
+inline bigint bigint::operator^(const bigint &b) const noexcept {
+  return bitwise(*this, b, std::bit_xor<WORD>());
+}
+
+inline const bigint &bigint::operator^=(const bigint &b) noexcept {
+  *this = *this ^ b;
+  return *this;
+}
+
+inline bigint bigint::operator~() const noexcept {
+  // ~x = -x - 1, so |x| moves one away from or towards zero
+  bigint res = *this;
+  WORD *const r = res.val.data();
+  if (sign) {
+    bigint_detail::sub_1(r, r, res.val.size(), 1);
+    res.trim();
+    res.sign = false;
+  } else {
+    const WORD carry = bigint_detail::add_1(r, r, res.val.size(), 1);
+    if (carry)
+      res.val.push_back(carry);
+    res.sign = true;
+  }
+  return res;
+}
+
+inline std::size_t bigint::popcount() const noexcept {
+  std::size_t count = 0;
+  for (const WORD w : val)
+    count += static_cast<std::size_t>(std::popcount(w));
+  return count;
+}
+
+inline std::size_t bigint::bit_length() const noexcept {
+  return (val.size() - 1) * WORD_BITS +
+         static_cast<std::size_t>(std::bit_width(val.back()));
+}
+
+inline bool bigint::test_bit(const std::size_t i) const noexcept {
+  const std::size_t j = i / WORD_BITS;
+  const bool bit = j < val.size() && ((val[j] >> (i % WORD_BITS)) & 1);
+  if (!sign)
+    return bit;
+  // negation keeps the lowest one bit of |x| and flips every bit above it
+  const std::size_t low = countr_zero();
+  return i <= low ? i == low : !bit;
+}
+
+inline std::size_t bigint::countr_zero() const noexcept {
+  for (std::size_t i = 0; i < val.size(); i++) {
+    if (val[i])
+      return i * WORD_BITS + static_cast<std::size_t>(std::countr_zero(val[i]));
+  }
+  return 0;
+}
+
+#ifdef DOCTEST_LIBRARY_INCLUDED
+TEST_CASE("[bigint] shifts") {
+  const bigint a("123456789123456789123456789123456789");
+  const bigint b("-98765432109876543210987654321");
+  CHECK_EQ(a << 100, bigint("15650007283459994189877471372050321122800313854"
+                            "9903269485728497664"));
+  CHECK_EQ(b << 37, bigint("-13574217628391297014039129701390338752512"));
+  CHECK_EQ(a << 64, a * bigint("18446744073709551616"));
+  CHECK_EQ(a >> 70, bigint("104571967949794"));
+  CHECK_EQ(b >> 70, bigint("-83657576"));
+  CHECK_EQ(a >> 64, a / bigint("18446744073709551616"));
+  CHECK_EQ((a << 100) >> 100, a);
+  CHECK_EQ((b << 96) >> 96, b);
+  CHECK_EQ(a >> 1000, bigint(0));
+  CHECK_EQ(-a >> 1000, bigint(-1));
+  CHECK_EQ(bigint(-4) >> 2, bigint(-1));
+  CHECK_EQ(bigint(-5) >> 1, bigint(-3));
+  CHECK_EQ(bigint(-1) >> 1, bigint(-1));
+  CHECK_EQ(bigint(0) << 100, bigint(0));
+  CHECK_EQ(a << 0, a);
+  CHECK_EQ(b >> 0, b);
+
+  bigint c = a;
+  c <<= 33;
+  CHECK_EQ(c, a * bigint(8589934592));
+  c >>= 33;
+  CHECK_EQ(c, a);
+}
+
+TEST_CASE("[bigint] bitwise operators") {
+  const bigint a("123456789123456789123456789123456789");
+  const bigint b("-98765432109876543210987654321");
+  CHECK_EQ(a & b, bigint("123456709855586251268625869276467973"));
+  CHECK_EQ(a | b, bigint("-19497561572021712291140665505"));
+  CHECK_EQ(a ^ b, bigint("-123456729353147823290338160417133478"));
+  CHECK_EQ(-a & b, bigint("-123456808621018361145169080264122293"));
+  CHECK_EQ(-a | b, bigint("-79267870537854830919846988817"));
+  CHECK_EQ(-a ^ b, bigint("123456729353147823290338160417133476"));
+  CHECK_EQ(~b, bigint("98765432109876543210987654320"));
+  CHECK_EQ(~a, -a - bigint(1));
+  CHECK_EQ(~bigint(0), bigint(-1));
+  CHECK_EQ(~bigint(-1), bigint(0));
+  CHECK_EQ(a & bigint(0), bigint(0));
+  CHECK_EQ(a | bigint(0), a);
+  CHECK_EQ(b ^ b, bigint(0));
+  CHECK_EQ(b & bigint(-1), b);
+  CHECK_EQ(bigint(-4294967296) & bigint(-4294967296), bigint(-4294967296));
+
+  bigint c = a;
+  c &= b;
+  c |= bigint(1);
+  c ^= a;
+  CHECK_EQ(c, ((a & b) | bigint(1)) ^ a);
+}
+
+TEST_CASE("[bigint] bit queries") {
+  const bigint a("123456789123456789123456789123456789");
+  const bigint b("-98765432109876543210987654321");
+  CHECK_EQ(a.popcount(), 53u);
+  CHECK_EQ(a.bit_length(), 117u);
+  CHECK_EQ(b.popcount(), 52u);
+  CHECK_EQ(b.bit_length(), 97u);
+  CHECK_EQ(bigint(0).bit_length(), 0u);
+  CHECK_EQ(bigint(0).popcount(), 0u);
+  CHECK_EQ((a << 70).countr_zero(), 70u);
+  CHECK_EQ(b.countr_zero(), 0u);
+  CHECK_EQ(bigint(0).countr_zero(), 0u);
+
+  CHECK(b.test_bit(0));
+  CHECK(b.test_bit(50));
+  CHECK_FALSE(b.test_bit(96));
+  CHECK(b.test_bit(97));
+  CHECK(b.test_bit(200));
+  const bigint c = -(bigint(1) << 70);
+  CHECK_FALSE(c.test_bit(69));
+  CHECK(c.test_bit(70));
+  CHECK(c.test_bit(71));
+  CHECK_FALSE((a << 70).test_bit(69));
+  CHECK((a << 70).test_bit(70));
+  CHECK_FALSE(a.test_bit(1000));
+}
+#endif
+
+// greatest common divisor
+
+// Every reduction below replaces a pair (a, b) by N (a, b) for an integer
+// matrix N of determinant +-1, so gcd(a, b) is preserved whether or not the
+// steps match those of Euclid's algorithm exactly. A Track observes each
+// reduction: division(q) for an exact Euclid step, lehmer(s) for a run of
+// steps found by algorithm L and matrix(m) for the reduction by m^-1 of a
+// half-gcd.
+
+// records nothing, for gcd
+struct bigint::gcd_untracked {
+  void division(const bigint &) noexcept {}
+  void lehmer(const bigint_detail::lehmer_step &) noexcept {}
+  void matrix(const gcd_matrix &) noexcept {}
+};
+
+// A matrix M with (a_in, b_in) = M (a, b) for the reduced pair (a, b), and
+// so inverted to carry the reduction of leading bits over to whole values
+struct bigint::gcd_matrix {
+  bigint m00{1}, m01{0}, m10{0}, m11{1};
+  // whether det M = -1
+  bool odd = false;
+  bool identity = true;
+
+  // M = M [q 1; 1 0]
+  void division(const bigint &q) noexcept {
+    const auto step = [&q](bigint &x, bigint &y) {
+      bigint nx = bigint_expr::lazy(x) * q + y;
+      y = std::move(x);
+      x = std::move(nx);
+    };
+    step(m00, m01);
+    step(m10, m11);
+    odd = !odd;
+    identity = false;
+  }
+
+  // M = M L^-1 for the step matrix L = [a b; c d], with
+  // L^-1 = det L [d -b; -c a]
+  void lehmer(const bigint_detail::lehmer_step &s) noexcept {
+    const bigint a(s.a), b(s.b), c(s.c), d(s.d);
+    const auto combine = [&s](bigint &x, bigint &y, const bigint &p,
+                              const bigint &q, const bigint &r,
+                              const bigint &t) {
+      using bigint_expr::lazy;
+      bigint nx = lazy(x) * p - lazy(y) * q;
+      bigint ny = lazy(y) * t - lazy(x) * r;
+      if (s.odd) {
+        nx = -std::move(nx);
+        ny = -std::move(ny);
+      }
+      x = std::move(nx);
+      y = std::move(ny);
+    };
+    combine(m00, m01, d, c, b, a);
+    combine(m10, m11, d, c, b, a);
+    odd = odd != s.odd;
+    identity = false;
+  }
+
+  // M = M R
+  void matrix(const gcd_matrix &r) noexcept {
+    using bigint_expr::lazy;
+    bigint n00 = lazy(m00) * r.m00 + lazy(m01) * r.m10;
+    bigint n01 = lazy(m00) * r.m01 + lazy(m01) * r.m11;
+    bigint n10 = lazy(m10) * r.m00 + lazy(m11) * r.m10;
+    m11 = lazy(m10) * r.m01 + lazy(m11) * r.m11;
+    m00 = std::move(n00);
+    m01 = std::move(n01);
+    m10 = std::move(n10);
+    odd = odd != r.odd;
+    identity = identity && r.identity;
+  }
+
+  // (a, b) = M^-1 (a, b) = det M (m11 a - m01 b, m00 b - m10 a). Steps found
+  // from leading bits alone may overshoot at the end, so signs and order are
+  // then restored, with M adjusted to match.
+  void apply_inverse(bigint &a, bigint &b) noexcept {
+    using bigint_expr::lazy;
+    bigint x = lazy(m11) * a - lazy(m01) * b;
+    bigint y = lazy(m00) * b - lazy(m10) * a;
+    if (odd) {
+      x = -std::move(x);
+      y = -std::move(y);
+    }
+    if (x.sign) {
+      x = -std::move(x);
+      m00 = -std::move(m00);
+      m10 = -std::move(m10);
+      odd = !odd;
+    }
+    if (y.sign) {
+      y = -std::move(y);
+      m01 = -std::move(m01);
+      m11 = -std::move(m11);
+      odd = !odd;
+    }
+    if (x < y) {
+      std::swap(x, y);
+      std::swap(m00, m01);
+      std::swap(m10, m11);
+      odd = !odd;
+    }
+    a = std::move(x);
+    b = std::move(y);
+  }
+};
+
+// x and y with u = x a0 (mod b0) and v = y a0 (mod b0) for the reduced pair
+// (u, v) of the original operands (a0, b0), for the Bezout coefficients
+struct bigint::gcd_cofactors {
+  bigint x, y;
+
+  // (x, y) = (y, x - q y)
+  void division(const bigint &q) noexcept {
+    bigint::submul(x, q, y);
+    std::swap(x, y);
+  }
+
+  // (x, y) = (a x + b y, c x + d y)
+  void lehmer(const bigint_detail::lehmer_step &s) noexcept {
+    using bigint_expr::lazy;
+    const bigint a(s.a), b(s.b), c(s.c), d(s.d);
+    bigint nx = lazy(x) * a + lazy(y) * b;
+    y = lazy(x) * c + lazy(y) * d;
+    x = std::move(nx);
+  }
+
+  // (x, y) = R^-1 (x, y)
+  void matrix(const gcd_matrix &r) noexcept {
+    using bigint_expr::lazy;
+    bigint nx = lazy(r.m11) * x - lazy(r.m01) * y;
+    y = lazy(r.m00) * y - lazy(r.m10) * x;
+    x = std::move(nx);
+    if (r.odd) {
+      x = -std::move(x);
+      y = -std::move(y);
+    }
+  }
+};
+
+// the low 64 bits of |*this| >> shift
+inline std::uint64_t bigint::bits_at(const std::size_t shift) const noexcept {
+  const std::size_t j = shift / WORD_BITS;
+  const auto cnt = static_cast<unsigned>(shift % WORD_BITS);
+  const auto at = [this](std::size_t i) -> DWORD {
+    return i < val.size() ? val[i] : 0;
+  };
+  DWORD res = at(j) | at(j + 1) << WORD_BITS;
+  if (cnt)
+    res = (res >> cnt) | at(j + 2) << (2 * WORD_BITS - cnt);
+  return res;
+}
+
+// r = x u + y v for the cofactors of a Lehmer step, which have opposite
+// signs and give a non-negative result, with |v| <= |u|
+inline void bigint::lehmer_comb(bigint_detail::limb_vector &r, const bigint &u,
+                                const bigint &v, const std::int64_t x,
+                                const std::int64_t y) noexcept {
+  const std::size_t n = u.val.size();
+  const std::size_t m = v.val.size();
+  r.resize(n + 1);
+  WORD *const p = r.data();
+  if (y <= 0) {
+    // x u - |y| v
+    p[n] = bigint_detail::mul_1(p, u.val.data(), n, static_cast<WORD>(x));
+    const WORD borrow = bigint_detail::submul_1(p, v.val.data(), m,
+                                                static_cast<WORD>(-y));
+    bigint_detail::sub_1(p + m, p + m, n + 1 - m, borrow);
+  } else {
+    // y v - |x| u
+    p[m] = bigint_detail::mul_1(p, v.val.data(), m, static_cast<WORD>(y));
+    std::fill(p + m + 1, p + n + 1, WORD{0});
+    p[n] -= bigint_detail::submul_1(p, u.val.data(), n, static_cast<WORD>(-x));
+  }
+}
+
+// (a, b) = (b, a mod b)
+template <typename Track>
+void bigint::gcd_division_step(bigint &a, bigint &b, Track &track) noexcept {
+  auto [q, r] = divmod(a, b);
+  track.division(q);
+  a = std::move(b);
+  b = std::move(r);
+}
+
+// Lehmer's algorithm on a >= b >= 0 until b has at most s bits. The two
+// scratch vectors take turns holding a and b, so the loop allocates only
+// while they grow.
+template <typename Track>
+void bigint::gcd_lehmer(bigint &a, bigint &b, const std::size_t s,
+                        Track &track) noexcept {
+  bigint_detail::limb_vector ta, tb;
+  while (b.bit_length() > s) {
+    const std::size_t n = a.bit_length();
+    const std::size_t shift = n > 62 ? n - 62 : 0;
+    bigint_detail::lehmer_step step{};
+    if (!bigint_detail::lehmer(a.bits_at(shift), b.bits_at(shift), step)) {
+      // a quotient too large for the leading bits
+      gcd_division_step(a, b, track);
+      continue;
+    }
+    lehmer_comb(ta, a, b, step.a, step.b);
+    lehmer_comb(tb, a, b, step.c, step.d);
+    std::swap(a.val, ta);
+    std::swap(b.val, tb);
+    a.trim();
+    b.trim();
+    track.lehmer(step);
+  }
+}
+
+// The half-gcd: reduces a >= b >= 0 until b has at most half the bits a had
+// on entry. The leading half of a and b is reduced recursively to a quarter,
+// and the resulting matrix is applied to the whole values. A second
+// recursion on the leading bits of the result then gets b down to half the
+// size, so that the whole reduction costs O(M(n) log n).
+template <typename Track>
+void bigint::hgcd(bigint &a, bigint &b, Track &track) noexcept {
+  const std::size_t threshold = std::max<std::size_t>(gcd_threshold, 2);
+  const std::size_t n = a.bit_length();
+  const std::size_t s = n / 2;
+  while (b.bit_length() > s) {
+    if (b.val.size() < threshold) {
+      gcd_lehmer(a, b, s, track);
+      return;
+    }
+    // reducing the top 2 (m - s) bits by half leaves b with about s bits
+    const std::size_t m = a.bit_length();
+    const std::size_t top = std::min(2 * (m - s), n - s);
+    gcd_matrix r;
+    {
+      bigint a1 = a >> (m - top);
+      bigint b1 = b >> (m - top);
+      hgcd(a1, b1, r);
+    }
+    if (r.identity) {
+      // b is much shorter than a
+      gcd_division_step(a, b, track);
+      continue;
+    }
+    r.apply_inverse(a, b);
+    track.matrix(r);
+    if (a.bit_length() >= m && b.bit_length() > s) {
+      // the corrections at the end undid the progress
+      gcd_division_step(a, b, track);
+    }
+  }
+}
+
+// Reduces a >= b >= 0 until b has at most s bits, halving the size with hgcd
+// above gcd_threshold limbs.
+template <typename Track>
+void bigint::gcd_reduce(bigint &a, bigint &b, const std::size_t s,
+                        Track &track) noexcept {
+  const std::size_t threshold = std::max<std::size_t>(gcd_threshold, 2);
+  while (b.bit_length() > s) {
+    if (b.val.size() < threshold) {
+      gcd_lehmer(a, b, s, track);
+      return;
+    }
+    const std::size_t m = a.bit_length();
+    hgcd(a, b, track);
+    if (a.bit_length() >= m && b.bit_length() > s) {
+      // b was already shorter than half of a
+      gcd_division_step(a, b, track);
+    }
+  }
+}
+
+inline bigint gcd(const bigint &a, const bigint &b) noexcept {
+  bigint u = a.sign ? -a : a;
+  bigint v = b.sign ? -b : b;
+  if (u < v)
+    std::swap(u, v);
+  bigint::gcd_untracked track;
+  bigint::gcd_reduce(u, v, bigint::WORD_BITS, track);
+  if (v.is_zero())
+    return u;
+  const bigint::WORD w = v.val[0];
+  const bigint::WORD r =
+      bigint_detail::divrem_1(u.val.data(), u.val.data(), u.val.size(), w);
+  return bigint(std::gcd(w, r));
+}
+
+inline bigint lcm(const bigint &a, const bigint &b) noexcept {
+  if (a.is_zero() || b.is_zero())
+    return bigint();
+  bigint res = a / gcd(a, b) * b;
+  res.sign = false;
+  return res;
+}
+
+// gcd(a, b) and some x with a x = gcd(a, b) mod b, for b != 0
+inline std::pair<bigint, bigint> bigint::gcd_cofactor(const bigint &a,
+                                                      const bigint &b) noexcept {
+  bigint u = a.sign ? -a : a;
+  bigint v = b.sign ? -b : b;
+  gcd_cofactors track{bigint(a.sign ? -1 : 1), bigint(0)};
+  if (u < v) {
+    std::swap(u, v);
+    std::swap(track.x, track.y);
+  }
+  gcd_reduce(u, v, 0, track);
+  return {std::move(u), std::move(track.x)};
+}
+
+inline std::tuple<bigint, bigint, bigint>
+extended_gcd(const bigint &a, const bigint &b) noexcept {
+  if (b.is_zero())
+    return {a.sign ? -a : a, bigint(a.is_zero() ? 0 : a.sign ? -1 : 1),
+            bigint(0)};
+  auto [g, x] = bigint::gcd_cofactor(a, b);
+  // the smallest non-negative x, then y exactly
+  bigint step = b / g;
+  step.sign = false;
+  x %= step;
+  if (x.sign)
+    x += step;
+  bigint y = g;
+  bigint::submul(y, a, x);
+  y /= b;
+  return {std::move(g), std::move(x), std::move(y)};
+}
+
+inline bigint mod_inverse(const bigint &a, const bigint &m) noexcept(false) {
+  if (m.is_zero())
+    throw std::domain_error("division by zero");
+  auto [g, x] = bigint::gcd_cofactor(a, m);
+  if (g != 1)
+    throw std::domain_error("not invertible");
+  bigint mod = m.sign ? -m : m;
+  x %= mod;
+  if (x.sign)
+    x += mod;
+  return x;
+}
+
+#ifdef DOCTEST_LIBRARY_INCLUDED
+TEST_CASE("[bigint] gcd and lcm") {
+  CHECK_EQ(gcd(bigint(12), bigint(18)), bigint(6));
+  CHECK_EQ(gcd(bigint(-12), bigint(18)), bigint(6));
+  CHECK_EQ(gcd(bigint(12), bigint(-18)), bigint(6));
+  CHECK_EQ(gcd(bigint(0), bigint(-18)), bigint(18));
+  CHECK_EQ(gcd(bigint(-7), bigint(0)), bigint(7));
+  CHECK_EQ(gcd(bigint(0), bigint(0)), bigint(0));
+  CHECK_EQ(gcd(bigint("123456789123456789123456789"),
+               bigint("987654321987654321987654321")),
+           bigint("9000000009000000009"));
+  CHECK_EQ(lcm(bigint(4), bigint(-6)), bigint(12));
+  CHECK_EQ(lcm(bigint(0), bigint(6)), bigint(0));
+  CHECK_EQ(lcm(bigint("123456789123456789123456789"),
+               bigint("987654321987654321987654321")),
+           bigint("13548070137174211137174211123626141"));
+}
+
+TEST_CASE("[bigint] gcd algorithm tiers") {
+  const auto saved = bigint::gcd_threshold;
+  // gcd(F(m), F(n)) = F(gcd(m, n)) for Fibonacci numbers, whose quotients
+  // are all 1, and a common factor on top of random-looking values
+  std::vector<bigint> fib{bigint(0), bigint(1)};
+  while (fib.size() <= 3000)
+    fib.push_back(fib[fib.size() - 1] + fib[fib.size() - 2]);
+  const bigint x = pow(bigint(3), 2000) + bigint(12345);
+  const bigint y = pow(bigint(7), 1100) - bigint(1);
+  const bigint z = pow(bigint(11), 300) + bigint(2);
+  const bigint g = gcd(x * z, y * z);
+  for (const std::size_t t : std::vector<std::size_t>{1000, 2, 4, 9}) {
+    bigint::gcd_threshold = t;
+    CHECK_EQ(gcd(fib[3000], fib[2999]), bigint(1));
+    CHECK_EQ(gcd(fib[3000], fib[2400]), fib[600]);
+    CHECK_EQ(gcd(x * z, y * z), g);
+    CHECK_EQ(g % z, bigint(0));
+    CHECK_EQ(gcd(x * z, z), z);
+    const auto [h, s, t2] = extended_gcd(x * z, -y * z);
+    CHECK_EQ(h, g);
+    CHECK_EQ(x * z * s - y * z * t2, g);
+  }
+  bigint::gcd_threshold = saved;
+}
+
+TEST_CASE("[bigint] extended_gcd and mod_inverse") {
+  auto [g, x, y] = extended_gcd(bigint(240), bigint(46));
+  CHECK_EQ(g, bigint(2));
+  CHECK_EQ(x, bigint(14));
+  CHECK_EQ(y, bigint(-73));
+  std::tie(g, x, y) = extended_gcd(bigint(-240), bigint(46));
+  CHECK_EQ(g, bigint(2));
+  CHECK_EQ(bigint(-240) * x + bigint(46) * y, g);
+  std::tie(g, x, y) = extended_gcd(bigint(-5), bigint(0));
+  CHECK_EQ(g, bigint(5));
+  CHECK_EQ(x, bigint(-1));
+  CHECK_EQ(y, bigint(0));
+  std::tie(g, x, y) = extended_gcd(bigint(0), bigint(0));
+  CHECK_EQ(g, bigint(0));
+  std::tie(g, x, y) = extended_gcd(bigint(0), bigint(-3));
+  CHECK_EQ(g, bigint(3));
+  CHECK_EQ(bigint(-3) * y, g);
+
+  CHECK_EQ(mod_inverse(bigint(3), bigint(11)), bigint(4));
+  CHECK_EQ(mod_inverse(bigint(-3), bigint(11)), bigint(7));
+  CHECK_EQ(mod_inverse(bigint(3), bigint(-11)), bigint(4));
+  CHECK_EQ(mod_inverse(bigint(5), bigint(1)), bigint(0));
+  const bigint p = pow(bigint(2), 521) - bigint(1);
+  const bigint a("123456789123456789123456789");
+  CHECK_EQ(mod_inverse(a, p) * a % p, bigint(1));
+  CHECK_EQ(mod_inverse(a, p), powmod(a, p - bigint(2), p));
+  CHECK_THROWS_AS(bigint _ = mod_inverse(bigint(6), bigint(9)),
+                  std::domain_error);
+  CHECK_THROWS_AS(bigint _ = mod_inverse(bigint(6), bigint(0)),
+                  std::domain_error);
+}
+#endif
+
+// roots
+
+inline bigint bigint::isqrt_abs(const bigint &a) noexcept {
+  if (a.val.size() <= 2) {
+    const std::uint64_t v =
+        a.val.size() == 2 ? (DWORD{a.val[1]} << WORD_BITS) | a.val[0] : a.val[0];
+    auto r = static_cast<std::uint64_t>(std::sqrt(static_cast<double>(v)));
+    while (r && r > v / r)
+      r--;
+    while (r + 1 <= v / (r + 1))
+      r++;
+    return bigint(static_cast<std::int64_t>(r));
+  }
+  // With x0 = (isqrt(a / 4^k) + 1) 2^k, 0 <= x0 - sqrt(a) <= 2^k and one
+  // Newton step leaves an error of at most 4^k / 2 x0 <= 1/2.
+  const std::size_t k = (a.bit_length() - 1) / 4;
+  bigint x = isqrt_abs(a >> (2 * k));
+  x += 1;
+  x <<= k;
+  x += a / x;
+  x >>= 1;
+  while (x * x > a)
+    x -= 1;
+  return x;
+}
+
+inline bigint bigint::iroot_abs(const bigint &a, const std::uint64_t k) noexcept {
+  if (k == 1)
+    return a;
+  if (k == 2)
+    return isqrt_abs(a);
+  const std::size_t n = a.bit_length();
+  if (n <= k)
+    return bigint(a.is_zero() ? 0 : 1);
+  // the root has rb + 1 bits
+  const std::size_t rb = (n - 1) / k;
+  bigint x;
+  if (rb < 40) {
+    // a floating point estimate, off by a few units at most
+    const std::size_t shift = n > 64 ? n - 64 : 0;
+    const double lg =
+        static_cast<double>(shift) +
+        std::log2(static_cast<double>(a.bits_at(shift)));
+    x = bigint(static_cast<std::int64_t>(std::exp2(lg / static_cast<double>(k))));
+    while (pow(x + 1, k) <= a)
+      x += 1;
+  } else {
+    // as in isqrt_abs, with a Newton error of at most (k - 1) 4^j / 2 x0
+    const std::size_t j =
+        (rb - static_cast<std::size_t>(std::bit_width(k))) / 2;
+    x = iroot_abs(a >> (k * j), k);
+    x += 1;
+    x <<= j;
+    x = ((k - 1) * x + a / pow(x, k - 1)) / k;
+  }
+  while (pow(x, k) > a)
+    x -= 1;
+  return x;
+}
+
+inline bigint isqrt(const bigint &a) noexcept(false) {
+  if (a.sign)
+    throw std::domain_error("square root of negative value");
+  return bigint::isqrt_abs(a);
+}
+
+inline bigint iroot(const bigint &a, const std::uint64_t k) noexcept(false) {
+  if (k == 0)
+    throw std::domain_error("zeroth root");
+  if (a.sign && k % 2 == 0)
+    throw std::domain_error("even root of negative value");
+  bigint r = bigint::iroot_abs(a.sign ? -a : a, k);
+  if (a.sign)
+    r = -std::move(r);
+  return r;
+}
+
+inline bool is_perfect_square(const bigint &a) noexcept {
+  if (a.sign)
+    return false;
+  if (!bigint_detail::squares_mod_64[a.val[0] % 64])
+    return false;
+  const bigint::WORD r = bigint_detail::mod_limb_max(a.val.data(), a.val.size());
+  if (!bigint_detail::squares_mod_255[r % 255] ||
+      !bigint_detail::squares_mod_257[r % 257])
+    return false;
+  const bigint x = bigint::isqrt_abs(a);
+  return x * x == a;
+}
+
+inline bool is_perfect_power(const bigint &a) noexcept {
+  const bigint n = a.sign ? -a : a;
+  if (n.val.size() == 1 && n.val[0] <= 1)
+    return true;
+  // r^p with r >= 2 has at least p + 1 bits, and p divides the number of
+  // trailing zeros
+  const std::size_t zeros = n.countr_zero();
+  const std::size_t max_p =
+      zeros ? std::min(zeros, n.bit_length() - 1) : n.bit_length() - 1;
+  std::vector<bool> composite(max_p + 1);
+  for (std::size_t p = 2; p <= max_p; p++) {
+    if (composite[p])
+      continue;
+    for (std::size_t q = p * p; q <= max_p; q += p)
+      composite[q] = true;
+    if ((zeros && zeros % p) || (a.sign && p == 2))
+      continue;
+    if (p == 2 ? is_perfect_square(n) : pow(bigint::iroot_abs(n, p), p) == n)
+      return true;
+  }
+  return false;
+}
+
+#ifdef DOCTEST_LIBRARY_INCLUDED
+TEST_CASE("[bigint] isqrt and iroot") {
+  CHECK_EQ(isqrt(bigint(0)), bigint(0));
+  CHECK_EQ(isqrt(bigint(1)), bigint(1));
+  CHECK_EQ(isqrt(bigint(15)), bigint(3));
+  CHECK_EQ(isqrt(bigint(16)), bigint(4));
+  CHECK_EQ(isqrt(bigint("18446744073709551615")), bigint(4294967295));
+  CHECK_EQ(isqrt(bigint("18446744073709551616")), bigint(4294967296));
+  CHECK_EQ(isqrt(bigint("123456789123456789123456789123456789")),
+           bigint("351364183040128307"));
+  CHECK_THROWS_AS(bigint _ = isqrt(bigint(-1)), std::domain_error);
+
+  CHECK_EQ(iroot(bigint(26), 3), bigint(2));
+  CHECK_EQ(iroot(bigint(27), 3), bigint(3));
+  CHECK_EQ(iroot(bigint(-28), 3), bigint(-3));
+  CHECK_EQ(iroot(bigint(0), 5), bigint(0));
+  CHECK_EQ(iroot(bigint(-7), 1), bigint(-7));
+  CHECK_EQ(iroot(bigint(1), 100), bigint(1));
+  CHECK_EQ(iroot(pow(bigint(2), 1000), 999), bigint(2));
+  CHECK_EQ(iroot(bigint("123456789123456789123456789123456789"), 5),
+           bigint("10430448"));
+  CHECK_THROWS_AS(bigint _ = iroot(bigint(-4), 2), std::domain_error);
+  CHECK_THROWS_AS(bigint _ = iroot(bigint(4), 0), std::domain_error);
+
+  // exact powers and their neighbours across the recursion levels
+  for (const std::uint64_t k : std::vector<std::uint64_t>{2, 3, 7, 64}) {
+    for (const std::uint64_t e : std::vector<std::uint64_t>{3, 40, 500}) {
+      const bigint x = pow(bigint(3), e) + bigint(5);
+      const bigint y = pow(x, k);
+      CHECK_EQ(iroot(y, k), x);
+      CHECK_EQ(iroot(y - bigint(1), k), x - bigint(1));
+      CHECK_EQ(iroot(pow(x + bigint(1), k) - bigint(1), k), x);
+      if (k == 2) {
+        CHECK_EQ(isqrt(y), x);
+        CHECK_EQ(isqrt(y - bigint(1)), x - bigint(1));
+        CHECK_EQ(isqrt(y + x + x), x);
+      }
+    }
+  }
+}
+
+TEST_CASE("[bigint] perfect squares and powers") {
+  CHECK(is_perfect_square(bigint(0)));
+  CHECK(is_perfect_square(bigint(1)));
+  CHECK(is_perfect_square(bigint(144)));
+  CHECK_FALSE(is_perfect_square(bigint(145)));
+  CHECK_FALSE(is_perfect_square(bigint(-4)));
+  std::size_t squares = 0;
+  for (std::int64_t i = 0; i < 10000; i++)
+    squares += is_perfect_square(bigint(i));
+  CHECK_EQ(squares, 100);
+  const bigint x("100000000000000000039");
+  CHECK(is_perfect_square(x * x));
+  CHECK_FALSE(is_perfect_square(x * x + bigint(1)));
+  CHECK_FALSE(is_perfect_square(x * x - bigint(1)));
+  CHECK_FALSE(is_perfect_square(x * (x + bigint(2))));
+
+  CHECK(is_perfect_power(bigint(0)));
+  CHECK(is_perfect_power(bigint(1)));
+  CHECK(is_perfect_power(bigint(-1)));
+  CHECK(is_perfect_power(bigint(8)));
+  CHECK(is_perfect_power(bigint(-8)));
+  CHECK_FALSE(is_perfect_power(bigint(-4)));
+  CHECK_FALSE(is_perfect_power(bigint(2)));
+  CHECK_FALSE(is_perfect_power(bigint(12)));
+  std::size_t powers = 0;
+  for (std::int64_t i = 2; i <= 1000; i++)
+    powers += is_perfect_power(bigint(i));
+  CHECK_EQ(powers, 40);
+  CHECK(is_perfect_power(pow(x, 5)));
+  CHECK(is_perfect_power(-pow(x, 7)));
+  CHECK(is_perfect_power(pow(bigint(2), 1000)));
+  CHECK(is_perfect_power(pow(bigint(6), 35)));
+  CHECK_FALSE(is_perfect_power(pow(bigint(2), 1000) * bigint(3)));
+  CHECK_FALSE(is_perfect_power(pow(x, 5) + bigint(1)));
+  CHECK_FALSE(is_perfect_power(-(x * x)));
+}
+#endif
+
+// factorials
+
+// the product of f[0..n), packing runs of factors into single words at the
+// leaves
+inline bigint bigint::word_product(const std::uint64_t *f,
+                                   const std::size_t n) noexcept {
+  constexpr std::size_t LEAF = 16;
+  if (n > LEAF) {
+    const std::size_t h = n / 2;
+    return word_product(f, h) * word_product(f + h, n - h);
+  }
+  bigint res(1);
+  WORD acc = 1;
+  for (std::size_t i = 0; i < n; i++) {
+    if (f[i] > std::numeric_limits<WORD>::max()) {
+      res *= from_element(f[i]);
+    } else if (static_cast<DWORD>(acc) * f[i] >
+               std::numeric_limits<WORD>::max()) {
+      res *= acc;
+      acc = static_cast<WORD>(f[i]);
+    } else {
+      acc *= static_cast<WORD>(f[i]);
+    }
+  }
+  res *= acc;
+  return res;
+}
+
+// n! / 2^(n - popcount(n)), with primes holding at least the odd primes up
+// to n
+inline bigint bigint::odd_factorial(const std::uint32_t n,
+                                    const std::vector<WORD> &primes) noexcept {
+  if (n < 3)
+    return bigint(1);
+  // p divides swing(n) = n! / (n/2)!^2 to the power sum_i floor(n / p^i) mod 2
+  std::vector<std::uint64_t> swing;
+  for (const WORD p : primes) {
+    if (p > n)
+      break;
+    for (std::uint32_t q = n / p; q > 0; q /= p) {
+      if (q & 1)
+        swing.push_back(p);
+    }
+  }
+  bigint half = odd_factorial(n / 2, primes);
+  bigint res = half * half;
+  res *= word_product(swing.data(), swing.size());
+  return res;
+}
+
+inline bigint bigint::factorial(const std::uint32_t n) noexcept {
+  bigint res = odd_factorial(n, bigint_detail::odd_primes(n));
+  res <<= n - static_cast<std::uint32_t>(std::popcount(n));
+  return res;
+}
+
+inline bigint bigint::binomial(const std::uint64_t n, std::uint64_t k) noexcept {
+  if (k > n)
+    return bigint(0);
+  k = std::min(k, n - k);
+  if (n > std::numeric_limits<std::uint32_t>::max() || k < n / 64) {
+    // the sieve up to n would cost more than the k factors and the division
+    std::vector<std::uint64_t> f(k);
+    for (std::uint64_t i = 0; i < k; i++)
+      f[i] = n - i;
+    bigint den;
+    if (k <= std::numeric_limits<std::uint32_t>::max()) {
+      den = factorial(static_cast<std::uint32_t>(k));
+    } else {
+      for (std::uint64_t i = 0; i < k; i++)
+        f[i] = i + 1;
+      den = word_product(f.data(), f.size());
+      for (std::uint64_t i = 0; i < k; i++)
+        f[i] = n - i;
+    }
+    return word_product(f.data(), f.size()) / den;
+  }
+  // Legendre: p divides the result to the power
+  // sum_i floor(n / p^i) - floor(k / p^i) - floor((n - k) / p^i)
+  std::vector<std::uint64_t> f;
+  for (const WORD p : bigint_detail::odd_primes(static_cast<WORD>(n))) {
+    for (std::uint64_t a = n / p, b = k / p, c = (n - k) / p; a > 0;
+         a /= p, b /= p, c /= p) {
+      for (std::uint64_t e = a - b - c; e > 0; e--)
+        f.push_back(p);
+    }
+  }
+  bigint res = word_product(f.data(), f.size());
+  res <<= static_cast<std::size_t>(std::popcount(k) + std::popcount(n - k) -
+                                   std::popcount(n));
+  return res;
+}
+
+inline bigint bigint::primorial(const std::uint32_t n) noexcept {
+  const std::vector<WORD> primes = bigint_detail::odd_primes(n);
+  const std::vector<std::uint64_t> f(primes.begin(), primes.end());
+  bigint res = word_product(f.data(), f.size());
+  if (n >= 2)
+    res <<= 1;
+  return res;
+}
+
+#ifdef DOCTEST_LIBRARY_INCLUDED
+TEST_CASE("[bigint] factorial, binomial and primorial") {
+  CHECK_EQ(bigint::factorial(0), bigint(1));
+  CHECK_EQ(bigint::factorial(1), bigint(1));
+  CHECK_EQ(bigint::factorial(2), bigint(2));
+  CHECK_EQ(bigint::factorial(20), bigint(2432902008176640000));
+  CHECK_EQ(bigint::factorial(30),
+           bigint("265252859812191058636308480000000"));
+  bigint f(1);
+  for (std::int64_t i = 1; i <= 3000; i++) {
+    f *= bigint(i);
+    if (i % 97 == 0 || i == 3000)
+      CHECK_EQ(bigint::factorial(static_cast<std::uint32_t>(i)), f);
+  }
+
+  CHECK_EQ(bigint::binomial(0, 0), bigint(1));
+  CHECK_EQ(bigint::binomial(5, 6), bigint(0));
+  CHECK_EQ(bigint::binomial(10, 3), bigint(120));
+  CHECK_EQ(bigint::binomial(10, 10), bigint(1));
+  CHECK_EQ(bigint::binomial(100, 50),
+           bigint("100891344545564193334812497256"));
+  CHECK_EQ(bigint::binomial(4294967296, 1), bigint(4294967296));
+  CHECK_EQ(bigint::binomial(std::numeric_limits<std::uint64_t>::max(), 2),
+           bigint("170141183460469231704017187605319778305"));
+  // the factorization and the division agree when both apply
+  for (const std::uint64_t n : {std::uint64_t{1000}, std::uint64_t{4099}}) {
+    for (const std::uint64_t k : {std::uint64_t{1}, std::uint64_t{15},
+                                  std::uint64_t{64}, n / 3, n / 2}) {
+      CHECK_EQ(bigint::binomial(n, k),
+               bigint::factorial(static_cast<std::uint32_t>(n)) /
+                   (bigint::factorial(static_cast<std::uint32_t>(k)) *
+                    bigint::factorial(static_cast<std::uint32_t>(n - k))));
+    }
+  }
+
+  CHECK_EQ(bigint::primorial(0), bigint(1));
+  CHECK_EQ(bigint::primorial(1), bigint(1));
+  CHECK_EQ(bigint::primorial(2), bigint(2));
+  CHECK_EQ(bigint::primorial(30), bigint(6469693230));
+  CHECK_EQ(bigint::primorial(100),
+           bigint("2305567963945518424753102147331756070"));
+}
+#endif
+
+// memory resources
+
+#ifdef DOCTEST_LIBRARY_INCLUDED
+namespace {
+// counts the bytes outstanding from new_delete_resource
+class counting_resource : public std::pmr::memory_resource {
+public:
+  std::size_t outstanding = 0;
+  std::size_t allocations = 0;
+
+private:
+  void *do_allocate(std::size_t bytes, std::size_t align) override {
+    outstanding += bytes;
+    allocations++;
+    return std::pmr::new_delete_resource()->allocate(bytes, align);
+  }
+  void do_deallocate(void *p, std::size_t bytes, std::size_t align) override {
+    outstanding -= bytes;
+    std::pmr::new_delete_resource()->deallocate(p, bytes, align);
+  }
+  [[nodiscard]] bool
+  do_is_equal(const std::pmr::memory_resource &other) const noexcept override {
+    return this == &other;
+  }
+};
+} // namespace
+
+TEST_CASE("[bigint] memory resources") {
+  const bigint a = pow(bigint(3), 5000);
+  const bigint b = pow(bigint(7), 3000);
+  const bigint expected = a * b + a;
+  counting_resource res;
+  bigint outside;
+  std::unique_ptr<bigint> kept;
+  {
+    const bigint_memory_scope scope(&res);
+    CHECK_EQ(bigint_memory_scope::current(), &res);
+    bigint c = a * b;
+    c += a;
+    CHECK_EQ(c, expected);
+    CHECK_GT(res.outstanding, 0u);
+    // move assignment across resources copies, move construction keeps the
+    // storage
+    outside = std::move(c);
+    kept = std::make_unique<bigint>(a * b + a);
+  }
+  CHECK_EQ(bigint_memory_scope::current(), nullptr);
+  CHECK_EQ(outside, expected);
+  CHECK_EQ(*kept, expected);
+  CHECK_GT(res.outstanding, 0u);
+  kept.reset();
+  CHECK_EQ(res.outstanding, 0u);
+
+  // intermediates of divisions and conversions come from the resource too,
+  // except for the cached radix powers
+  std::string digits;
+  {
+    std::pmr::monotonic_buffer_resource arena;
+    const bigint_memory_scope scope(&arena);
+    digits = (expected / b).to_string(29);
+    {
+      const bigint_memory_scope inner(nullptr);
+      CHECK_EQ(bigint_memory_scope::current(), nullptr);
+    }
+    CHECK_EQ(bigint_memory_scope::current(), &arena);
+  }
+  CHECK_EQ(digits, (a + a / b).to_string(29));
+  CHECK_EQ(bigint(digits, 29), a + a / b);
+}
+
+TEST_CASE("[bigint] scratch workspace") {
+  const auto saved = bigint::thresholds;
+  bigint_workspace &ws = bigint_workspace::local();
+  const bigint a = pow(bigint(3), 20000);
+  const bigint b = pow(bigint(7), 9000);
+  const bigint expected = a * b;
+  // schoolbook with Karatsuba, Toom-3 and the NTT all take scratch space
+  for (const std::size_t ntt : std::vector<std::size_t>{100000, 500}) {
+    bigint::thresholds = {24, 100, ntt};
+    counting_resource res;
+    const bigint_memory_scope scope(&res);
+    bigint c;
+    std::size_t allocations = 0;
+    std::size_t capacity = 0;
+    for (int i = 0; i < 3; i++) {
+      c = a;
+      c *= b;
+      CHECK_EQ(c, expected);
+      if (i == 1) {
+        allocations = res.allocations;
+        capacity = ws.capacity();
+      }
+    }
+    // the second round on is served by the storage of c and the workspace
+    CHECK_EQ(res.allocations, allocations);
+    CHECK_EQ(ws.capacity(), capacity);
+    CHECK_EQ(ws.in_use(), 0u);
+    CHECK_GE(ws.peak(), a.bit_length() / 32);
+  }
+  bigint::thresholds = saved;
+
+  ws.release();
+  CHECK_EQ(ws.capacity(), 0u);
+  ws.reset_peak();
+  CHECK_EQ(ws.peak(), 0u);
+  {
+    bigint_workspace::frame f(ws);
+    bigint_detail::limb *const p = f.alloc(10);
+    bigint_detail::limb *const q = f.alloc(5000);
+    p[9] = q[4999] = 1;
+    CHECK_EQ(ws.in_use(), 5010u);
+    {
+      bigint_workspace::frame inner(ws);
+      static_cast<void>(inner.alloc(100));
+      CHECK_EQ(ws.in_use(), 5110u);
+    }
+    CHECK_EQ(ws.in_use(), 5010u);
+  }
+  CHECK_EQ(ws.in_use(), 0u);
+  CHECK_EQ(ws.peak(), 5110u);
+  CHECK_GE(ws.capacity(), 5110u);
+  CHECK_EQ(pow(bigint(3), 300) * pow(bigint(3), 200), pow(bigint(3), 500));
+}
+#endif
+
+// capacity and three-address arithmetic
+
+inline void bigint::reserve(const std::size_t limbs) noexcept {
+  val.reserve(limbs);
+}
+
+inline void bigint::shrink_to_fit() noexcept { val.shrink_to_fit(); }
+
+inline std::size_t bigint::capacity() const noexcept { return val.capacity(); }
+
+inline void bigint::add(bigint &dst, const bigint &a, const bigint &b) noexcept {
+  if (&dst == &b) {
+    dst.add_signed(a, a.sign);
+    return;
+  }
+  if (&dst != &a) {
+    dst.val.reserve(std::max(a.val.size(), b.val.size()) + 1);
+    dst.val.assign(a.val.begin(), a.val.end());
+    dst.sign = a.sign;
+  }
+  dst.add_signed(b, b.sign);
+}
+
+inline void bigint::sub(bigint &dst, const bigint &a, const bigint &b) noexcept {
+  if (&dst == &b) {
+    // a - b = -(b - a)
+    dst.add_signed(a, !a.sign);
+    dst.sign = !dst.sign && !dst.is_zero();
+    return;
+  }
+  if (&dst != &a) {
+    dst.val.reserve(std::max(a.val.size(), b.val.size()) + 1);
+    dst.val.assign(a.val.begin(), a.val.end());
+    dst.sign = a.sign;
+  }
+  dst.add_signed(b, !b.sign);
+}
+
+inline void bigint::mul(bigint &dst, const bigint &a, const bigint &b) noexcept {
+  if (&dst == &a) {
+    dst *= b;
+    return;
+  }
+  if (&dst == &b) {
+    dst *= a;
+    return;
+  }
+  if (a.is_zero() || b.is_zero()) {
+    dst.val.assign(1, 0);
+    dst.sign = false;
+    return;
+  }
+  const bigint &x = a.val.size() >= b.val.size() ? a : b;
+  const bigint &y = &x == &a ? b : a;
+  bigint_detail::count(bigint_detail::stat::mult_calls);
+  bigint_detail::count(bigint_detail::stat::mult_limbs,
+                       x.val.size() + y.val.size());
+  dst.val.resize(x.val.size() + y.val.size());
+  mul_limbs(dst.val.data(), x.val.data(), x.val.size(), y.val.data(),
+            y.val.size());
+  dst.trim();
+  dst.sign = a.sign != b.sign;
+}
+
+#ifdef DOCTEST_LIBRARY_INCLUDED
+TEST_CASE("[bigint] capacity and three-address arithmetic") {
+  bigint r;
+  CHECK_EQ(r.capacity(), bigint_detail::limb_vector::INLINE_LIMBS);
+  r.reserve(100);
+  CHECK_GE(r.capacity(), 100u);
+  r = bigint(5);
+  r.shrink_to_fit();
+  CHECK_EQ(r.capacity(), bigint_detail::limb_vector::INLINE_LIMBS);
+  CHECK_EQ(r, bigint(5));
+
+  const bigint a = pow(bigint(3), 600) + bigint(1);
+  const bigint b = -pow(bigint(7), 400);
+  bigint::add(r, a, b);
+  CHECK_EQ(r, a + b);
+  bigint::sub(r, a, b);
+  CHECK_EQ(r, a - b);
+  bigint::sub(r, b, a);
+  CHECK_EQ(r, b - a);
+  bigint::mul(r, a, b);
+  CHECK_EQ(r, a * b);
+  bigint::mul(r, b, b);
+  CHECK_EQ(r, b * b);
+  bigint::mul(r, a, bigint(0));
+  CHECK_EQ(r, bigint(0));
+  CHECK_EQ(r.to_string(), "0");
+
+  // dst may be either operand
+  bigint x = a;
+  bigint::add(x, x, b);
+  CHECK_EQ(x, a + b);
+  x = b;
+  bigint::add(x, a, x);
+  CHECK_EQ(x, a + b);
+  x = a;
+  bigint::sub(x, x, b);
+  CHECK_EQ(x, a - b);
+  x = b;
+  bigint::sub(x, a, x);
+  CHECK_EQ(x, a - b);
+  x = a;
+  bigint::sub(x, a, x);
+  CHECK_EQ(x, bigint(0));
+  CHECK_EQ(x.to_string(), "0");
+  x = a;
+  bigint::mul(x, x, b);
+  CHECK_EQ(x, a * b);
+  x = b;
+  bigint::mul(x, a, x);
+  CHECK_EQ(x, a * b);
+  x = a;
+  bigint::mul(x, x, x);
+  CHECK_EQ(x, a * a);
+
+  // a pre-sized accumulator never allocates again
+  const bigint expected = (a * b) * bigint(3) + a;
+  counting_resource res;
+  const bigint_memory_scope scope(&res);
+  bigint acc;
+  bigint prod;
+  acc.reserve(200);
+  prod.reserve(200);
+  const std::size_t allocations = res.allocations;
+  for (int i = 0; i < 10; i++) {
+    bigint::mul(prod, a, b);
+    bigint::add(acc, prod, prod);
+    bigint::add(acc, acc, prod);
+    bigint::add(acc, acc, a);
+  }
+  CHECK_EQ(acc, expected);
+  CHECK_EQ(res.allocations, allocations);
+}
+#endif
+
+// serialization
+
+inline bigint::bigint(const bigint_view v) noexcept : bigint() {
+  if (v.size_) {
+    val.assign(v.limbs_, v.limbs_ + v.size_);
+    sign = v.sign_;
+  }
+}
+
+inline bigint_view::bigint_view(const bigint &x) noexcept
+    : limbs_(x.val.data()), size_(x.is_zero() ? 0 : x.val.size()),
+      sign_(x.sign) {}
+
+// the number of limbs of the record at the start of in, after checking that
+// they are all there and that the value is in canonical form
+inline std::size_t bigint_view::read_header(const std::span<const std::byte> in,
+                                            bool &neg) noexcept(false) {
+  if (in.size() < HEADER)
+    throw std::invalid_argument("truncated bigint record");
+  std::uint64_t h = 0;
+  for (std::size_t i = HEADER; i-- > 0;)
+    h = h << 8 | std::to_integer<std::uint64_t>(in[i]);
+  const std::uint64_t n = h >> 1;
+  neg = h & 1;
+  if (n > (in.size() - HEADER) / sizeof(WORD))
+    throw std::invalid_argument("truncated bigint record");
+  if (n == 0 ? neg
+             : in[HEADER + n * sizeof(WORD) - 1] == std::byte{0} &&
+                   in[HEADER + n * sizeof(WORD) - 2] == std::byte{0} &&
+                   in[HEADER + n * sizeof(WORD) - 3] == std::byte{0} &&
+                   in[HEADER + n * sizeof(WORD) - 4] == std::byte{0})
+    throw std::invalid_argument("bigint record is not canonical");
+  return static_cast<std::size_t>(n);
+}
+
+inline bigint_view
+bigint_view::deserialize(const std::span<const std::byte> in) noexcept(false) {
+  if constexpr (std::endian::native != std::endian::little)
+    throw std::invalid_argument("bigint_view needs a little-endian host");
+  bool neg = false;
+  const std::size_t n = read_header(in, neg);
+  const std::byte *const p = in.data() + HEADER;
+  if (reinterpret_cast<std::uintptr_t>(p) % alignof(WORD))
+    throw std::invalid_argument("bigint record is not aligned");
+  return {reinterpret_cast<const WORD *>(p), n, neg};
+}
+
+inline std::size_t
+bigint_view::serialize(const std::span<std::byte> out) const noexcept(false) {
+  if (out.size() < HEADER || (out.size() - HEADER) / sizeof(WORD) < size_)
+    throw std::length_error("buffer too small for bigint record");
+  const std::uint64_t h = std::uint64_t{size_} << 1 | sign_;
+  for (std::size_t i = 0; i < HEADER; i++)
+    out[i] = static_cast<std::byte>(h >> (8 * i));
+  std::byte *const p = out.data() + HEADER;
+  if constexpr (std::endian::native == std::endian::little) {
+    if (size_)
+      std::memcpy(p, limbs_, size_ * sizeof(WORD));
+  } else {
+    for (std::size_t i = 0; i < size_ * sizeof(WORD); i++)
+      p[i] = static_cast<std::byte>(limbs_[i / sizeof(WORD)] >>
+                                    (8 * (i % sizeof(WORD))));
+  }
+  return serialized_size();
+}
+
+inline std::size_t bigint::serialized_size() const noexcept {
+  return bigint_view(*this).serialized_size();
+}
+
+inline std::size_t
+bigint::serialize(const std::span<std::byte> out) const noexcept(false) {
+  return bigint_view(*this).serialize(out);
+}
+
+inline bigint bigint::deserialize(const std::span<const std::byte> in) noexcept(false) {
+  bool neg = false;
+  const std::size_t n = bigint_view::read_header(in, neg);
+  bigint res;
+  if (!n)
+    return res;
+  res.val.resize(n);
+  const std::byte *const p = in.data() + bigint_view::HEADER;
+  if constexpr (std::endian::native == std::endian::little) {
+    std::memcpy(res.val.data(), p, n * sizeof(WORD));
+  } else {
+    for (std::size_t i = 0; i < n; i++) {
+      WORD w = 0;
+      for (std::size_t j = sizeof(WORD); j-- > 0;)
+        w = w << 8 | std::to_integer<WORD>(p[i * sizeof(WORD) + j]);
+      res.val[i] = w;
+    }
+  }
+  res.sign = neg;
+  return res;
+}
+
+// the ordering of |a| and |b|
+inline int bigint_view::cmp_abs(const bigint_view a, const bigint_view b) noexcept {
+  if (a.size_ != b.size_)
+    return a.size_ < b.size_ ? -1 : 1;
+  return bigint_detail::cmp_n(a.limbs_, b.limbs_, a.size_);
+}
+
+inline bool operator==(const bigint_view a, const bigint_view b) noexcept {
+  return a.sign_ == b.sign_ && bigint_view::cmp_abs(a, b) == 0;
+}
+
+inline std::strong_ordering operator<=>(const bigint_view a,
+                                        const bigint_view b) noexcept {
+  if (a.sign_ != b.sign_)
+    return a.sign_ ? std::strong_ordering::less : std::strong_ordering::greater;
+  const int c = a.sign_ ? bigint_view::cmp_abs(b, a) : bigint_view::cmp_abs(a, b);
+  return c <=> 0;
+}
+
+// a + |b| with the sign b_sign
+inline bigint bigint_view::add_signed(const bigint_view a, const bigint_view b,
+                                      const bool b_sign) noexcept {
+  if (!b.size_)
+    return bigint(a);
+  if (!a.size_)
+    return bigint(bigint_view(b.limbs_, b.size_, b_sign));
+  bigint res;
+  if (a.sign_ == b_sign) {
+    const bigint_view &x = a.size_ >= b.size_ ? a : b;
+    const bigint_view &y = &x == &a ? b : a;
+    res.val.resize(x.size_ + 1);
+    WORD *const r = res.val.data();
+    const WORD carry = bigint_detail::add_n(r, x.limbs_, y.limbs_, y.size_);
+    r[x.size_] = bigint_detail::add_1(r + y.size_, x.limbs_ + y.size_,
+                                      x.size_ - y.size_, carry);
+    res.sign = a.sign_;
+  } else {
+    const int c = cmp_abs(a, b);
+    if (c == 0)
+      return res;
+    const bigint_view &x = c > 0 ? a : b;
+    const bigint_view &y = c > 0 ? b : a;
+    res.val.resize(x.size_);
+    WORD *const r = res.val.data();
+    const WORD borrow = bigint_detail::sub_n(r, x.limbs_, y.limbs_, y.size_);
+    bigint_detail::sub_1(r + y.size_, x.limbs_ + y.size_, x.size_ - y.size_,
+                         borrow);
+    res.sign = c > 0 ? a.sign_ : b_sign;
+  }
+  res.trim();
+  return res;
+}
+
+inline bigint operator+(const bigint_view a, const bigint_view b) noexcept {
+  return bigint_view::add_signed(a, b, b.sign_);
+}
+
+inline bigint operator-(const bigint_view a, const bigint_view b) noexcept {
+  return bigint_view::add_signed(a, b, !b.sign_);
+}
+
+inline bigint operator*(const bigint_view a, const bigint_view b) noexcept {
+  return bigint_view::multiply(a, b);
+}
+
+inline bigint bigint_view::multiply(const bigint_view a,
+                                    const bigint_view b) noexcept {
+  bigint res;
+  if (!a.size_ || !b.size_)
+    return res;
+  const bigint_view &x = a.size_ >= b.size_ ? a : b;
+  const bigint_view &y = &x == &a ? b : a;
+  res.val.resize(x.size_ + y.size_);
+  bigint::mul_limbs(res.val.data(), x.limbs_, x.size_, y.limbs_, y.size_);
+  res.trim();
+  res.sign = a.sign_ != b.sign_;
+  return res;
+}
+
+#ifdef DOCTEST_LIBRARY_INCLUDED
+TEST_CASE("[bigint] serialization") {
+  const std::vector<bigint> values{bigint(0), bigint(1), bigint(-1),
+                                   bigint(4294967296),
+                                   -pow(bigint(3), 500),
+                                   pow(bigint(7), 1000) + bigint(1)};
+  std::size_t total = 0;
+  for (const bigint &v : values)
+    total += v.serialized_size();
+  CHECK_EQ(values[0].serialized_size(), 8u);
+  CHECK_EQ(values[3].serialized_size(), 16u);
+
+  // records back to back, as they would be stored in a file
+  std::vector<std::uint32_t> storage((total + 3) / 4);
+  const std::span<std::byte> buf(reinterpret_cast<std::byte *>(storage.data()),
+                                 total);
+  std::size_t pos = 0;
+  for (const bigint &v : values)
+    pos += v.serialize(buf.subspan(pos));
+  CHECK_EQ(pos, total);
+  CHECK_EQ(std::to_integer<int>(buf[8]), 2); // the header of 1
+  CHECK_EQ(std::to_integer<int>(buf[16]), 1);
+  CHECK_EQ(std::to_integer<int>(buf[20]), 3); // and of -1
+
+  pos = 0;
+  for (const bigint &v : values) {
+    const bigint x = bigint::deserialize(buf.subspan(pos));
+    CHECK_EQ(x, v);
+    const bigint_view w = bigint_view::deserialize(buf.subspan(pos));
+    CHECK_EQ(x, bigint(w));
+    CHECK_EQ(w.serialized_size(), v.serialized_size());
+    CHECK_EQ(w.to_string(), v.to_string());
+    CHECK_EQ(w.is_negative(), v < bigint(0));
+    pos += w.serialized_size();
+  }
+
+  // arithmetic over views and mixed with bigints
+  const std::size_t at = total - values[5].serialized_size() -
+                         values[4].serialized_size();
+  const bigint_view a = bigint_view::deserialize(buf.subspan(at));
+  const bigint_view b =
+      bigint_view::deserialize(buf.subspan(at + a.serialized_size()));
+  const bigint &x = values[4];
+  const bigint &y = values[5];
+  CHECK_EQ(a + b, x + y);
+  CHECK_EQ(a - b, x - y);
+  CHECK_EQ(b - a, y - x);
+  CHECK_EQ(a * b, x * y);
+  CHECK_EQ(a * a, x * x);
+  CHECK_EQ(x + b, x + y);
+  CHECK_EQ(a - a, bigint(0));
+  CHECK_EQ((a - a).to_string(), "0");
+  CHECK_EQ(a + bigint(0), x);
+  CHECK_EQ(bigint_view() * a, bigint(0));
+  CHECK(a < b);
+  CHECK(b > x);
+  CHECK(a == x);
+  CHECK(bigint_view(bigint(5)) < bigint_view(bigint(6)));
+  CHECK(bigint_view(bigint(-6)) < bigint_view(bigint(-5)));
+  CHECK(bigint_view(bigint(0)) == bigint_view());
+
+  // malformed records
+  std::array<std::byte, 12> rec{};
+  CHECK_THROWS_AS(static_cast<void>(bigint::deserialize(std::span(rec).first(7))),
+                  std::invalid_argument);
+  rec[0] = std::byte{4}; // two limbs, but only one present
+  CHECK_THROWS_AS(static_cast<void>(bigint::deserialize(rec)),
+                  std::invalid_argument);
+  rec[0] = std::byte{2}; // one limb of value 0
+  CHECK_THROWS_AS(static_cast<void>(bigint::deserialize(rec)),
+                  std::invalid_argument);
+  rec[0] = std::byte{1}; // negative zero
+  CHECK_THROWS_AS(static_cast<void>(bigint::deserialize(rec)),
+                  std::invalid_argument);
+  rec[0] = std::byte{2};
+  rec[8] = std::byte{7};
+  CHECK_EQ(bigint::deserialize(rec), bigint(7));
+  std::array<std::byte, 4> small{};
+  CHECK_THROWS_AS(static_cast<void>(bigint(7).serialize(small)),
+                  std::length_error);
+  CHECK_THROWS_AS(static_cast<void>(bigint_view::deserialize(
+                      buf.subspan(1, buf.size() - 1))),
+                  std::invalid_argument);
+}
+#endif
+
+// byte import and export
+
+inline std::size_t bigint::layout_bits(const bigint_layout &layout) noexcept(false) {
+  if (!layout.word_size || layout.nails >= 8 * layout.word_size)
+    throw std::invalid_argument("layout has no value bits");
+  return 8 * layout.word_size - layout.nails;
+}
+
+namespace bigint_detail {
+// the offset of byte j, counted from the least significant, of word w of
+// count words
+inline std::size_t layout_offset(const bigint_layout &layout,
+                                 const std::size_t count, const std::size_t w,
+                                 const std::size_t j) noexcept {
+  const std::size_t word = layout.word_order == std::endian::little ? w : count - 1 - w;
+  const std::size_t byte =
+      layout.byte_order == std::endian::little ? j : layout.word_size - 1 - j;
+  return word * layout.word_size + byte;
+}
+} // namespace bigint_detail
+
+inline bigint bigint::import_bytes(const std::span<const std::byte> in,
+                                   const bigint_layout &layout) noexcept(false) {
+  const std::size_t bits = layout_bits(layout);
+  const std::size_t ws = layout.word_size;
+  if (in.size() % ws)
+    throw std::invalid_argument("input is not a whole number of words");
+  const std::size_t count = in.size() / ws;
+  bigint res;
+  res.val.assign((count * bits + 31) / 32 + 1, 0);
+  WORD *const r = res.val.data();
+  if (!layout.nails && layout.word_order == std::endian::little &&
+      layout.byte_order == std::endian::little &&
+      std::endian::native == std::endian::little) {
+    // the limbs of the result, bytes and all
+    if (!in.empty())
+      std::memcpy(r, in.data(), in.size());
+  } else if (!layout.nails) {
+    for (std::size_t w = 0; w < count; w++) {
+      for (std::size_t j = 0; j < ws; j++) {
+        const std::size_t k = w * ws + j;
+        r[k / 4] |= std::to_integer<WORD>(
+                        in[bigint_detail::layout_offset(layout, count, w, j)])
+                    << (8 * (k % 4));
+      }
+    }
+  } else {
+    for (std::size_t w = 0; w < count; w++) {
+      for (std::size_t j = 0; 8 * j < bits; j++) {
+        // bits [8 j, 8 j + width) of the word, at bit pos of the value
+        const std::size_t width = std::min<std::size_t>(8, bits - 8 * j);
+        const std::size_t pos = w * bits + 8 * j;
+        const DWORD v =
+            std::to_integer<DWORD>(
+                in[bigint_detail::layout_offset(layout, count, w, j)]) &
+            ((DWORD{1} << width) - 1);
+        r[pos / 32] |= static_cast<WORD>(v << (pos % 32));
+        r[pos / 32 + 1] |= static_cast<WORD>(v << (pos % 32) >> 32);
+      }
+    }
+  }
+  res.trim();
+  return res;
+}
+
+inline std::size_t
+bigint::export_size(const bigint_layout &layout) const noexcept(false) {
+  const std::size_t bits = layout_bits(layout);
+  const std::size_t n = is_zero() ? 0 : bit_length();
+  return (n + bits - 1) / bits * layout.word_size;
+}
+
+inline std::size_t bigint::export_bytes(const std::span<std::byte> out,
+                                        const bigint_layout &layout) const
+    noexcept(false) {
+  const std::size_t bytes = export_size(layout);
+  if (out.size() < bytes)
+    throw std::length_error("buffer too small for exported bigint");
+  const std::size_t bits = layout_bits(layout);
+  const std::size_t ws = layout.word_size;
+  const std::size_t count = bytes / ws;
+  const WORD *const a = val.data();
+  const std::size_t n = val.size();
+  // byte k of the magnitude, 0 past its end
+  const auto byte_at = [&](std::size_t k) {
+    return k / 4 < n ? static_cast<std::byte>(a[k / 4] >> (8 * (k % 4)))
+                     : std::byte{0};
+  };
+  if (!layout.nails && layout.word_order == std::endian::little &&
+      layout.byte_order == std::endian::little &&
+      std::endian::native == std::endian::little) {
+    const std::size_t copied = std::min(bytes, n * sizeof(WORD));
+    if (copied)
+      std::memcpy(out.data(), a, copied);
+    std::fill(out.data() + copied, out.data() + bytes, std::byte{0});
+  } else if (!layout.nails) {
+    for (std::size_t w = 0; w < count; w++)
+      for (std::size_t j = 0; j < ws; j++)
+        out[bigint_detail::layout_offset(layout, count, w, j)] =
+            byte_at(w * ws + j);
+  } else {
+    for (std::size_t w = 0; w < count; w++) {
+      for (std::size_t j = 0; j < ws; j++) {
+        std::byte v{0};
+        if (8 * j < bits) {
+          const std::size_t width = std::min<std::size_t>(8, bits - 8 * j);
+          const std::size_t pos = w * bits + 8 * j;
+          const std::size_t i = pos / 32;
+          DWORD x = i < n ? a[i] : 0;
+          if (i + 1 < n)
+            x |= DWORD{a[i + 1]} << 32;
+          v = static_cast<std::byte>((x >> (pos % 32)) & ((DWORD{1} << width) - 1));
+        }
+        out[bigint_detail::layout_offset(layout, count, w, j)] = v;
+      }
+    }
+  }
+  return bytes;
+}
+
+#ifdef DOCTEST_LIBRARY_INCLUDED
+TEST_CASE("[bigint] byte import and export") {
+  const std::array<std::byte, 6> be{std::byte{0x01}, std::byte{0x02},
+                                    std::byte{0x03}, std::byte{0x04},
+                                    std::byte{0x05}, std::byte{0x06}};
+  CHECK_EQ(bigint::import_bytes(be), bigint(0x010203040506));
+  CHECK_EQ(bigint::import_bytes(be, {2, std::endian::little, std::endian::big}),
+           bigint(0x050603040102));
+  CHECK_EQ(bigint::import_bytes(be, {3, std::endian::big, std::endian::little}),
+           bigint(0x030201060504));
+  CHECK_EQ(bigint::import_bytes(be, {1, std::endian::little, std::endian::big}),
+           bigint(0x060504030201));
+  // seven value bits per byte
+  CHECK_EQ(bigint::import_bytes(std::array<std::byte, 2>{std::byte{0x81},
+                                                         std::byte{0x7f}},
+                                {1, std::endian::big, std::endian::big, 1}),
+           bigint(0x0ff));
+  CHECK_EQ(bigint::import_bytes({}), bigint(0));
+  CHECK_THROWS_AS(static_cast<void>(bigint::import_bytes(be, {4})),
+                  std::invalid_argument);
+  CHECK_THROWS_AS(static_cast<void>(bigint::import_bytes(be, {1, std::endian::big,
+                                                              std::endian::big, 8})),
+                  std::invalid_argument);
+
+  std::vector<std::byte> out(64);
+  const bigint x(0x010203040506);
+  CHECK_EQ(x.export_size(), 6u);
+  CHECK_EQ(x.export_bytes(out), 6u);
+  CHECK(std::equal(be.begin(), be.end(), out.begin()));
+  CHECK_EQ(bigint(-0x010203040506).export_bytes(out), 6u);
+  CHECK(std::equal(be.begin(), be.end(), out.begin()));
+  CHECK_EQ(bigint(0).export_size(), 0u);
+  CHECK_EQ(x.export_size({8}), 8u);
+  CHECK_EQ(bigint(0xff).export_bytes(out, {1, std::endian::big, std::endian::big, 1}),
+           2u);
+  CHECK_EQ(std::to_integer<int>(out[0]), 0x01);
+  CHECK_EQ(std::to_integer<int>(out[1]), 0x7f);
+  CHECK_EQ(x.export_bytes(out, {4, std::endian::little, std::endian::little}), 8u);
+  CHECK_EQ(std::to_integer<int>(out[0]), 0x06);
+  CHECK_EQ(std::to_integer<int>(out[5]), 0x01);
+  CHECK_EQ(std::to_integer<int>(out[7]), 0x00);
+  CHECK_THROWS_AS(static_cast<void>(x.export_bytes(std::span(out).first(5))),
+                  std::length_error);
+
+  // round trips through every kind of layout
+  const bigint big = pow(bigint(3), 777) + bigint(12345);
+  for (const std::size_t ws : {1u, 2u, 3u, 4u, 8u, 13u}) {
+    for (const std::endian wo : {std::endian::big, std::endian::little}) {
+      for (const std::endian bo : {std::endian::big, std::endian::little}) {
+        for (const std::size_t nails : {0u, 1u, 7u}) {
+          const bigint_layout layout{ws, wo, bo, nails};
+          std::vector<std::byte> buf(big.export_size(layout));
+          CHECK_EQ(big.export_bytes(buf, layout), buf.size());
+          CHECK_EQ(bigint::import_bytes(buf, layout), big);
+        }
+      }
+    }
+  }
+}
+#endif
+
+// fixed-width integers
+
+namespace bigint_detail {
+// f(std::integral_constant<std::size_t, I>{}) for I = 0, ..., N - 1, expanded
+// at compile time
+template <std::size_t N, typename F> constexpr void unroll(F &&f) {
+  [&f]<std::size_t... I>(std::index_sequence<I...>) {
+    (f(std::integral_constant<std::size_t, I>{}), ...);
+  }(std::make_index_sequence<N>{});
+}
+} // namespace bigint_detail
+
+/**
+ * An unsigned integer of Bits bits, a multiple of 32, stored inline in a
+ * std::array of limbs. Arithmetic wraps modulo 2^Bits like that of the
+ * built-in unsigned types, and everything but the conversions to and from
+ * bigint and strings of other than compile-time constants is constexpr, so
+ * constants fold and nothing touches the heap. Addition, subtraction and
+ * comparison are unrolled over the limbs; multiplication and division loop,
+ * which the compiler unrolls for small widths without blowing up the code
+ * for 4096 bits.
+ */
+template <std::size_t Bits> class fixed_bigint {
+  static_assert(Bits > 0 && Bits % 32 == 0,
+                "fixed_bigint needs a positive multiple of 32 bits");
+  using WORD = bigint_detail::limb;
+  using DWORD = bigint_detail::dlimb;
+  static constexpr unsigned WORD_BITS = bigint_detail::LIMB_BITS;
+
+public:
+  /// the number of 32-bit limbs
+  static constexpr std::size_t LIMBS = Bits / 32;
+
+  /**
+   * Initializes to 0.
+   */
+  constexpr fixed_bigint() noexcept = default;
+
+  /**
+   * Constructs from a 64-bit value, modulo 2^Bits.
+   * @param v The value.
+   */
+  explicit constexpr fixed_bigint(const std::uint64_t v) noexcept {
+    limbs_[0] = static_cast<WORD>(v);
+    if constexpr (LIMBS > 1)
+      limbs_[1] = static_cast<WORD>(v >> WORD_BITS);
+  }
+
+  /**
+   * Constructs from a signed value, modulo 2^Bits, so that negative values
+   * are sign-extended across all limbs.
+   * @param v The value.
+   */
+  template <std::signed_integral T>
+    requires(sizeof(T) <= sizeof(std::int64_t))
+  explicit constexpr fixed_bigint(const T v) noexcept
+      : fixed_bigint(static_cast<std::uint64_t>(static_cast<std::int64_t>(v))) {
+    if (v < 0)
+      for (std::size_t i = 2; i < LIMBS; i++)
+        limbs_[i] = ~WORD{0};
+  }
+
+  /**
+   * Parses digits of the given base, modulo 2^Bits. In a constant
+   * expression, invalid input fails to compile.
+   * @param sv The digits, without sign.
+   * @param base The base, between 2 and 36.
+   * @throws std::invalid_argument if sv is not a valid unsigned integer.
+   */
+  explicit constexpr fixed_bigint(const std::string_view sv, const int base = 10)
+      noexcept(false) {
+    if (base < 2 || base > 36)
+      throw std::invalid_argument("base must be between 2 and 36");
+    if (sv.empty())
+      throw std::invalid_argument("no digits found");
+    for (const char ch : sv) {
+      const WORD d = bigint_detail::DIGIT_VALUE[static_cast<unsigned char>(ch)];
+      if (d >= static_cast<WORD>(base))
+        throw std::invalid_argument("invalid character for base " +
+                                    std::to_string(base));
+      DWORD carry = d;
+      for (WORD &l : limbs_) {
+        carry += DWORD{l} * static_cast<WORD>(base);
+        l = static_cast<WORD>(carry);
+        carry >>= WORD_BITS;
+      }
+    }
+  }
+
+  /**
+   * Converts from another width, truncating or zero extending.
+   * @param x The value.
+   */
+  template <std::size_t B>
+    requires(B != Bits)
+  explicit constexpr fixed_bigint(const fixed_bigint<B> &x) noexcept {
+    for (std::size_t i = 0; i < std::min(LIMBS, fixed_bigint<B>::LIMBS); i++)
+      limbs_[i] = x.limbs()[i];
+  }
+
+  /**
+   * Converts from a bigint modulo 2^Bits, so that negative values wrap to
+   * their two's complement.
+   * @param x The value.
+   */
+  explicit fixed_bigint(const bigint &x) noexcept {
+    const std::size_t n = std::min(LIMBS, x.val.size());
+    std::copy(x.val.begin(), x.val.begin() + static_cast<std::ptrdiff_t>(n),
+              limbs_.begin());
+    if (x.sign)
+      *this = -*this;
+  }
+
+  /**
+   * @return The value as a bigint.
+   */
+  explicit operator bigint() const noexcept {
+    return bigint::from_limbs(limbs_.data(), LIMBS);
+  }
+
+  /**
+   * @return The limbs, least significant first.
+   */
+  [[nodiscard]]
+  constexpr const std::array<WORD, LIMBS> &limbs() const noexcept {
+    return limbs_;
+  }
+
+  /**
+   * @return The number of bits up to the highest set bit, 0 for the value 0.
+   */
+  [[nodiscard]]
+  constexpr std::size_t bit_length() const noexcept {
+    for (std::size_t i = LIMBS; i-- > 0;)
+      if (limbs_[i])
+        return i * WORD_BITS + static_cast<std::size_t>(std::bit_width(limbs_[i]));
+    return 0;
+  }
+
+  /**
+   * @return Whether the value is not 0.
+   */
+  explicit constexpr operator bool() const noexcept {
+    return std::ranges::any_of(limbs_, [](WORD l) { return l != 0; });
+  }
+
+  /**
+   * Converts the value to a string.
+   * @param base The base, between 2 and 36.
+   * @return The digits.
+   * @throws std::invalid_argument if the base is out of range.
+   */
+  [[nodiscard]]
+  std::string to_string(const int base = 10) const noexcept(false) {
+    return bigint(*this).to_string(base);
+  }
+
+  constexpr fixed_bigint &operator+=(const fixed_bigint &b) noexcept {
+    DWORD carry = 0;
+    bigint_detail::unroll<LIMBS>([&](auto i) {
+      carry += DWORD{limbs_[i]} + b.limbs_[i];
+      limbs_[i] = static_cast<WORD>(carry);
+      carry >>= WORD_BITS;
+    });
+    return *this;
+  }
+
+  constexpr fixed_bigint &operator-=(const fixed_bigint &b) noexcept {
+    WORD borrow = 0;
+    bigint_detail::unroll<LIMBS>([&](auto i) {
+      const DWORD d = DWORD{limbs_[i]} - b.limbs_[i] - borrow;
+      limbs_[i] = static_cast<WORD>(d);
+      borrow = static_cast<WORD>(d >> WORD_BITS) & 1;
+    });
+    return *this;
+  }
+
+  constexpr fixed_bigint &operator*=(const fixed_bigint &b) noexcept {
+    return *this = *this * b;
+  }
+
+  /**
+   * Divides by b, rounding toward zero.
+   * @throws std::domain_error if b is 0.
+   */
+  constexpr fixed_bigint &operator/=(const fixed_bigint &b) noexcept(false) {
+    fixed_bigint r;
+    divmod(*this, b, *this, r);
+    return *this;
+  }
+
+  /**
+   * Replaces the value by its remainder modulo b.
+   * @throws std::domain_error if b is 0.
+   */
+  constexpr fixed_bigint &operator%=(const fixed_bigint &b) noexcept(false) {
+    fixed_bigint q;
+    divmod(*this, b, q, *this);
+    return *this;
+  }
+
+  constexpr fixed_bigint &operator&=(const fixed_bigint &b) noexcept {
+    bigint_detail::unroll<LIMBS>([&](auto i) { limbs_[i] &= b.limbs_[i]; });
+    return *this;
+  }
+
+  constexpr fixed_bigint &operator|=(const fixed_bigint &b) noexcept {
+    bigint_detail::unroll<LIMBS>([&](auto i) { limbs_[i] |= b.limbs_[i]; });
+    return *this;
+  }
+
+  constexpr fixed_bigint &operator^=(const fixed_bigint &b) noexcept {
+    bigint_detail::unroll<LIMBS>([&](auto i) { limbs_[i] ^= b.limbs_[i]; });
+    return *this;
+  }
+
+  constexpr fixed_bigint &operator<<=(const std::size_t n) noexcept {
+    const std::size_t q = n / WORD_BITS;
+    const auto r = static_cast<unsigned>(n % WORD_BITS);
+    for (std::size_t i = LIMBS; i-- > 0;) {
+      WORD l = 0;
+      if (i >= q) {
+        l = limbs_[i - q] << r;
+        if (r && i > q)
+          l |= limbs_[i - q - 1] >> (WORD_BITS - r);
+      }
+      limbs_[i] = l;
+    }
+    return *this;
+  }
 
-protected:
-  // sign == true if n is negative, sign == false if n is positive
-  bool sign;
-  // val holds each digit of bigint
-  std::vector<WORD> val;
+  constexpr fixed_bigint &operator>>=(const std::size_t n) noexcept {
+    const std::size_t q = n / WORD_BITS;
+    const auto r = static_cast<unsigned>(n % WORD_BITS);
+    for (std::size_t i = 0; i < LIMBS; i++) {
+      WORD l = 0;
+      if (q < LIMBS - i) {
+        l = limbs_[i + q] >> r;
+        if (r && q + 1 < LIMBS - i)
+          l |= limbs_[i + q + 1] << (WORD_BITS - r);
+      }
+      limbs_[i] = l;
+    }
+    return *this;
+  }
+
+  constexpr fixed_bigint &operator++() noexcept {
+    return *this += fixed_bigint(1);
+  }
+
+  constexpr fixed_bigint &operator--() noexcept {
+    return *this -= fixed_bigint(1);
+  }
+
+  [[nodiscard]]
+  friend constexpr fixed_bigint operator+(fixed_bigint a,
+                                          const fixed_bigint &b) noexcept {
+    return a += b;
+  }
+
+  [[nodiscard]]
+  friend constexpr fixed_bigint operator-(fixed_bigint a,
+                                          const fixed_bigint &b) noexcept {
+    return a -= b;
+  }
 
-public:
   /**
-   * Default constructor for bigint. Initializes to 0.
+   * @return 2^Bits - a, or 0 for a = 0.
    */
-  bigint() noexcept : sign(false), val{0} {};
+  [[nodiscard]]
+  friend constexpr fixed_bigint operator-(const fixed_bigint &a) noexcept {
+    return fixed_bigint() - a;
+  }
 
   /**
-   * Constructs a bigint from a 64-bit integer.
-   * @param n The integer to initialize the bigint.
+   * @return The low Bits bits of a * b.
    */
-  explicit bigint(int64_t n) noexcept;
+  [[nodiscard]]
+  friend constexpr fixed_bigint operator*(const fixed_bigint &a,
+                                          const fixed_bigint &b) noexcept {
+    fixed_bigint r;
+    for (std::size_t i = 0; i < LIMBS; i++) {
+      DWORD carry = 0;
+      for (std::size_t j = 0; i + j < LIMBS; j++) {
+        carry += DWORD{a.limbs_[i]} * b.limbs_[j] + r.limbs_[i + j];
+        r.limbs_[i + j] = static_cast<WORD>(carry);
+        carry >>= WORD_BITS;
+      }
+    }
+    return r;
+  }
 
   /**
-   * A constructor that takes a string and converts the string to an
-   * arbitrary-precision integer.
-   * @param sv the string to convert
+   * @throws std::domain_error if b is 0.
    */
-  explicit bigint(std::string_view sv, int base = 10) noexcept(false);
+  [[nodiscard]]
+  friend constexpr fixed_bigint operator/(fixed_bigint a,
+                                          const fixed_bigint &b) noexcept(false) {
+    return a /= b;
+  }
 
   /**
-   * Adds a single WORD to the bigint.
-   * @param b The WORD to add.
-   * @return A new bigint representing the result.
+   * @throws std::domain_error if b is 0.
    */
   [[nodiscard]]
-  bigint operator+(WORD b) const noexcept;
+  friend constexpr fixed_bigint operator%(fixed_bigint a,
+                                          const fixed_bigint &b) noexcept(false) {
+    return a %= b;
+  }
+
+  [[nodiscard]]
+  friend constexpr fixed_bigint operator&(fixed_bigint a,
+                                          const fixed_bigint &b) noexcept {
+    return a &= b;
+  }
+
+  [[nodiscard]]
+  friend constexpr fixed_bigint operator|(fixed_bigint a,
+                                          const fixed_bigint &b) noexcept {
+    return a |= b;
+  }
+
+  [[nodiscard]]
+  friend constexpr fixed_bigint operator^(fixed_bigint a,
+                                          const fixed_bigint &b) noexcept {
+    return a ^= b;
+  }
+
+  [[nodiscard]]
+  friend constexpr fixed_bigint operator~(fixed_bigint a) noexcept {
+    bigint_detail::unroll<LIMBS>([&](auto i) { a.limbs_[i] = ~a.limbs_[i]; });
+    return a;
+  }
+
+  [[nodiscard]]
+  friend constexpr fixed_bigint operator<<(fixed_bigint a,
+                                           const std::size_t n) noexcept {
+    return a <<= n;
+  }
+
+  [[nodiscard]]
+  friend constexpr fixed_bigint operator>>(fixed_bigint a,
+                                           const std::size_t n) noexcept {
+    return a >>= n;
+  }
+
+  friend constexpr bool operator==(const fixed_bigint &a,
+                                   const fixed_bigint &b) noexcept = default;
+
+  friend constexpr std::strong_ordering
+  operator<=>(const fixed_bigint &a, const fixed_bigint &b) noexcept {
+    std::strong_ordering res = std::strong_ordering::equal;
+    bigint_detail::unroll<LIMBS>([&](auto i) {
+      constexpr std::size_t j = LIMBS - 1 - decltype(i)::value;
+      if (res == 0)
+        res = a.limbs_[j] <=> b.limbs_[j];
+    });
+    return res;
+  }
 
   /**
-   * Adds a single WORD to the bigint in-place.
-   * @param b The WORD to add.
-   * @return A reference to the updated bigint.
+   * Multiplies without truncation.
+   * @param a The first factor.
+   * @param b The second factor.
+   * @return The full product a * b.
    */
-  const bigint &operator+=(WORD b) noexcept;
+  [[nodiscard]]
+  friend constexpr fixed_bigint<2 * Bits> mul_wide(const fixed_bigint &a,
+                                                   const fixed_bigint &b) noexcept {
+    std::array<WORD, 2 * LIMBS> r{};
+    for (std::size_t i = 0; i < LIMBS; i++) {
+      DWORD carry = 0;
+      for (std::size_t j = 0; j < LIMBS; j++) {
+        carry += DWORD{a.limbs_[i]} * b.limbs_[j] + r[i + j];
+        r[i + j] = static_cast<WORD>(carry);
+        carry >>= WORD_BITS;
+      }
+      r[i + LIMBS] = static_cast<WORD>(carry);
+    }
+    return fixed_bigint<2 * Bits>::from_limbs(r);
+  }
 
   /**
-   * Multiplies the bigint by a single WORD.
-   * @param b The WORD to multiply with.
-   * @return A new bigint representing the result.
+   * Constructs from limbs, least significant first.
+   * @param l The limbs.
+   * @return The value.
    */
   [[nodiscard]]
-  bigint operator*(WORD b) const noexcept;
+  static constexpr fixed_bigint from_limbs(const std::array<WORD, LIMBS> &l) noexcept {
+    fixed_bigint res;
+    res.limbs_ = l;
+    return res;
+  }
 
   /**
-   * Multiplies the bigint by a single WORD in-place.
-   * @param b The WORD to multiply with.
-   * @return A reference to the updated bigint.
+   * Inserts the value into a stream in decimal, or in hexadecimal or octal
+   * following the stream's basefield.
    */
-  const bigint &operator*=(WORD b) noexcept;
+  friend std::ostream &operator<<(std::ostream &os, const fixed_bigint &a) noexcept {
+    return os << bigint(a);
+  }
+
+private:
+  std::array<WORD, LIMBS> limbs_{};
+
+  // q = u / v and r = u % v by Knuth's algorithm D, with q and r allowed to
+  // alias u
+  static constexpr void divmod(const fixed_bigint &u, const fixed_bigint &v,
+                               fixed_bigint &q, fixed_bigint &r) noexcept(false) {
+    std::size_t n = LIMBS;
+    while (n > 0 && !v.limbs_[n - 1])
+      n--;
+    if (!n)
+      throw std::domain_error("division by zero");
+    std::size_t m = LIMBS;
+    while (m > 0 && !u.limbs_[m - 1])
+      m--;
+    if (m < n) {
+      r = u;
+      q = fixed_bigint();
+      return;
+    }
+    fixed_bigint quot;
+    if (n == 1) {
+      DWORD rem = 0;
+      for (std::size_t i = m; i-- > 0;) {
+        rem = rem << WORD_BITS | u.limbs_[i];
+        quot.limbs_[i] = static_cast<WORD>(rem / v.limbs_[0]);
+        rem %= v.limbs_[0];
+      }
+      q = quot;
+      r = fixed_bigint(rem);
+      return;
+    }
+    // normalize so that the top limb of v has its top bit set
+    const auto s = static_cast<unsigned>(std::countl_zero(v.limbs_[n - 1]));
+    std::array<WORD, LIMBS> vn{};
+    std::array<WORD, LIMBS + 1> un{};
+    for (std::size_t i = n; i-- > 0;)
+      vn[i] = static_cast<WORD>(v.limbs_[i] << s |
+                                (s && i ? v.limbs_[i - 1] >> (WORD_BITS - s) : 0));
+    un[m] = s ? u.limbs_[m - 1] >> (WORD_BITS - s) : 0;
+    for (std::size_t i = m; i-- > 0;)
+      un[i] = static_cast<WORD>(u.limbs_[i] << s |
+                                (s && i ? u.limbs_[i - 1] >> (WORD_BITS - s) : 0));
+    constexpr DWORD B = DWORD{1} << WORD_BITS;
+    for (std::size_t j = m - n + 1; j-- > 0;) {
+      const DWORD top = DWORD{un[j + n]} << WORD_BITS | un[j + n - 1];
+      DWORD qhat = top / vn[n - 1];
+      DWORD rhat = top % vn[n - 1];
+      while (qhat >= B || qhat * vn[n - 2] > (rhat << WORD_BITS | un[j + n - 2])) {
+        qhat--;
+        rhat += vn[n - 1];
+        if (rhat >= B)
+          break;
+      }
+      // un[j..j+n] -= qhat * vn, adding back once if that went negative
+      DWORD carry = 0;
+      WORD borrow = 0;
+      for (std::size_t i = 0; i < n; i++) {
+        carry += qhat * vn[i];
+        const DWORD d = DWORD{un[i + j]} - static_cast<WORD>(carry) - borrow;
+        un[i + j] = static_cast<WORD>(d);
+        borrow = static_cast<WORD>(d >> WORD_BITS) & 1;
+        carry >>= WORD_BITS;
+      }
+      const DWORD d = DWORD{un[j + n]} - carry - borrow;
+      un[j + n] = static_cast<WORD>(d);
+      if (d >> WORD_BITS) {
+        qhat--;
+        DWORD c = 0;
+        for (std::size_t i = 0; i < n; i++) {
+          c += DWORD{un[i + j]} + vn[i];
+          un[i + j] = static_cast<WORD>(c);
+          c >>= WORD_BITS;
+        }
+        un[j + n] = static_cast<WORD>(un[j + n] + c);
+      }
+      quot.limbs_[j] = static_cast<WORD>(qhat);
+    }
+    fixed_bigint rem;
+    for (std::size_t i = 0; i < n; i++)
+      rem.limbs_[i] = static_cast<WORD>(un[i] >> s |
+                                        (s ? DWORD{un[i + 1]} << (WORD_BITS - s) : 0));
+    q = quot;
+    r = rem;
+  }
+};
+
+#ifdef DOCTEST_LIBRARY_INCLUDED
+namespace {
+// the secp256k1 field prime 2^256 - 2^32 - 977, parsed at compile time
+constexpr fixed_bigint<256> SECP256K1_P(
+    "fffffffffffffffffffffffffffffffffffffffffffffffffffffffefffffc2f", 16);
+static_assert(SECP256K1_P + fixed_bigint<256>(4294968273) == fixed_bigint<256>());
+static_assert(SECP256K1_P.bit_length() == 256);
+static_assert((SECP256K1_P / fixed_bigint<256>(12345)) * fixed_bigint<256>(12345) +
+                  SECP256K1_P % fixed_bigint<256>(12345) ==
+              SECP256K1_P);
+static_assert(fixed_bigint<256>(-1) == ~fixed_bigint<256>());
+static_assert(fixed_bigint<32>(-2) == fixed_bigint<32>(0xfffffffe));
+static_assert(fixed_bigint<64>(5) - fixed_bigint<64>(7) ==
+              fixed_bigint<64>(0xfffffffffffffffe));
+static_assert(fixed_bigint<128>(1) << 127 > fixed_bigint<128>(~std::uint64_t{0}));
+static_assert(mul_wide(fixed_bigint<64>(~std::uint64_t{0}),
+                       fixed_bigint<64>(~std::uint64_t{0})) ==
+              (fixed_bigint<128>(1) << 128) - (fixed_bigint<128>(1) << 65) +
+                  fixed_bigint<128>(1));
+} // namespace
+
+TEST_CASE("[bigint] fixed-width integers") {
+  CHECK_EQ(SECP256K1_P.to_string(),
+           "115792089237316195423570985008687907853269984665640564039457584007908834671663");
+  CHECK_EQ(bigint(SECP256K1_P), pow(bigint(2), 256) - bigint(4294968273));
+  CHECK_EQ(fixed_bigint<256>(bigint(-1)), ~fixed_bigint<256>());
+  CHECK_EQ(fixed_bigint<256>(-5), fixed_bigint<256>(bigint(-5)));
+  CHECK_EQ(fixed_bigint<96>(std::int64_t{-3} << 40),
+           fixed_bigint<96>(bigint(std::int64_t{-3} << 40)));
+  CHECK_EQ(fixed_bigint<128>(std::numeric_limits<std::int64_t>::min()),
+           fixed_bigint<128>(bigint(std::numeric_limits<std::int64_t>::min())));
+  CHECK_EQ(fixed_bigint<128>(7), fixed_bigint<128>(7u));
+  CHECK_EQ(fixed_bigint<64>(pow(bigint(2), 64) + bigint(3)), fixed_bigint<64>(3));
+  CHECK_EQ(fixed_bigint<128>(fixed_bigint<256>(bigint(-1))).bit_length(), 128u);
+  CHECK_THROWS_AS(static_cast<void>(fixed_bigint<64>(1) / fixed_bigint<64>()),
+                  std::domain_error);
+  CHECK_THROWS_AS(fixed_bigint<64> _("12x"), std::invalid_argument);
+  std::ostringstream os;
+  os << std::hex << fixed_bigint<64>(255);
+  CHECK_EQ(os.str(), "ff");
+
+  // every operation agrees with bigint arithmetic modulo 2^Bits
+  const auto check = [](auto zero, const bigint &x, const bigint &y) {
+    using F = decltype(zero);
+    const bigint mod = pow(bigint(2), F::LIMBS * 32);
+    const auto reduce = [&mod](const bigint &v) {
+      bigint r = v % mod;
+      return r < bigint(0) ? r + mod : r;
+    };
+    const F a(x);
+    const F b(y);
+    const bigint ra = reduce(x);
+    const bigint rb = reduce(y);
+    CHECK_EQ(bigint(a + b), reduce(ra + rb));
+    CHECK_EQ(bigint(a - b), reduce(ra - rb));
+    CHECK_EQ(bigint(a * b), reduce(ra * rb));
+    CHECK_EQ(bigint(mul_wide(a, b)), ra * rb);
+    CHECK_EQ(bigint(a / b), ra / rb);
+    CHECK_EQ(bigint(a % b), ra % rb);
+    CHECK_EQ(bigint(a & b), ra & rb);
+    CHECK_EQ(bigint(a | b), ra | rb);
+    CHECK_EQ(bigint(a ^ b), ra ^ rb);
+    CHECK_EQ(a < b, ra < rb);
+    CHECK_EQ(a == b, ra == rb);
+    for (const std::size_t n : {0u, 1u, 31u, 32u, 33u, 100u, 255u, 4095u}) {
+      CHECK_EQ(bigint(a << n), reduce(ra << n));
+      CHECK_EQ(bigint(a >> n), ra >> n);
+    }
+  };
+  for (const std::size_t e : {1u, 20u, 40u, 80u, 160u, 2000u}) {
+    const bigint x = pow(bigint(3), 2 * e) + bigint(17);
+    const bigint y = pow(bigint(7), e) - bigint(1);
+    check(fixed_bigint<64>(), x, y);
+    check(fixed_bigint<256>(), x, y);
+    check(fixed_bigint<512>(), -x, y);
+    check(fixed_bigint<4096>(), x, y);
+    check(fixed_bigint<4096>(), y, x >> 3);
+    // divisors with a top limb that needs the add back step
+    check(fixed_bigint<256>(), x, (bigint(1) << 95) + bigint(1));
+  }
+}
+#endif
+
+// batches
+
+namespace bigint_detail {
+// Vertical kernels over a structure of arrays: row i of an operand holds limb
+// i of each of width numbers, one row starting every stride limbs. Rows of a
+// and b past an and bn read as zero, and the results have rn rows. The
+// carries of the numbers travel down the rows side by side, so SIMD lanes
+// hold different numbers rather than limbs of the same one.
+
+inline void batch_add_portable(limb *r, std::size_t rn, const limb *a,
+                               std::size_t an, const limb *b, std::size_t bn,
+                               std::size_t stride, std::size_t width) noexcept {
+  for (std::size_t k = 0; k < width; k++) {
+    dlimb carry = 0;
+    for (std::size_t i = 0; i < rn; i++) {
+      carry += dlimb{i < an ? a[i * stride + k] : 0} +
+               (i < bn ? b[i * stride + k] : 0);
+      r[i * stride + k] = static_cast<limb>(carry);
+      carry >>= LIMB_BITS;
+    }
+  }
+}
+
+inline void batch_sub_portable(limb *r, std::size_t rn, const limb *a,
+                               std::size_t an, const limb *b, std::size_t bn,
+                               std::size_t stride, std::size_t width) noexcept {
+  for (std::size_t k = 0; k < width; k++) {
+    limb borrow = 0;
+    for (std::size_t i = 0; i < rn; i++) {
+      const dlimb d = dlimb{i < an ? a[i * stride + k] : 0} -
+                      (i < bn ? b[i * stride + k] : 0) - borrow;
+      r[i * stride + k] = static_cast<limb>(d);
+      borrow = static_cast<limb>(d >> LIMB_BITS) & 1;
+    }
+  }
+}
+
+// r must not overlap a or b
+inline void batch_mul_portable(limb *r, std::size_t rn, const limb *a,
+                               std::size_t an, const limb *b, std::size_t bn,
+                               std::size_t stride, std::size_t width) noexcept {
+  for (std::size_t k = 0; k < width; k++) {
+    for (std::size_t i = 0; i < rn; i++)
+      r[i * stride + k] = 0;
+    for (std::size_t i = 0; i < std::min(an, rn); i++) {
+      dlimb carry = 0;
+      const dlimb x = a[i * stride + k];
+      for (std::size_t j = 0; j < bn && i + j < rn; j++) {
+        carry += x * b[j * stride + k] + r[(i + j) * stride + k];
+        r[(i + j) * stride + k] = static_cast<limb>(carry);
+        carry >>= LIMB_BITS;
+      }
+      if (i + bn < rn)
+        r[(i + bn) * stride + k] = static_cast<limb>(carry);
+    }
+  }
+}
+
+#ifdef BIGINT_X86_SIMD
+__attribute__((target("avx2"))) inline __m256i
+avx2_row(const limb *p, std::size_t i, std::size_t n, std::size_t stride) noexcept {
+  return i < n ? _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p + i * stride))
+               : _mm256_setzero_si256();
+}
+
+// eight numbers at a time, then the portable kernel for the rest
+__attribute__((target("avx2"))) inline void
+batch_add_avx2(limb *r, std::size_t rn, const limb *a, std::size_t an,
+               const limb *b, std::size_t bn, std::size_t stride,
+               std::size_t width) noexcept {
+  const __m256i bias = _mm256_set1_epi32(std::numeric_limits<int>::min());
+  std::size_t k = 0;
+  for (; k + 8 <= width; k += 8) {
+    __m256i carry = _mm256_setzero_si256();
+    for (std::size_t i = 0; i < rn; i++) {
+      const __m256i va = avx2_row(a + k, i, an, stride);
+      const __m256i s = _mm256_add_epi32(va, avx2_row(b + k, i, bn, stride));
+      const __m256i t = _mm256_add_epi32(s, carry);
+      // a carry out of either addition, as an unsigned comparison
+      const __m256i c1 = _mm256_cmpgt_epi32(_mm256_xor_si256(va, bias),
+                                            _mm256_xor_si256(s, bias));
+      const __m256i c2 = _mm256_cmpgt_epi32(_mm256_xor_si256(s, bias),
+                                            _mm256_xor_si256(t, bias));
+      carry = _mm256_srli_epi32(_mm256_or_si256(c1, c2), 31);
+      _mm256_storeu_si256(reinterpret_cast<__m256i *>(r + k + i * stride), t);
+    }
+  }
+  batch_add_portable(r + k, rn, a + k, an, b + k, bn, stride, width - k);
+}
+
+__attribute__((target("avx2"))) inline void
+batch_sub_avx2(limb *r, std::size_t rn, const limb *a, std::size_t an,
+               const limb *b, std::size_t bn, std::size_t stride,
+               std::size_t width) noexcept {
+  const __m256i bias = _mm256_set1_epi32(std::numeric_limits<int>::min());
+  std::size_t k = 0;
+  for (; k + 8 <= width; k += 8) {
+    __m256i borrow = _mm256_setzero_si256();
+    for (std::size_t i = 0; i < rn; i++) {
+      const __m256i va = avx2_row(a + k, i, an, stride);
+      const __m256i vb = avx2_row(b + k, i, bn, stride);
+      const __m256i d = _mm256_sub_epi32(va, vb);
+      const __m256i t = _mm256_sub_epi32(d, borrow);
+      const __m256i b1 = _mm256_cmpgt_epi32(_mm256_xor_si256(vb, bias),
+                                            _mm256_xor_si256(va, bias));
+      const __m256i b2 = _mm256_cmpgt_epi32(_mm256_xor_si256(borrow, bias),
+                                            _mm256_xor_si256(d, bias));
+      borrow = _mm256_srli_epi32(_mm256_or_si256(b1, b2), 31);
+      _mm256_storeu_si256(reinterpret_cast<__m256i *>(r + k + i * stride), t);
+    }
+  }
+  batch_sub_portable(r + k, rn, a + k, an, b + k, bn, stride, width - k);
+}
+
+// four limbs widened to 64-bit lanes, and the low halves of four lanes
+__attribute__((target("avx2"))) inline __m256i
+avx2_row64(const limb *p, std::size_t i, std::size_t stride) noexcept {
+  return _mm256_cvtepu32_epi64(
+      _mm_loadu_si128(reinterpret_cast<const __m128i *>(p + i * stride)));
+}
+
+__attribute__((target("avx2"))) inline void
+avx2_store64(limb *p, std::size_t i, std::size_t stride, __m256i v) noexcept {
+  const __m256i low = _mm256_permutevar8x32_epi32(
+      v, _mm256_setr_epi32(0, 2, 4, 6, 0, 2, 4, 6));
+  _mm_storeu_si128(reinterpret_cast<__m128i *>(p + i * stride),
+                   _mm256_castsi256_si128(low));
+}
+
+// four numbers at a time in 64-bit lanes
+__attribute__((target("avx2"))) inline void
+batch_mul_avx2(limb *r, std::size_t rn, const limb *a, std::size_t an,
+               const limb *b, std::size_t bn, std::size_t stride,
+               std::size_t width) noexcept {
+  const __m256i mask = _mm256_set1_epi64x(0xffffffff);
+  std::size_t k = 0;
+  for (; k + 4 <= width; k += 4) {
+    for (std::size_t i = 0; i < rn; i++)
+      avx2_store64(r + k, i, stride, _mm256_setzero_si256());
+    for (std::size_t i = 0; i < std::min(an, rn); i++) {
+      const __m256i x = avx2_row64(a + k, i, stride);
+      __m256i carry = _mm256_setzero_si256();
+      for (std::size_t j = 0; j < bn && i + j < rn; j++) {
+        const __m256i t = _mm256_add_epi64(
+            _mm256_add_epi64(_mm256_mul_epu32(x, avx2_row64(b + k, j, stride)),
+                             avx2_row64(r + k, i + j, stride)),
+            carry);
+        avx2_store64(r + k, i + j, stride, _mm256_and_si256(t, mask));
+        carry = _mm256_srli_epi64(t, 32);
+      }
+      if (i + bn < rn)
+        avx2_store64(r + k, i + bn, stride, carry);
+    }
+  }
+  batch_mul_portable(r + k, rn, a + k, an, b + k, bn, stride, width - k);
+}
+#endif
+
+inline void batch_add(limb *r, std::size_t rn, const limb *a, std::size_t an,
+                      const limb *b, std::size_t bn, std::size_t stride,
+                      std::size_t width) noexcept {
+#ifdef BIGINT_X86_SIMD
+  if (simd_dispatch != simd_level::none)
+    return batch_add_avx2(r, rn, a, an, b, bn, stride, width);
+#endif
+  batch_add_portable(r, rn, a, an, b, bn, stride, width);
+}
+
+inline void batch_sub(limb *r, std::size_t rn, const limb *a, std::size_t an,
+                      const limb *b, std::size_t bn, std::size_t stride,
+                      std::size_t width) noexcept {
+#ifdef BIGINT_X86_SIMD
+  if (simd_dispatch != simd_level::none)
+    return batch_sub_avx2(r, rn, a, an, b, bn, stride, width);
+#endif
+  batch_sub_portable(r, rn, a, an, b, bn, stride, width);
+}
+
+inline void batch_mul(limb *r, std::size_t rn, const limb *a, std::size_t an,
+                      const limb *b, std::size_t bn, std::size_t stride,
+                      std::size_t width) noexcept {
+#ifdef BIGINT_X86_SIMD
+  if (simd_dispatch != simd_level::none)
+    return batch_mul_avx2(r, rn, a, an, b, bn, stride, width);
+#endif
+  batch_mul_portable(r, rn, a, an, b, bn, stride, width);
+}
+} // namespace bigint_detail
+
+/**
+ * Many unsigned integers of the same width in a structure of arrays layout,
+ * for running one operation over all of them at once. Limb i of number k is
+ * at limb_row(i)[k], so SIMD lanes hold consecutive numbers and the carries
+ * of all of them are handled side by side. Each number wraps modulo
+ * 2^(32 limbs()), like fixed_bigint, and the storage comes from the memory
+ * resource current at construction, like that of a bigint.
+ */
+class bigint_batch {
+  using WORD = bigint_detail::limb;
 
+public:
   /**
-   * Adds another bigint to this bigint.
-   * @param b The bigint to add.
-   * @return A new bigint representing the result.
+   * Creates count numbers of the given width, all 0.
+   * @param count The number of values.
+   * @param limbs The width of each value in 32-bit limbs, at least 1.
+   * @throws std::invalid_argument if limbs is 0.
+   */
+  bigint_batch(std::size_t count, std::size_t limbs) noexcept(false);
+
+  /**
+   * @return The number of values.
    */
   [[nodiscard]]
-  bigint operator+(const bigint &b) const noexcept;
+  std::size_t size() const noexcept {
+    return count_;
+  }
 
   /**
-   * Adds another bigint to this bigint in-place.
-   * @param b The bigint to add.
-   * @return A reference to the updated bigint.
+   * @return The width of each value in limbs.
    */
-  const bigint &operator+=(const bigint &b) noexcept;
+  [[nodiscard]]
+  std::size_t limbs() const noexcept {
+    return limbs_;
+  }
 
   /**
-   * Subtracts another bigint from this bigint.
-   * @param b The bigint to subtract.
-   * @return A new bigint representing the result.
+   * @param i The limb index, below limbs().
+   * @return Limb i of every value, by value index.
    */
   [[nodiscard]]
-  bigint operator-(const bigint &b) const noexcept;
+  std::span<WORD> limb_row(std::size_t i) noexcept {
+    return {data_.data() + i * count_, count_};
+  }
+
+  [[nodiscard]]
+  std::span<const WORD> limb_row(std::size_t i) const noexcept {
+    return {data_.data() + i * count_, count_};
+  }
 
   /**
-   * Subtracts another bigint from this bigint in-place.
-   * @param b The bigint to subtract.
-   * @return A reference to the updated bigint.
+   * Stores x modulo 2^(32 limbs()) as value k, so that negative values wrap
+   * to their two's complement.
+   * @param k The index of the value.
+   * @param x The value.
    */
-  const bigint &operator-=(const bigint &b) noexcept;
+  void set(std::size_t k, const bigint &x) noexcept;
+
+  /**
+   * @param k The index of the value.
+   * @return Value k.
+   */
+  [[nodiscard]]
+  bigint get(std::size_t k) const noexcept;
+
+  /**
+   * Computes dst[k] = a[k] + b[k] for every k, modulo the width of dst.
+   * Operands narrower than dst are zero extended. dst may be a or b.
+   * @param dst The results.
+   * @param a The first summands.
+   * @param b The second summands.
+   * @param threads The number of threads to split the values over.
+   * @throws std::invalid_argument if the batches differ in size.
+   */
+  static void add(bigint_batch &dst, const bigint_batch &a, const bigint_batch &b,
+                  std::size_t threads = 1) noexcept(false);
+
+  /**
+   * Computes dst[k] = a[k] - b[k] for every k, modulo the width of dst.
+   * @param dst The results, which may be a or b.
+   * @param a The minuends.
+   * @param b The subtrahends.
+   * @param threads The number of threads to split the values over.
+   * @throws std::invalid_argument if the batches differ in size.
+   */
+  static void sub(bigint_batch &dst, const bigint_batch &a, const bigint_batch &b,
+                  std::size_t threads = 1) noexcept(false);
+
+  /**
+   * Computes dst[k] = a[k] * b[k] for every k by schoolbook multiplication,
+   * modulo the width of dst, which takes the full products when it has
+   * a.limbs() + b.limbs() limbs.
+   * @param dst The results, which may be a or b.
+   * @param a The first factors.
+   * @param b The second factors.
+   * @param threads The number of threads to split the values over.
+   * @throws std::invalid_argument if the batches differ in size.
+   */
+  static void mul(bigint_batch &dst, const bigint_batch &a, const bigint_batch &b,
+                  std::size_t threads = 1) noexcept(false);
+
+private:
+  std::size_t count_;
+  std::size_t limbs_;
+  bigint_detail::limb_vector data_;
+
+  using kernel = void (*)(WORD *, std::size_t, const WORD *, std::size_t,
+                          const WORD *, std::size_t, std::size_t,
+                          std::size_t) noexcept;
+  static void apply(kernel f, bigint_batch &dst, const bigint_batch &a,
+                    const bigint_batch &b, std::size_t threads) noexcept(false);
+};
+
+inline bigint_batch::bigint_batch(const std::size_t count,
+                                  const std::size_t limbs) noexcept(false)
+    : count_(count), limbs_(limbs) {
+  if (!limbs)
+    throw std::invalid_argument("values need at least one limb");
+  data_.assign(count * limbs, 0);
+}
+
+inline void bigint_batch::set(const std::size_t k, const bigint &x) noexcept {
+  // the two's complement of a negative value is ~(|x| - 1)
+  WORD borrow = x.sign;
+  for (std::size_t i = 0; i < limbs_; i++) {
+    WORD l = i < x.val.size() ? x.val[i] : 0;
+    if (x.sign) {
+      const WORD d = l - borrow;
+      borrow = borrow && !l;
+      l = ~d;
+    }
+    data_[i * count_ + k] = l;
+  }
+}
+
+inline bigint bigint_batch::get(const std::size_t k) const noexcept {
+  bigint res;
+  res.val.resize(limbs_);
+  for (std::size_t i = 0; i < limbs_; i++)
+    res.val[i] = data_[i * count_ + k];
+  res.trim();
+  return res;
+}
+
+// runs f over slices of the values, a multiple of eight wide so that the
+// SIMD kernels see whole vectors
+inline void bigint_batch::apply(const kernel f, bigint_batch &dst,
+                                const bigint_batch &a, const bigint_batch &b,
+                                const std::size_t threads) noexcept(false) {
+  if (a.count_ != dst.count_ || b.count_ != dst.count_)
+    throw std::invalid_argument("batches differ in size");
+  const std::size_t n = dst.count_;
+  const std::size_t slices = std::max<std::size_t>(1, std::min(threads, n / 64));
+  const std::size_t slice = ((n + slices - 1) / slices + 7) / 8 * 8;
+  bigint_detail::thread_pool::instance().run(slices, slices, [&](std::size_t s) {
+    const std::size_t k = s * slice;
+    if (k >= n)
+      return;
+    f(dst.data_.data() + k, dst.limbs_, a.data_.data() + k, a.limbs_,
+      b.data_.data() + k, b.limbs_, n, std::min(slice, n - k));
+  });
+}
+
+inline void bigint_batch::add(bigint_batch &dst, const bigint_batch &a,
+                              const bigint_batch &b,
+                              const std::size_t threads) noexcept(false) {
+  apply(bigint_detail::batch_add, dst, a, b, threads);
+}
+
+inline void bigint_batch::sub(bigint_batch &dst, const bigint_batch &a,
+                              const bigint_batch &b,
+                              const std::size_t threads) noexcept(false) {
+  apply(bigint_detail::batch_sub, dst, a, b, threads);
+}
+
+inline void bigint_batch::mul(bigint_batch &dst, const bigint_batch &a,
+                              const bigint_batch &b,
+                              const std::size_t threads) noexcept(false) {
+  if (&dst == &a || &dst == &b) {
+    // the products are written row by row while the factors are still read
+    bigint_batch res(dst.count_, dst.limbs_);
+    apply(bigint_detail::batch_mul, res, a, b, threads);
+    dst = std::move(res);
+    return;
+  }
+  apply(bigint_detail::batch_mul, dst, a, b, threads);
+}
+
+#ifdef DOCTEST_LIBRARY_INCLUDED
+TEST_CASE("[bigint] batches") {
+  CHECK_THROWS_AS(bigint_batch(4, 0), std::invalid_argument);
+  bigint_batch x(3, 2);
+  x.set(0, bigint(5));
+  x.set(1, bigint(-1));
+  x.set(2, pow(bigint(2), 64) + bigint(9));
+  CHECK_EQ(x.get(0), bigint(5));
+  CHECK_EQ(x.get(1), pow(bigint(2), 64) - bigint(1));
+  CHECK_EQ(x.get(2), bigint(9));
+  CHECK_EQ(x.limb_row(1)[1], 0xffffffffu);
+  CHECK_THROWS_AS(bigint_batch::add(x, x, bigint_batch(4, 2)), std::invalid_argument);
+
+  // every value agrees with bigint arithmetic, for counts that leave
+  // partial vectors and for slices on several threads, including counts
+  // that do not divide evenly into the slices
+  const auto saved = bigint_detail::simd_dispatch;
+  for (int level = 0; level <= static_cast<int>(saved); level++) {
+    bigint_detail::simd_dispatch = static_cast<bigint_detail::simd_level>(level);
+    for (const std::size_t count : {1u, 7u, 8u, 13u, 129u, 194u, 301u}) {
+      for (const std::size_t threads : {1u, 2u, 3u}) {
+        bigint_batch a(count, 3);
+        bigint_batch b(count, 2);
+        std::vector<bigint> va, vb;
+        for (std::size_t k = 0; k < count; k++) {
+          const auto e = static_cast<std::uint64_t>(k % 60);
+          va.push_back(pow(bigint(3), e) * bigint(static_cast<std::int64_t>(k + 1)) %
+                       pow(bigint(2), 96));
+          vb.push_back(k % 5 ? pow(bigint(2), 64) - bigint(static_cast<std::int64_t>(k))
+                             : bigint(0));
+          a.set(k, va[k]);
+          b.set(k, vb[k]);
+        }
+        const bigint m4 = pow(bigint(2), 128);
+        const bigint m3 = pow(bigint(2), 96);
+        bigint_batch sum(count, 4);
+        bigint_batch diff(count, 3);
+        bigint_batch prod(count, 5);
+        bigint_batch low(count, 2);
+        bigint_batch::add(sum, a, b, threads);
+        bigint_batch::sub(diff, a, b, threads);
+        bigint_batch::mul(prod, a, b, threads);
+        bigint_batch::mul(low, a, b, threads);
+        for (std::size_t k = 0; k < count; k++) {
+          CHECK_EQ(sum.get(k), va[k] + vb[k]);
+          CHECK_EQ(diff.get(k), ((va[k] - vb[k]) % m3 + m3) % m3);
+          CHECK_EQ(prod.get(k), va[k] * vb[k]);
+          CHECK_EQ(low.get(k), va[k] * vb[k] % pow(bigint(2), 64));
+        }
+        // in place, with dst as an operand
+        bigint_batch::add(sum, sum, sum, threads);
+        bigint_batch::mul(a, a, a, threads);
+        for (std::size_t k = 0; k < count; k++) {
+          CHECK_EQ(sum.get(k), (va[k] + vb[k]) * bigint(2) % m4);
+          CHECK_EQ(a.get(k), va[k] * va[k] % m3);
+        }
+      }
+    }
+  }
+  bigint_detail::simd_dispatch = saved;
+}
+#endif
+
+// step-wise operations
+
+namespace bigint_detail {
+// The work of one suspension of a step-wise NTT, in butterflies or element
+// operations, and the operand size up to which a step-wise operation does a
+// product, quotient or conversion in a single piece.
+inline constexpr std::size_t STEP_GRAIN = std::size_t{1} << 16;
+inline constexpr std::size_t STEP_LIMBS = 2048;
+
+// A coroutine that suspends after each piece of work with co_yield, giving
+// the work done by that piece. co_await on another task runs it in place of
+// the awaiting one until it finishes, so a whole tree of nested tasks is
+// driven through the outermost one.
+class task {
+public:
+  struct promise_type;
+  using handle = std::coroutine_handle<promise_type>;
+
+  struct promise_type {
+    std::size_t work = 0;
+    promise_type *root = this;
+    handle current; // in the root, the innermost task that is running
+    handle parent;
+
+    task get_return_object() noexcept {
+      current = handle::from_promise(*this);
+      return task(current);
+    }
+    std::suspend_always initial_suspend() noexcept { return {}; }
+    // hands control back to the awaiting task, if any
+    struct final_awaiter {
+      bool await_ready() noexcept { return false; }
+      std::coroutine_handle<> await_suspend(handle h) noexcept {
+        promise_type &p = h.promise();
+        if (!p.parent)
+          return std::noop_coroutine();
+        p.root->current = p.parent;
+        return p.parent;
+      }
+      void await_resume() noexcept {}
+    };
+    final_awaiter final_suspend() noexcept { return {}; }
+    std::suspend_always yield_value(const std::size_t w) noexcept {
+      root->work += w;
+      return {};
+    }
+    void return_void() noexcept {}
+    // the kernels do not throw
+    void unhandled_exception() noexcept { std::terminate(); }
+  };
+
+  task() noexcept = default;
+  task(task &&other) noexcept : h_(std::exchange(other.h_, {})) {}
+  task &operator=(task &&other) noexcept {
+    if (this != &other) {
+      if (h_)
+        h_.destroy();
+      h_ = std::exchange(other.h_, {});
+    }
+    return *this;
+  }
+  ~task() {
+    if (h_)
+      h_.destroy();
+  }
+
+  [[nodiscard]]
+  bool done() const noexcept {
+    return !h_ || h_.done();
+  }
+
+  // runs the innermost task up to its next co_yield or the end of the whole
+  // tree, returning the work yielded
+  std::size_t resume() noexcept {
+    promise_type &p = h_.promise();
+    p.work = 0;
+    p.current.resume();
+    return p.work;
+  }
+
+  bool await_ready() const noexcept { return false; }
+  std::coroutine_handle<> await_suspend(const handle caller) noexcept {
+    promise_type &p = h_.promise();
+    p.root = caller.promise().root;
+    p.parent = caller;
+    p.root->current = h_;
+    return h_;
+  }
+  void await_resume() const noexcept {}
+
+private:
+  explicit task(const handle h) noexcept : h_(h) {}
+  handle h_;
+};
+
+// The work of a product of xn by yn limbs done in one piece, on the scale of
+// NTT butterflies.
+inline std::size_t piece_work(const std::size_t xn, const std::size_t yn) noexcept {
+  return static_cast<std::size_t>(static_cast<double>(xn) *
+                                  std::pow(static_cast<double>(yn), 0.585) / 4) +
+         1;
+}
+
+// The NTT stages of x[0..n) for the field F, forward or inverse, in pieces of
+// STEP_GRAIN butterflies: whole blocks for the short stages and ranges of
+// butterflies within a block for the long ones.
+template <typename F>
+task transform_steps(limb *x, const std::size_t n, const limb *rt,
+                     const bool inverse) {
+  for (std::size_t s = 1; s < n; s <<= 1) {
+    const std::size_t h = inverse ? s : n / (2 * s);
+    const std::size_t blocks = std::max<std::size_t>(1, STEP_GRAIN / h);
+    const std::size_t w = std::min(h, STEP_GRAIN);
+    for (std::size_t i = 0; i < n; i += 2 * h * blocks) {
+      const std::size_t len = std::min(n - i, 2 * h * blocks);
+      for (std::size_t j = 0; j < h; j += w) {
+        if (inverse)
+          F::inverse_stage(x + i, len, rt, h, j, j + w);
+        else
+          F::forward_stage(x + i, len, rt, h, j, j + w);
+        co_yield len / (2 * h) * w;
+      }
+    }
+  }
+}
+
+template <typename F>
+task root_steps(limb *rt, const std::size_t n, const bool inverse) {
+  for (std::size_t h = 1; h < n; h <<= 1) {
+    for (std::size_t j = 0; j < h; j += STEP_GRAIN) {
+      const std::size_t hi = std::min(h, j + STEP_GRAIN);
+      F::root_range(rt, h, j, hi, inverse);
+      co_yield hi - j;
+    }
+  }
+}
+
+// x[0..n) = src[0..sn) mod P, zero padded
+template <typename F>
+task reduce_steps(limb *x, const std::size_t n, const limb *src,
+                  const std::size_t sn) {
+  for (std::size_t i = 0; i < n; i += STEP_GRAIN) {
+    const std::size_t hi = std::min(n, i + STEP_GRAIN);
+    for (std::size_t k = i; k < hi; k++)
+      x[k] = k < sn ? src[k] % F::MOD : 0;
+    co_yield hi - i;
+  }
+}
 
-  /**
-   * Multiplies this bigint by another bigint.
-   * @param b The bigint to multiply with.
-   * @return A new bigint representing the result.
-   */
-  [[nodiscard]]
-  bigint operator*(const bigint &b) const noexcept;
+// ntt_field<P, G>::convolve in pieces, on the calling thread, with fb and rt
+// n limbs of scratch owned by the caller. b == nullptr squares a.
+template <typename F>
+task convolve_steps(limb *c, const std::size_t n, const limb *a,
+                    const std::size_t an, const limb *b, const std::size_t bn,
+                    limb *fb, limb *rt) {
+  co_await root_steps<F>(rt, n, false);
+  co_await reduce_steps<F>(c, n, a, an);
+  co_await transform_steps<F>(c, n, rt, false);
+  if (b) {
+    co_await reduce_steps<F>(fb, n, b, bn);
+    co_await transform_steps<F>(fb, n, rt, false);
+  }
+  for (std::size_t i = 0; i < n; i += STEP_GRAIN) {
+    const std::size_t hi = std::min(n, i + STEP_GRAIN);
+    for (std::size_t k = i; k < hi; k++)
+      c[k] = F::mul(c[k], b ? fb[k] : c[k]);
+    co_yield hi - i;
+  }
+  co_await root_steps<F>(rt, n, true);
+  co_await transform_steps<F>(c, n, rt, true);
+  const limb n_inv = F::pow(static_cast<limb>(n % F::MOD), F::MOD - 2);
+  for (std::size_t i = 0; i < n; i += STEP_GRAIN) {
+    const std::size_t hi = std::min(n, i + STEP_GRAIN);
+    for (std::size_t k = i; k < hi; k++)
+      c[k] = F::mul(c[k], n_inv);
+    co_yield hi - i;
+  }
+}
 
-  /**
-   * Multiplies this bigint by another bigint in-place.
-   * @param b The bigint to multiply with.
-   * @return A reference to the updated bigint.
-   */
-  const bigint &operator*=(const bigint &b) noexcept;
+// the total work yielded by mul_ntt_steps
+inline std::size_t ntt_steps_work(const std::size_t rn, const bool square) noexcept {
+  const std::size_t n = std::bit_ceil(rn - 1);
+  const std::size_t stages = n / 2 * static_cast<std::size_t>(std::countr_zero(n));
+  const std::size_t inputs = square ? 1 : 2;
+  return 3 * (2 * (n - 1) + inputs * (n + stages) + n + stages + n) + rn;
+}
 
-  /**
-   * Computes the negation of this bigint.
-   * @return A new bigint representing the negated value.
-   */
-  [[nodiscard]]
-  bigint operator-() const noexcept;
+// mul_ntt in pieces, on the calling thread
+inline task mul_ntt_steps(limb *r, const limb *a, const std::size_t an,
+                          const limb *b, const std::size_t bn) {
+  const std::size_t rn = an + bn;
+  const std::size_t n = std::bit_ceil(rn - 1);
+  const limb *const sb = (a == b && an == bn) ? nullptr : b;
+  // owned rather than from the workspace, which other work on this thread
+  // uses between the steps
+  limb_vector buffer(5 * n);
+  limb *const c0 = buffer.data();
+  limb *const c1 = c0 + n;
+  limb *const c2 = c1 + n;
+  limb *const fb = c2 + n;
+  limb *const rt = fb + n;
+  co_await convolve_steps<ntt_p0>(c0, n, a, an, sb, bn, fb, rt);
+  co_await convolve_steps<ntt_p1>(c1, n, a, an, sb, bn, fb, rt);
+  co_await convolve_steps<ntt_p2>(c2, n, a, an, sb, bn, fb, rt);
+  dlimb carry_lo = 0;
+  dlimb carry_hi = 0;
+  for (std::size_t i = 0; i < rn; i += STEP_GRAIN) {
+    const std::size_t hi = std::min(rn, i + STEP_GRAIN);
+    ntt_garner(r, i, hi, n, c0, c1, c2, carry_lo, carry_hi);
+    co_yield hi - i;
+  }
+}
+} // namespace bigint_detail
 
+/**
+ * A multiplication, division or conversion to a string carried out in steps,
+ * for operands so large that the blocking operators would hold the calling
+ * thread for seconds. Each call to step() does a bounded amount of work and
+ * returns, so the operation can be interleaved with other work, and it can be
+ * abandoned at any point with cancel() or by destroying it. The operands are
+ * copied, so they need not outlive the operation.
+ *
+ * The steps use the algorithms of the blocking operators: products go
+ * through the NTT a group of butterflies at a time, quotients through
+ * Burnikel-Ziegler with such products, and conversions through the same
+ * divide and conquer on such quotients. Work is counted in units of about
+ * one NTT butterfly. Products of operands of up to a few thousand limbs are
+ * single pieces of work, done whole within one step. The steps run on the
+ * calling thread, which may differ from one step to the next.
+ */
+class bigint_operation {
+public:
   /**
-   * Checks equality between two bigints.
-   * @param b The bigint to compare with.
-   * @return True if the two bigints are equal, false otherwise.
+   * Starts a multiplication.
+   * @param a The first factor.
+   * @param b The second factor.
+   * @return The operation, with no work done yet.
    */
   [[nodiscard]]
-  bool operator==(const bigint &b) const noexcept;
+  static bigint_operation multiply(const bigint &a, const bigint &b) noexcept;
 
   /**
-   * Checks inequality between two bigints.
-   * @param b The bigint to compare with.
-   * @return True if the two bigints are not equal, false otherwise.
+   * Starts a division, truncating towards zero like operator/ and operator%.
+   * @param a The dividend.
+   * @param b The divisor.
+   * @return The operation, with no work done yet.
+   * @throws std::domain_error if b is 0.
    */
   [[nodiscard]]
-  bool operator!=(const bigint &b) const noexcept;
+  static bigint_operation divide(const bigint &a,
+                                 const bigint &b) noexcept(false);
 
   /**
-   * Checks if this bigint is less than another bigint.
-   * @param b The bigint to compare with.
-   * @return True if this bigint is less than the given bigint, false otherwise.
+   * Starts a conversion to a string, like bigint::to_string.
+   * @param x The value to convert.
+   * @param base The base, between 2 and 36.
+   * @return The operation, with no work done yet.
+   * @throws std::invalid_argument if base is out of range.
    */
   [[nodiscard]]
-  bool operator<(const bigint &b) const noexcept;
+  static bigint_operation to_string(const bigint &x,
+                                    int base = 10) noexcept(false);
 
   /**
-   * Checks if this bigint is greater than another bigint.
-   * @param b The bigint to compare with.
-   * @return True if this bigint is greater than the given bigint, false
-   * otherwise.
+   * Runs the operation until at least the given amount of work is done, or
+   * to its end, overshooting by at most one piece of work.
+   * @param work The amount of work, in units of about one NTT butterfly.
+   * @return True if nothing is left to run, because the operation has
+   * finished or was cancelled.
    */
-  [[nodiscard]]
-  bool operator>(const bigint &b) const noexcept;
+  bool step(std::size_t work) noexcept;
 
   /**
-   * Checks if this bigint is less than or equal to another bigint.
-   * @param b The bigint to compare with.
-   * @return True if this bigint is less than or equal to the given bigint,
-   * false otherwise.
+   * @return True if the operation has finished and its result is available.
    */
   [[nodiscard]]
-  bool operator<=(const bigint &b) const noexcept;
+  bool done() const noexcept;
 
   /**
-   * Checks if this bigint is greater than or equal to another bigint.
-   * @param b The bigint to compare with.
-   * @return True if this bigint is greater than or equal to the given bigint,
-   * false otherwise.
+   * @return True if the operation was cancelled.
    */
   [[nodiscard]]
-  bool operator>=(const bigint &b) const noexcept;
+  bool cancelled() const noexcept;
 
   /**
-   * Prefix increment operator.
-   * @return A reference to the updated bigint.
+   * @return An estimate of the fraction of the work done so far, which does
+   * not decrease between steps and is 1 once the operation has finished.
    */
   [[nodiscard]]
-  const bigint &operator++() noexcept;
+  double progress() const noexcept;
 
   /**
-   * Postfix increment operator.
-   * @return A new bigint representing the value before the increment.
+   * Abandons the operation and frees its memory. Later steps do nothing.
    */
-  [[nodiscard]]
-  bigint operator++(int) noexcept;
+  void cancel() noexcept;
 
   /**
-   * Prefix decrement operator.
-   * @return A reference to the updated bigint.
+   * @return The product of a multiplication or the quotient of a division.
+   * @throws std::logic_error if the operation has not finished.
    */
   [[nodiscard]]
-  const bigint &operator--() noexcept;
+  const bigint &value() const noexcept(false);
 
   /**
-   * Postfix decrement operator.
-   * @return A new bigint representing the value before the decrement.
+   * @return The remainder of a division, which takes the sign of the
+   * dividend.
+   * @throws std::logic_error if the operation has not finished.
    */
   [[nodiscard]]
-  bigint operator--(int) noexcept;
+  const bigint &remainder() const noexcept(false);
 
   /**
-   * Outputs the bigint to the given output stream.
-   * @param os The output stream.
-   * @param a The bigint to output.
-   * @return The output stream.
+   * @return The digits of a conversion to a string.
+   * @throws std::logic_error if the operation has not finished.
    */
-  friend std::ostream &operator<<(std::ostream &os, const bigint &a) noexcept;
+  [[nodiscard]]
+  const std::string &str() const noexcept(false);
 
 private:
-  static constexpr WORD WORD_MAX = 9;
-  static constexpr WORD BASE = 10;
+  // the operands and results, at a fixed address for the coroutines
+  struct state {
+    bigint a;
+    bigint b;
+    bool a_sign = false;
+    bool b_sign = false;
+    bigint value;
+    bigint rem;
+    std::string digits;
+    char *out = nullptr;
+    std::size_t total = 1;
+    std::size_t work_done = 0;
+    bigint_detail::task run;
+  };
+  std::unique_ptr<state> st_;
+  bool cancelled_ = false;
 
-  void val_plus(const bigint &b, std::size_t offset = 0) noexcept;
-  void val_monus(const bigint &b) noexcept;
-  void val_mult(const bigint &b) noexcept;
+  bigint_operation() noexcept : st_(std::make_unique<state>()) {}
+  void check_done() const noexcept(false);
 
-  [[nodiscard]]
-  bool val_less(const bigint &b) const noexcept;
-  [[nodiscard]]
-  bool val_more(const bigint &b) const noexcept;
-  [[nodiscard]]
-  bool is_zero() const noexcept;
+  static bigint_detail::task multiply_task(state &s, bool square);
+  static bigint_detail::task divide_task(state &s);
+  static bigint_detail::task to_string_task(state &s, int base);
+
+  static std::size_t slice_limbs(std::size_t yn) noexcept;
+  static bigint_detail::task mul_steps(bigint &r, const bigint &a,
+                                       const bigint &b);
+  static std::size_t mul_work(std::size_t an, std::size_t bn,
+                              bool square) noexcept;
+  static std::size_t div_cut() noexcept;
+  static std::size_t short_digit(std::size_t an, std::size_t bn) noexcept;
+  static void place_digit(bigint &q, const bigint &qd, std::size_t k) noexcept;
+  static bigint_detail::task divmod_steps(const bigint &a, const bigint &b,
+                                          bigint &q, bigint &r);
+  static std::size_t divmod_work(std::size_t an, std::size_t bn) noexcept;
+  static bigint_detail::task div2n1n_steps(const bigint &a, const bigint &b,
+                                           std::size_t n, bigint &q,
+                                           bigint &r);
+  static std::size_t div2n1n_work(std::size_t n) noexcept;
+  static bigint_detail::task div3n2n_steps(const bigint &a12, const bigint &a3,
+                                           const bigint &b, const bigint &b1,
+                                           const bigint &b2, std::size_t n,
+                                           bigint &q, bigint &r);
+  static bigint_detail::task radix_steps(char *&out, const bigint &x, int base,
+                                         std::size_t width,
+                                         const std::vector<bigint> &powers);
+  static std::size_t radix_work(std::size_t n) noexcept;
 };
 
-inline bigint::bigint(int64_t n) noexcept : sign(false) {
-  if (!n) {
-    val.push_back(0);
-  }
-  if (n < 0) {
-    sign = true;
-  }
-  n = std::abs(n);
-  WORD chunk = static_cast<WORD>(n % BASE);
-  while (n > 0) {
-    val.push_back(chunk);
-    n /= BASE;
-    chunk = static_cast<WORD>(n % BASE);
+inline bigint_operation bigint_operation::multiply(const bigint &a,
+                                                   const bigint &b) noexcept {
+  bigint_operation op;
+  state &s = *op.st_;
+  const bool square = &a == &b;
+  s.a = a;
+  s.a_sign = a.sign;
+  s.a.sign = false;
+  if (!square) {
+    s.b = b;
+    s.b.sign = false;
   }
+  s.b_sign = b.sign;
+  s.total = mul_work(a.val.size(), b.val.size(), square);
+  s.run = multiply_task(s, square);
+  return op;
 }
 
-inline bigint::bigint(std::string_view sv, int base) noexcept(false)
-    : bigint() {
-  bool alnum_flg = false;
-  for (char ch : sv) {
-    if (std::isalnum(ch)) {
-      alnum_flg = true;
-      if (std::toupper(ch) - '0' >= base) {
-        std::stringstream ss;
-        ss << "invalid character " << std::quoted(std::string{ch})
-           << " used for integer of base " << base;
-        throw std::invalid_argument(ss.str());
-      }
-    } else if (ch == '-' && !alnum_flg && !sign) {
-      sign = true;
-    } else {
-      std::stringstream ss;
-      ss << "invalid character " << std::quoted(std::string{ch}) << " found";
-      throw std::invalid_argument(ss.str());
-    }
-  }
-  if (sign) {
-    sv = sv.substr(1);
-  }
-  if (sv.size() == 1 && sv[0] == '0') { // 0 case, make +ve 0
-    sign = false;
-    return;
+inline bigint_operation bigint_operation::divide(const bigint &a,
+                                                 const bigint &b) noexcept(false) {
+  if (b.is_zero())
+    throw std::domain_error("division by zero");
+  bigint_operation op;
+  state &s = *op.st_;
+  s.a = a;
+  s.b = b;
+  s.a_sign = a.sign;
+  s.b_sign = b.sign;
+  s.a.sign = s.b.sign = false;
+  s.total = divmod_work(a.val.size(), b.val.size());
+  s.run = divide_task(s);
+  return op;
+}
+
+inline bigint_operation bigint_operation::to_string(const bigint &x,
+                                                    const int base) noexcept(false) {
+  if (base < 2 || base > 36)
+    throw std::invalid_argument("base must be between 2 and 36");
+  bigint_operation op;
+  state &s = *op.st_;
+  s.a = x;
+  s.a.sign = false;
+  s.digits.assign(x.max_digits(base), '\0');
+  s.out = s.digits.data();
+  if (x.sign)
+    *s.out++ = '-';
+  const std::size_t n = x.val.size();
+  if (std::has_single_bit(static_cast<unsigned>(base))) {
+    s.total = n;
+  } else {
+    // the conversion and the squarings for its powers of the base
+    s.total = radix_work(n);
+    for (std::size_t m = 1; 4 * m <= n; m *= 2)
+      s.total += mul_work(m, m, true);
   }
+  s.run = to_string_task(s, base);
+  return op;
+}
 
-  std::size_t wnd_size = 1;
+inline bool bigint_operation::step(const std::size_t work) noexcept {
+  if (!st_)
+    return true;
+  std::size_t w = 0;
+  while (!st_->run.done() && w < work)
+    w += st_->run.resume();
+  st_->work_done += w;
+  return st_->run.done();
+}
 
-  std::size_t offset = sv.size() % wnd_size;
-  WORD wnd;
-  std::string_view sub;
-  if (offset) {
-    sub = sv.substr(0, offset);
-    std::from_chars(sub.data(), sub.data() + sub.size(), wnd, base);
-    *this += wnd;
-  }
-  for (std::size_t pos = offset; pos < sv.size(); pos += wnd_size) {
-    sub = sv.substr(pos, wnd_size);
-    std::from_chars(sub.data(), sub.data() + sub.size(), wnd, base);
-    *this *= static_cast<WORD>(std::pow(base, wnd_size));
-    *this += wnd;
-  }
+inline bool bigint_operation::done() const noexcept {
+  return st_ && st_->run.done();
 }
 
-#ifdef DOCTEST_LIBRARY_INCLUDED
-TEST_CASE("[bigint] constructor") {
-  CHECK_NOTHROW(bigint _("111111111222222222"));
-  CHECK_NOTHROW(bigint _("1111111112222222223"));
+inline bool bigint_operation::cancelled() const noexcept { return cancelled_; }
+
+inline double bigint_operation::progress() const noexcept {
+  if (!st_)
+    return 0;
+  if (st_->run.done())
+    return 1;
+  // the total is estimated from the operand sizes alone
+  return std::min(static_cast<double>(st_->work_done) /
+                      static_cast<double>(st_->total),
+                  std::nextafter(1.0, 0.0));
 }
 
-TEST_CASE("[bigint] spaces should throw invalid_argument") {
-  CHECK_THROWS_AS(bigint _(" 12"), std::invalid_argument);
-  CHECK_THROWS_AS(bigint _("   12"), std::invalid_argument);
-  CHECK_THROWS_AS(bigint _("12   "), std::invalid_argument);
-  CHECK_THROWS_AS(bigint _("1   2"), std::invalid_argument);
-  CHECK_THROWS_AS(bigint _(" 1  2"), std::invalid_argument);
+inline void bigint_operation::cancel() noexcept {
+  st_.reset();
+  cancelled_ = true;
 }
 
-TEST_CASE("[bigint] invalid \"-\" sign should throw invalid_argument") {
-  CHECK_THROWS_AS(bigint _("--12"), std::invalid_argument);
-  CHECK_THROWS_AS(bigint _("-1-2"), std::invalid_argument);
-  CHECK_THROWS_AS(bigint _("-12-"), std::invalid_argument);
-  CHECK_THROWS_AS(bigint _("12-"), std::invalid_argument);
-  CHECK_THROWS_AS(bigint _("12--"), std::invalid_argument);
+inline void bigint_operation::check_done() const noexcept(false) {
+  if (!done())
+    throw std::logic_error("operation has not finished");
 }
 
-TEST_CASE("[bigint] invalid character should throw invalid_argument") {
-  CHECK_THROWS_AS(bigint _("12?"), std::invalid_argument);
-  CHECK_THROWS_AS(bigint _("1?2"), std::invalid_argument);
-  CHECK_THROWS_AS(bigint _("?12"), std::invalid_argument);
-  CHECK_THROWS_AS(bigint _("*)?"), std::invalid_argument);
+inline const bigint &bigint_operation::value() const noexcept(false) {
+  check_done();
+  return st_->value;
 }
-#endif
 
-// addition operator
+inline const bigint &bigint_operation::remainder() const noexcept(false) {
+  check_done();
+  return st_->rem;
+}
 
-inline bigint bigint::operator+(const WORD b) const noexcept {
-  bigint res;
-  res += *this;
-  res += b;
-  return res;
+inline const std::string &bigint_operation::str() const noexcept(false) {
+  check_done();
+  return st_->digits;
 }
 
-inline const bigint &bigint::operator+=(const WORD b) noexcept {
-  WORD carry = b;
-  for (std::size_t i = 0; i < val.size(); i++) {
-    const WORD ai = val[i];
-    val[i] = (ai + carry) % BASE;
-    carry = (ai + carry) / 10;
-    if (!carry)
-      break;
-  }
-  if (carry > 0) {
-    val.push_back(carry);
-  }
-  return *this;
+inline bigint_detail::task bigint_operation::multiply_task(state &s,
+                                                           const bool square) {
+  co_await mul_steps(s.value, s.a, square ? s.a : s.b);
+  s.value.sign = !s.value.is_zero() && s.a_sign != s.b_sign;
 }
 
-inline bigint bigint::operator+(const bigint &b) const noexcept {
-  bigint res;
-  res += *this;
-  res += b;
-  return res;
+inline bigint_detail::task bigint_operation::divide_task(state &s) {
+  co_await divmod_steps(s.a, s.b, s.value, s.rem);
+  s.value.sign = !s.value.is_zero() && s.a_sign != s.b_sign;
+  s.rem.sign = !s.rem.is_zero() && s.a_sign;
 }
 
-inline const bigint &bigint::operator+=(const bigint &b) noexcept {
-  if (is_zero()) {
-    sign = b.sign;
-    val_plus(b);
-  } else if (sign == b.sign) {
-    val_plus(b);
+inline bigint_detail::task bigint_operation::to_string_task(state &s,
+                                                            const int base) {
+  const auto b = static_cast<unsigned>(base);
+  const std::size_t n = s.a.val.size();
+  if (std::has_single_bit(b)) {
+    // linear in the size anyway
+    bigint::write_pow2(s.out, s.a, static_cast<unsigned>(std::countr_zero(b)));
+    co_yield n;
   } else {
-    if (val_less(b)) {
-      const bigint a = *this;
-      *this = b;
-      val_monus(a);
-    } else {
-      val_monus(b);
+    // chunk_of(base).power^(2^i) up to half the size of x, as radix_power
+    // but owned by the operation, which may move between threads
+    std::vector<bigint> powers(1);
+    powers[0].val[0] = bigint_detail::chunk_of(base).power;
+    while (2 * (2 * powers.back().val.size() - 1) <= n + 1) {
+      bigint next;
+      co_await mul_steps(next, powers.back(), powers.back());
+      if (2 * next.val.size() > n + 1)
+        break;
+      powers.push_back(std::move(next));
     }
-    if (is_zero()) {
-      sign = false;
+    co_await radix_steps(s.out, s.a, base, 0, powers);
+  }
+  s.digits.resize(static_cast<std::size_t>(s.out - s.digits.data()));
+}
+
+// the size of the slices of the larger operand in a product that is
+// neither a single piece nor an NTT
+inline std::size_t bigint_operation::slice_limbs(const std::size_t yn) noexcept {
+  using bigint_detail::STEP_LIMBS;
+  return yn >= bigint::thresholds.ntt
+             ? bigint_detail::NTT_MAX_LEN - yn
+             : std::max(yn, STEP_LIMBS * STEP_LIMBS / yn);
+}
+
+// r = |a| |b|, where r must not be a or b
+inline bigint_detail::task bigint_operation::mul_steps(bigint &r,
+                                                       const bigint &a,
+                                                       const bigint &b) {
+  using bigint_detail::STEP_LIMBS;
+  const bigint &x = a.val.size() >= b.val.size() ? a : b;
+  const bigint &y = a.val.size() >= b.val.size() ? b : a;
+  const std::size_t xn = x.val.size();
+  const std::size_t yn = y.val.size();
+  const std::size_t k = slice_limbs(yn);
+  const bool small = xn * yn <= STEP_LIMBS * STEP_LIMBS;
+  if (!small && yn >= bigint::thresholds.ntt &&
+      xn + yn <= bigint_detail::NTT_MAX_LEN) {
+    r.val.assign(xn + yn, 0);
+    co_await bigint_detail::mul_ntt_steps(r.val.data(), x.val.data(), xn,
+                                          y.val.data(), yn);
+    r.trim();
+    r.sign = false;
+  } else if (small || xn <= k || 2 * yn > bigint_detail::NTT_MAX_LEN) {
+    r = &a == &b ? x * x : x * y;
+    r.sign = false;
+    co_yield bigint_detail::piece_work(xn, yn);
+  } else {
+    r = bigint();
+    for (std::size_t lo = 0; lo < xn; lo += k) {
+      const bigint slice = bigint::limb_slice(x, lo, lo + k);
+      bigint t;
+      co_await mul_steps(t, slice, y);
+      r.val_plus(t, lo);
     }
+    r.trim();
   }
-  return *this;
 }
 
-#ifdef DOCTEST_LIBRARY_INCLUDED
-TEST_CASE("[bigint] additions") {
-  // Addition of zero
-  CHECK_EQ(bigint(0) + bigint(0), bigint(0));
-  CHECK_EQ(bigint(12345) + bigint(0), bigint(12345));
-  CHECK_EQ(bigint(0) + bigint(12345), bigint(12345));
+inline std::size_t bigint_operation::mul_work(const std::size_t an,
+                                              const std::size_t bn,
+                                              const bool square) noexcept {
+  using bigint_detail::STEP_LIMBS;
+  const std::size_t xn = std::max(an, bn);
+  const std::size_t yn = std::min(an, bn);
+  const std::size_t k = slice_limbs(yn);
+  const bool small = xn * yn <= STEP_LIMBS * STEP_LIMBS;
+  if (!small && yn >= bigint::thresholds.ntt &&
+      xn + yn <= bigint_detail::NTT_MAX_LEN)
+    return bigint_detail::ntt_steps_work(xn + yn, square);
+  if (small || xn <= k || 2 * yn > bigint_detail::NTT_MAX_LEN)
+    return bigint_detail::piece_work(xn, yn);
+  return xn / k * mul_work(k, yn, false) +
+         (xn % k ? mul_work(xn % k, yn, false) : 0);
+}
 
-  // Positive number addition
-  CHECK_EQ(bigint(12345) + bigint(67890), bigint(80235));
-  CHECK_EQ(bigint(999999) + bigint(1), bigint(1000000));
+// the divisor size from which a quotient is not a single piece
+inline std::size_t bigint_operation::div_cut() noexcept {
+  return std::max(bigint_detail::STEP_LIMBS, bigint::div_threshold);
+}
 
-  // Negative number addition
-  CHECK_EQ(bigint(-12345) + bigint(-67890), bigint(-80235));
-  CHECK_EQ(bigint(-999999) + bigint(-1), bigint(-1000000));
+// the digit size in limbs, at most the dividend, in which a dividend of an
+// limbs is divided by a short divisor of bn limbs
+inline std::size_t bigint_operation::short_digit(const std::size_t an,
+                                                 const std::size_t bn) noexcept {
+  using bigint_detail::STEP_LIMBS;
+  return std::min(an, std::max(bn, STEP_LIMBS * STEP_LIMBS / bn));
+}
 
-  // Mixed sign addition
-  CHECK_EQ(bigint(12345) + bigint(-67890), bigint(-55545));
-  CHECK_EQ(bigint(-12345) + bigint(67890), bigint(55545));
-  CHECK_EQ(bigint(67890) + bigint(-12345), bigint(55545));
+// writes the quotient digit qd into q from limb k on, where the limbs of qd
+// past the end of q are zero
+inline void bigint_operation::place_digit(bigint &q, const bigint &qd,
+                                          const std::size_t k) noexcept {
+  if (k >= q.val.size())
+    return;
+  std::copy_n(qd.val.begin(), std::min(qd.val.size(), q.val.size() - k),
+              q.val.begin() + static_cast<std::ptrdiff_t>(k));
+}
 
-  // Addition resulting in zero
-  CHECK_EQ(bigint(12345) + bigint(-12345), bigint(0));
-  CHECK_EQ(bigint(-12345) + bigint(12345), bigint(0));
+// q = |a| / |b| and r = |a| % |b| as in bigint::val_divmod, where q and r
+// must not be a or b
+inline bigint_detail::task bigint_operation::divmod_steps(const bigint &a,
+                                                          const bigint &b,
+                                                          bigint &q,
+                                                          bigint &r) {
+  const std::size_t an = a.val.size();
+  const std::size_t bn = b.val.size();
+  if (a.val_less(b)) {
+    q = bigint();
+    r = a;
+    r.sign = false;
+    co_yield 1;
+    co_return;
+  }
+  if (bn < div_cut()) {
+    // a short divisor, with the dividend taken in digits of d limbs that are
+    // each a single piece
+    const std::size_t d = short_digit(an, bn);
+    const std::size_t digits = (an + d - 1) / d;
+    q.val.assign(an - bn + 1, 0);
+    q.sign = false;
+    r = bigint();
+    for (std::size_t i = digits; i-- > 0;) {
+      r.val_shl_limbs(d);
+      r.val_plus(bigint::limb_slice(a, i * d, (i + 1) * d));
+      bigint qd;
+      bigint::val_divmod(r, b, qd, r);
+      place_digit(q, qd, i * d);
+      co_yield 2 * bigint_detail::piece_work(d, bn);
+    }
+    q.trim();
+    co_return;
+  }
 
-  // Large number addition
-  CHECK_EQ(bigint("1234567891011121314151617181920") +
-               bigint("987654321098765432101234567890"),
-           bigint("2222222212109886746252851749810"));
-  CHECK_EQ(bigint("999999999999999999999999999999") + bigint("1"),
-           bigint("1000000000000000000000000000000"));
+  // Burnikel-Ziegler on normalized operands, one bn-limb digit of the
+  // dividend at a time
+  const auto s = static_cast<unsigned>(std::countl_zero(b.val.back()));
+  bigint na = a;
+  bigint nb = b;
+  na.sign = nb.sign = false;
+  if (s) {
+    bigint_detail::lshift(nb.val.data(), nb.val.data(), bn, s);
+    const bigint_detail::limb out =
+        bigint_detail::lshift(na.val.data(), na.val.data(), an, s);
+    if (out)
+      na.val.push_back(out);
+  }
+  const std::size_t digits = (na.val.size() + bn - 1) / bn;
+  q.val.assign(an - bn + 1, 0);
+  q.sign = false;
+  r = bigint();
+  for (std::size_t i = digits; i-- > 0;) {
+    r.val_shl_limbs(bn);
+    r.val_plus(bigint::limb_slice(na, i * bn, (i + 1) * bn));
+    bigint qd;
+    co_await div2n1n_steps(r, nb, bn, qd, r);
+    place_digit(q, qd, i * bn);
+  }
+  q.trim();
+  if (s) {
+    bigint_detail::rshift(r.val.data(), r.val.data(), r.val.size(), s);
+    r.trim();
+  }
 }
 
-TEST_CASE("[bigint] addition chaining") {
-  CHECK_EQ(bigint(12345) + bigint(67890) + bigint(11111), bigint(91346));
-  CHECK_EQ(bigint(12345) + bigint(-12345) + bigint(67890), bigint(67890));
-  CHECK_EQ(bigint(12345) + bigint(0) + bigint(-12345), bigint(0));
+inline std::size_t bigint_operation::divmod_work(const std::size_t an,
+                                                 const std::size_t bn) noexcept {
+  if (an < bn)
+    return 1;
+  if (bn < div_cut()) {
+    const std::size_t d = short_digit(an, bn);
+    return (an + d - 1) / d * 2 * bigint_detail::piece_work(d, bn);
+  }
+  // in proportion to the length of the quotient, since the top digit of the
+  // dividend is short
+  return static_cast<std::size_t>(static_cast<double>(an - bn + 1) /
+                                  static_cast<double>(bn) *
+                                  static_cast<double>(div2n1n_work(bn))) +
+         bn;
 }
 
-TEST_CASE("[bigint] addition edge cases") {
-  CHECK_EQ(bigint("123456789123456789123456789") +
-               bigint("987654321987654321987654321"),
-           bigint("1111111111111111111111111110"));
-  CHECK_EQ(bigint("-123456789123456789123456789") +
-               bigint("987654321987654321987654321"),
-           bigint("864197532864197532864197532"));
-  CHECK_EQ(bigint("-1000000000000000000000000") + bigint(1),
-           bigint("-999999999999999999999999"));
-  CHECK_EQ(bigint("1000000000000000000000000") + bigint(-1),
-           bigint("999999999999999999999999"));
+// bigint::bz_div2n1n, where a and r may alias
+inline bigint_detail::task
+bigint_operation::div2n1n_steps(const bigint &a, const bigint &b,
+                                const std::size_t n, bigint &q, bigint &r) {
+  if (a.val.size() <= n + 1) {
+    // a quotient of at most one limb, such as for the top digit of a dividend
+    bigint::bz_div2n1n(a, b, n, q, r);
+    co_yield n;
+    co_return;
+  }
+  if (n < div_cut()) {
+    bigint::bz_div2n1n(a, b, n, q, r);
+    co_yield 2 * bigint_detail::piece_work(n, n);
+    co_return;
+  }
+  if (n & 1) {
+    bigint pa = a;
+    bigint pb = b;
+    pa.val_shl_limbs(1);
+    pb.val_shl_limbs(1);
+    co_await div2n1n_steps(pa, pb, n + 1, q, r);
+    if (!r.is_zero())
+      r.val.erase(r.val.begin());
+    co_return;
+  }
+  const std::size_t h = n / 2;
+  const bigint b1 = bigint::limb_slice(b, h, n);
+  const bigint b2 = bigint::limb_slice(b, 0, h);
+  const bigint a12 = bigint::limb_slice(a, n, 2 * n);
+  const bigint a3 = bigint::limb_slice(a, h, n);
+  const bigint a4 = bigint::limb_slice(a, 0, h);
+  bigint q1;
+  co_await div3n2n_steps(a12, a3, b, b1, b2, h, q1, r);
+  co_await div3n2n_steps(r, a4, b, b1, b2, h, q, r);
+  q1.val_shl_limbs(h);
+  q1.val_plus(q);
+  q = std::move(q1);
 }
-#endif
 
-// multiplication operator
+inline std::size_t bigint_operation::div2n1n_work(const std::size_t n) noexcept {
+  if (n < div_cut())
+    return 2 * bigint_detail::piece_work(n, n);
+  if (n & 1)
+    return div2n1n_work(n + 1);
+  return 2 * (div2n1n_work(n / 2) + mul_work(n / 2, n / 2, false));
+}
 
-inline bigint bigint::operator*(const WORD b) const noexcept {
-  bigint res;
-  res += *this;
-  res *= b;
-  return res;
+// bigint::bz_div3n2n, where a12 and r may alias
+inline bigint_detail::task bigint_operation::div3n2n_steps(
+    const bigint &a12, const bigint &a3, const bigint &b, const bigint &b1,
+    const bigint &b2, const std::size_t n, bigint &q, bigint &r) {
+  if (bigint::limb_slice(a12, n, a12.val.size()) == b1) {
+    q.val.assign(n, std::numeric_limits<bigint_detail::limb>::max());
+    q.sign = false;
+    bigint t = b1;
+    t.val_shl_limbs(n);
+    r = a12 - t + b1;
+  } else {
+    co_await div2n1n_steps(a12, b1, n, q, r);
+  }
+  r.val_shl_limbs(n);
+  r += a3;
+  bigint t;
+  co_await mul_steps(t, q, b2);
+  r -= t;
+  while (r.sign) {
+    q -= 1;
+    r += b;
+  }
 }
 
-inline const bigint &bigint::operator*=(const WORD b) noexcept {
-  if (is_zero())
-    return *this;
-  if (!b) {
-    val.clear();
-    val.push_back(0);
-    sign = false;
-    return *this;
+// bigint::write_radix with the powers of the base given
+inline bigint_detail::task
+bigint_operation::radix_steps(char *&out, const bigint &x, const int base,
+                              const std::size_t width,
+                              const std::vector<bigint> &powers) {
+  const std::size_t n = x.val.size();
+  if (n <= bigint_detail::STEP_LIMBS) {
+    bigint::write_radix(out, x, base, width);
+    co_yield radix_work(n);
+    co_return;
   }
-  WORD carry = 0;
-  for (WORD &ai : val) {
-    WORD prod = ai * b;
-    ai = (prod + carry) % BASE;
-    carry = (prod + carry) / BASE;
+  std::size_t i = 0;
+  while (i + 1 < powers.size() && 2 * powers[i + 1].val.size() <= n + 1)
+    i++;
+  bigint q;
+  bigint r;
+  co_await divmod_steps(x, powers[i], q, r);
+  const std::size_t low_digits = bigint_detail::chunk_of(base).digits << i;
+  if (width || !q.is_zero())
+    co_await radix_steps(out, q, base, width ? width - low_digits : 0, powers);
+  co_await radix_steps(out, r, base, q.is_zero() && !width ? 0 : low_digits,
+                       powers);
+}
+
+inline std::size_t bigint_operation::radix_work(const std::size_t n) noexcept {
+  if (n <= bigint_detail::STEP_LIMBS)
+    return bigint_detail::piece_work(n, n) *
+           static_cast<std::size_t>(std::bit_width(n));
+  return divmod_work(n, n / 2) + 2 * radix_work(n / 2);
+}
+
+#ifdef DOCTEST_LIBRARY_INCLUDED
+TEST_CASE("[bigint] step-wise operations") {
+  const auto saved = bigint::thresholds;
+  // products from 1000 limbs through the NTT, so that moderate sizes take
+  // the step-wise NTT
+  bigint::thresholds.ntt = 1000;
+  const bigint a = pow(bigint(3), 60000) + bigint(12345);
+  const bigint b = pow(bigint(7), 50000) - bigint(1);
+  const auto run = [](bigint_operation &op) {
+    std::size_t steps = 0;
+    double last = op.progress();
+    // one piece of work at a time
+    while (!op.step(1)) {
+      CHECK(op.progress() >= last);
+      CHECK(op.progress() < 1);
+      last = op.progress();
+      steps++;
+    }
+    CHECK(op.done());
+    CHECK_EQ(op.progress(), 1.0);
+    return steps;
+  };
+
+  bigint_operation op = bigint_operation::multiply(a, -b);
+  CHECK_FALSE(op.done());
+  CHECK_EQ(op.progress(), 0.0);
+  CHECK_THROWS_AS(static_cast<void>(op.value()), std::logic_error);
+  CHECK(run(op) > 10);
+  CHECK_EQ(op.value(), a * -b);
+  op = bigint_operation::multiply(a, a);
+  run(op);
+  CHECK_EQ(op.value(), a * a);
+  // slices of the larger operand against a short one
+  const bigint c = pow(bigint(10), 4500) + bigint(1);
+  const bigint ab = a * b;
+  const bigint n = ab * b + a;
+  op = bigint_operation::multiply(c, n);
+  run(op);
+  CHECK_EQ(op.value(), c * n);
+  op = bigint_operation::multiply(bigint(0), -ab);
+  run(op);
+  CHECK_EQ(op.value(), bigint(0));
+
+  // Burnikel-Ziegler with step-wise products, and short divisors
+  for (const bigint &d : {b, -b, c, bigint(-12345)}) {
+    for (const bigint &x : {n, -n, a}) {
+      op = bigint_operation::divide(x, d);
+      run(op);
+      CHECK_EQ(op.value(), x / d);
+      CHECK_EQ(op.remainder(), x % d);
+    }
   }
-  if (carry > 0) {
-    val.push_back(carry);
+  CHECK_THROWS_AS(static_cast<void>(bigint_operation::divide(a, bigint(0))),
+                  std::domain_error);
+  // a short dividend gets a quotient of its own size
+  const bigint small = pow(bigint(10), 90) + bigint(3);
+  op = bigint_operation::divide(small, bigint(7));
+  run(op);
+  CHECK_EQ(op.value(), small / 7);
+  CHECK_LE(op.value().capacity(), small.capacity());
+
+  for (const int base : {10, 7, 16, 36}) {
+    op = bigint_operation::to_string(-n, base);
+    run(op);
+    CHECK_EQ(op.str(), (-n).to_string(base));
   }
+  // long runs of zero digits in the parts
+  const bigint p = pow(bigint(10), 80000);
+  op = bigint_operation::to_string(p);
+  run(op);
+  CHECK_EQ(op.str(), p.to_string());
+  CHECK_THROWS_AS(static_cast<void>(bigint_operation::to_string(a, 1)),
+                  std::invalid_argument);
 
-  return *this;
+  op = bigint_operation::multiply(a, b);
+  op.step(bigint_detail::STEP_GRAIN);
+  CHECK(op.progress() > 0);
+  op.cancel();
+  CHECK(op.cancelled());
+  CHECK(op.step(1));
+  CHECK_FALSE(op.done());
+  CHECK_THROWS_AS(static_cast<void>(op.value()), std::logic_error);
+  bigint::thresholds = saved;
+
+  // below the NTT threshold, as slices that are single pieces
+  op = bigint_operation::multiply(a, b);
+  run(op);
+  CHECK_EQ(op.value(), a * b);
 }
+#endif
 
-inline bigint bigint::operator*(const bigint &b) const noexcept {
-  bigint res;
-  res += *this;
-  res *= b;
-  return res;
+// statistics
+
+#ifdef DOCTEST_LIBRARY_INCLUDED
+TEST_CASE("[bigint] statistics") {
+  bigint_stats::reset();
+  const bigint a("123456789012345678901234567890");
+  bigint b = a * a;
+  b += a;
+  b -= bigint(1);
+  std::ostringstream os;
+  os << b;
+  bigint_stats s = bigint_stats::snapshot();
+  if constexpr (!bigint_stats::enabled) {
+    CHECK_EQ(s.parse_calls, 0u);
+    CHECK_EQ(s.mult_calls, 0u);
+    CHECK_EQ(s.allocations, 0u);
+    return;
+  }
+  CHECK_EQ(s.parse_calls, 1u);
+  CHECK_EQ(s.parse_chars, 30u);
+  CHECK_EQ(s.mult_calls, 1u);
+  CHECK_EQ(s.mult_limbs, 8u);
+  CHECK_EQ(s.mul_basecase, 1u);
+  CHECK_EQ(s.mul_karatsuba, 0u);
+  CHECK_GE(s.plus_calls, 1u);
+  CHECK_GE(s.monus_calls, 1u);
+  CHECK_EQ(s.print_calls, 1u);
+  CHECK_EQ(s.print_chars, os.str().size());
+  CHECK_GE(s.allocations, 1u);
+
+  // counts of exited threads are kept
+  std::thread([] { const bigint c("42"); }).join();
+  CHECK_EQ(bigint_stats::snapshot().parse_calls, 2u);
+  bigint_stats::reset();
+  CHECK_EQ(bigint_stats::snapshot().parse_calls, 0u);
+
+  // each tier is counted where it is chosen
+  const bigint x = pow(bigint(3), 2000);
+  const bigint y = pow(bigint(7), 1100);
+  const auto saved = bigint::thresholds;
+  bigint::thresholds = {24, 400, 5000};
+  bigint_stats::reset();
+  bigint z = x * y;
+  s = bigint_stats::snapshot();
+  CHECK_EQ(s.mult_calls, 1u);
+  CHECK_GE(s.mul_karatsuba, 1u);
+  CHECK_GE(s.mul_basecase, 3u);
+  CHECK_EQ(s.mul_toom3 + s.mul_ntt, 0u);
+  bigint::thresholds = {24, 400, 64};
+  bigint_stats::reset();
+  z = x * y;
+  s = bigint_stats::snapshot();
+  CHECK_EQ(s.mul_ntt, 1u);
+  CHECK_EQ(s.mul_karatsuba + s.mul_basecase, 0u);
+  bigint::thresholds = saved;
 }
 
-inline const bigint &bigint::operator*=(const bigint &b) noexcept {
-  sign = (sign != b.sign);
-  val_mult(b);
-  if (is_zero()) {
-    sign = false;
+// Also run on its own by CMake, so that the thread pool is created before
+// anything is counted and its workers exit after the other statics are gone.
+TEST_CASE("[bigint] statistics of parallel work") {
+  const auto saved = bigint::parallel;
+  bigint::parallel = {4, 1};
+  const bigint p =
+      bigint::product(std::execution::par, std::vector<int>(300000, 3));
+  CHECK_EQ(p, pow(bigint(3), 300000));
+  if constexpr (bigint_stats::enabled) {
+    CHECK_GE(bigint_stats::snapshot().mult_calls, 1u);
   }
-  return *this;
+  bigint::parallel = saved;
 }
+#endif
 
-#ifdef DOCTEST_LIBRARY_INCLUDED
-TEST_CASE("[bigint] multiplications") {
-  // Multiplication with zero
-  CHECK_EQ(bigint(0) * bigint(0), bigint(0));
-  CHECK_EQ(bigint(12345) * bigint(0), bigint(0));
-  CHECK_EQ(bigint(0) * bigint(12345), bigint(0));
+// operators with built-in integers
 
-  // Multiplication with one
-  CHECK_EQ(bigint(12345) * bigint(1), bigint(12345));
-  CHECK_EQ(bigint(1) * bigint(12345), bigint(12345));
+inline void bigint::add_small(const std::uint64_t m, const bool m_sign) noexcept {
+  if (!m)
+    return;
+  const WORD b[2] = {static_cast<WORD>(m), static_cast<WORD>(m >> WORD_BITS)};
+  const std::size_t bn = b[1] ? 2 : 1;
+  const std::size_t n = val.size();
+  if (sign == m_sign || is_zero()) {
+    sign = m_sign;
+    if (n < bn)
+      val.resize(bn);
+    WORD carry = bigint_detail::add_n(val.data(), val.data(), b, bn);
+    carry = bigint_detail::add_1(val.data() + bn, val.data() + bn,
+                                 val.size() - bn, carry);
+    if (carry)
+      val.push_back(carry);
+  } else if (n > bn ||
+             (n == bn && bigint_detail::cmp_n(val.data(), b, n) >= 0)) {
+    const WORD borrow = bigint_detail::sub_n(val.data(), val.data(), b, bn);
+    bigint_detail::sub_1(val.data() + bn, val.data() + bn, n - bn, borrow);
+    trim();
+    if (is_zero())
+      sign = false;
+  } else {
+    // |this| < m, so the difference fits in 64 bits
+    const std::uint64_t x = n == 2 ? DWORD{val[1]} << WORD_BITS | val[0] : val[0];
+    const std::uint64_t d = m - x;
+    val.assign(1, static_cast<WORD>(d));
+    if (d >> WORD_BITS)
+      val.push_back(static_cast<WORD>(d >> WORD_BITS));
+    sign = m_sign;
+  }
+}
 
-  // Positive number multiplication
-  CHECK_EQ(bigint(123) * bigint(456), bigint(56088));
-  CHECK_EQ(bigint(999) * bigint(999), bigint(998001));
+inline void bigint::mul_small(const std::uint64_t m, const bool m_sign) noexcept {
+  if (m <= WORD_MAX) {
+    *this *= static_cast<WORD>(m);
+  } else if (!is_zero()) {
+    const std::size_t n = val.size();
+    bigint res;
+    res.val.resize(n + 2);
+    WORD *r = res.val.data();
+    r[n] = bigint_detail::mul_1(r, val.data(), n, static_cast<WORD>(m));
+    r[n + 1] = bigint_detail::addmul_1(r + 1, val.data(), n,
+                                       static_cast<WORD>(m >> WORD_BITS));
+    res.trim();
+    res.sign = sign;
+    *this = std::move(res);
+  }
+  if (m_sign && !is_zero())
+    sign = !sign;
+}
 
-  // Negative number multiplication
-  CHECK_EQ(bigint(-123) * bigint(456), bigint(-56088));
-  CHECK_EQ(bigint(123) * bigint(-456), bigint(-56088));
-  CHECK_EQ(bigint(-123) * bigint(-456), bigint(56088));
+inline void bigint::div_small(const std::uint64_t m, const bool m_sign,
+                              const bool remainder) noexcept(false) {
+  if (m <= WORD_MAX) {
+    if (remainder) {
+      *this %= static_cast<WORD>(m);
+      return;
+    }
+    *this /= static_cast<WORD>(m);
+  } else {
+    // a two-limb divisor fits the inline storage of a bigint
+    bigint d;
+    d.val.assign(1, static_cast<WORD>(m));
+    d.val.push_back(static_cast<WORD>(m >> WORD_BITS));
+    bigint q, r;
+    val_divmod(*this, d, q, r);
+    const bool s = sign;
+    *this = std::move(remainder ? r : q);
+    sign = !is_zero() && s;
+    if (remainder)
+      return;
+  }
+  if (m_sign && !is_zero())
+    sign = !sign;
 }
 
-TEST_CASE("[bigint] multiplication chaining") {
-  CHECK_EQ(bigint(2) * bigint(3) * bigint(4), bigint(24));
-  CHECK_EQ(bigint(10) * bigint(-5) * bigint(2), bigint(-100));
-  CHECK_EQ(bigint(-2) * bigint(-3) * bigint(-4), bigint(-24));
+inline std::strong_ordering bigint::cmp_small(const std::uint64_t m,
+                                              const bool m_sign) const noexcept {
+  if (sign != m_sign)
+    return sign ? std::strong_ordering::less : std::strong_ordering::greater;
+  std::strong_ordering mag = std::strong_ordering::greater;
+  if (val.size() <= 2) {
+    const std::uint64_t x =
+        val.size() == 2 ? DWORD{val[1]} << WORD_BITS | val[0] : val[0];
+    mag = x <=> m;
+  }
+  return sign ? 0 <=> mag : mag;
 }
 
-TEST_CASE("[bigint] multiplication edge cases") {
-  CHECK_EQ(bigint("123456789123456789123456789123456789") *
-               bigint("987654321987654321987654321987654321"),
-           bigint("121932631356500531591068431825636331816338969581771069347203"
-                  "169112635269"));
-  CHECK_EQ(bigint("1000000000000000000") * bigint(-1),
-           bigint("-1000000000000000000"));
-  CHECK_EQ(bigint(1) * bigint("999999999999999999"),
-           bigint("999999999999999999"));
-  CHECK_EQ(bigint("-1") * bigint("999999999999999999"),
-           bigint("-999999999999999999"));
+template <bigint_detail::small_integer T>
+bigint bigint::operator+(const T b) const noexcept {
+  bigint res = copy_with_capacity(val.size() + 2);
+  res += b;
+  return res;
 }
-#endif
 
-// minus operator
+template <bigint_detail::small_integer T>
+const bigint &bigint::operator+=(const T b) noexcept {
+  const auto [m, m_sign] = bigint_detail::magnitude(b);
+  add_small(m, m_sign);
+  return *this;
+}
 
-inline bigint bigint::operator-(const bigint &b) const noexcept {
-  bigint res;
-  res += *this;
+template <bigint_detail::small_integer T>
+bigint bigint::operator-(const T b) const noexcept {
+  bigint res = copy_with_capacity(val.size() + 2);
   res -= b;
   return res;
 }
 
-inline const bigint &bigint::operator-=(const bigint &b) noexcept {
-  *this += -b;
+template <bigint_detail::small_integer T>
+const bigint &bigint::operator-=(const T b) noexcept {
+  const auto [m, m_sign] = bigint_detail::magnitude(b);
+  add_small(m, !m_sign && m);
   return *this;
 }
 
-inline bigint bigint::operator-() const noexcept {
-  bigint res;
-  res += *this;
-  if (!is_zero()) {
-    res.sign = !res.sign;
-  }
+template <bigint_detail::small_integer T>
+bigint bigint::operator*(const T b) const noexcept {
+  bigint res = copy_with_capacity(val.size() + 2);
+  res *= b;
   return res;
 }
 
-// pre/post-fix operators
-inline const bigint &bigint::operator++() noexcept {
-  *this += 1;
+template <bigint_detail::small_integer T>
+const bigint &bigint::operator*=(const T b) noexcept {
+  const auto [m, m_sign] = bigint_detail::magnitude(b);
+  mul_small(m, m_sign);
   return *this;
 }
 
-inline bigint bigint::operator++(int) noexcept {
-  bigint res;
-  res += *this;
-  *this += 1;
+template <bigint_detail::small_integer T>
+bigint bigint::operator/(const T b) const noexcept(false) {
+  bigint res = *this;
+  res /= b;
   return res;
 }
 
-inline const bigint &bigint::operator--() noexcept {
-  *this -= bigint(1);
+template <bigint_detail::small_integer T>
+const bigint &bigint::operator/=(const T b) noexcept(false) {
+  const auto [m, m_sign] = bigint_detail::magnitude(b);
+  div_small(m, m_sign, false);
   return *this;
 }
 
-inline bigint bigint::operator--(int) noexcept {
-  bigint res;
-  res += *this;
-  *this -= bigint(1);
+template <bigint_detail::small_integer T>
+bigint bigint::operator%(const T b) const noexcept(false) {
+  bigint res = *this;
+  res %= b;
   return res;
 }
 
-#ifdef DOCTEST_LIBRARY_INCLUDED
-TEST_CASE("[bigint] subtractions") {
-  // Subtraction resulting in zero
-  CHECK_EQ(bigint(0) - bigint(0), bigint(0));
-  CHECK_EQ(bigint(12345) - bigint(12345), bigint(0));
-  CHECK_EQ(bigint(-12345) - bigint(-12345), bigint(0));
-
-  // Subtracting zero
-  CHECK_EQ(bigint(12345) - bigint(0), bigint(12345));
-  CHECK_EQ(bigint(-12345) - bigint(0), bigint(-12345));
-  CHECK_EQ(bigint(0) - bigint(12345), bigint(-12345));
-  CHECK_EQ(bigint(0) - bigint(-12345), bigint(12345));
-
-  // Positive number subtraction
-  CHECK_EQ(bigint(12345) - bigint(54321), bigint(-41976));
-  CHECK_EQ(bigint(54321) - bigint(12345), bigint(41976));
+template <bigint_detail::small_integer T>
+const bigint &bigint::operator%=(const T b) noexcept(false) {
+  const auto [m, m_sign] = bigint_detail::magnitude(b);
+  div_small(m, m_sign, true);
+  return *this;
+}
 
-  // Negative number subtraction
-  CHECK_EQ(bigint(-12345) - bigint(54321), bigint(-66666));
-  CHECK_EQ(bigint(12345) - bigint(-54321), bigint(66666));
-  CHECK_EQ(bigint(-12345) - bigint(-54321), bigint(41976));
+template <bigint_detail::small_integer T>
+bool bigint::operator==(const T b) const noexcept {
+  return *this <=> b == 0;
 }
 
-TEST_CASE("[bigint] subtraction chaining") {
-  CHECK_EQ(bigint(10) - bigint(5) - bigint(2), bigint(3));
-  CHECK_EQ(bigint(100) - bigint(50) - bigint(30), bigint(20));
-  CHECK_EQ(bigint(-10) - bigint(-5) - bigint(-2), bigint(-3));
+template <bigint_detail::small_integer T>
+std::strong_ordering bigint::operator<=>(const T b) const noexcept {
+  const auto [m, m_sign] = bigint_detail::magnitude(b);
+  return cmp_small(m, m_sign);
 }
 
-TEST_CASE("[bigint] subtraction edge cases") {
-  CHECK_EQ(bigint("123456789123456789") - bigint("987654321987654321"),
-           bigint("-864197532864197532"));
-  CHECK_EQ(bigint("987654321987654321") - bigint("123456789123456789"),
-           bigint("864197532864197532"));
-  CHECK_EQ(bigint("123456789123456789") - bigint("-987654321987654321"),
-           bigint("1111111111111111110"));
-  CHECK_EQ(bigint("-123456789123456789") - bigint("987654321987654321"),
-           bigint("-1111111111111111110"));
-  CHECK_EQ(bigint(1) - bigint(1), bigint(0));
-  CHECK_EQ(bigint(-1) - bigint(-1), bigint(0));
-  CHECK_EQ(bigint(-1) - bigint(1), bigint(-2));
-  CHECK_EQ(bigint(1) - bigint(-1), bigint(2));
+#ifdef DOCTEST_LIBRARY_INCLUDED
+TEST_CASE("[bigint] built-in integer operands") {
+  // the old WORD overload added to the magnitude of negative values
+  bigint x(-5);
+  x += 3u;
+  CHECK_EQ(x, bigint(-2));
+  x += 7u;
+  CHECK_EQ(x, bigint(5));
+  bigint y(0);
+  CHECK_EQ(--y, bigint(-1));
+  CHECK_EQ(++y, bigint(0));
+
+  constexpr std::int64_t min = std::numeric_limits<std::int64_t>::min();
+  constexpr std::uint64_t umax = std::numeric_limits<std::uint64_t>::max();
+  const bigint big("-123456789012345678901234567890");
+  const std::vector<bigint> xs{bigint(0), bigint(1), bigint(-1),
+                               bigint(min), -bigint(min), big, -big,
+                               pow(bigint(2), 64), -pow(bigint(2), 64) + bigint(1)};
+  const std::vector<std::int64_t> ss{0, 1, -1, 7, -9, 1LL << 32, -(1LL << 40) - 3,
+                                     std::numeric_limits<std::int64_t>::max(), min};
+  const std::vector<std::uint64_t> us{0, 1, 0xffffffffu, 1ULL << 32, umax};
+  const auto check = [](const bigint &a, const bigint &b, const auto v) {
+    CHECK_EQ(a + v, a + b);
+    CHECK_EQ(v + a, a + b);
+    CHECK_EQ(a - v, a - b);
+    CHECK_EQ(v - a, b - a);
+    CHECK_EQ(a * v, a * b);
+    CHECK_EQ(v * a, a * b);
+    if (v != 0) {
+      CHECK_EQ(a / v, a / b);
+      CHECK_EQ(a % v, a % b);
+    }
+    CHECK_EQ(a == v, a == b);
+    CHECK_EQ(v == a, a == b);
+    CHECK_EQ(a < v, a < b);
+    CHECK_EQ(v < a, b < a);
+    CHECK_EQ(a >= v, a >= b);
+    CHECK((a <=> v) == (a <=> b));
+  };
+  for (const bigint &a : xs) {
+    for (const std::int64_t v : ss)
+      check(a, bigint(v), v);
+    for (const std::uint64_t v : us)
+      check(a, bigint(static_cast<std::int64_t>(v >> 1)) * bigint(2) +
+                   bigint(static_cast<std::int64_t>(v & 1)), v);
+    check(a, bigint(-3), -3);
+    check(a, bigint(200), static_cast<unsigned char>(200));
+  }
+  CHECK_THROWS_AS(bigint _ = big / std::int64_t{0}, std::domain_error);
+  CHECK_THROWS_AS(bigint _ = big % std::uint64_t{0}, std::domain_error);
+  CHECK(bigint(0) < 1);
+  CHECK(-1 < bigint(0));
+  CHECK(big != 0);
 }
 #endif
 
@@ -813,80 +8824,709 @@ inline bool bigint::operator>=(const bigint &b) const noexcept {
   return !(*this < b);
 }
 
+inline std::strong_ordering bigint::operator<=>(const bigint &b) const noexcept {
+  if (sign != b.sign)
+    return sign ? std::strong_ordering::less : std::strong_ordering::greater;
+  std::strong_ordering mag = val.size() <=> b.val.size();
+  if (mag == 0)
+    mag = bigint_detail::cmp_n(val.data(), b.val.data(), val.size()) <=> 0;
+  return sign ? 0 <=> mag : mag;
+}
+
+#ifdef DOCTEST_LIBRARY_INCLUDED
+TEST_CASE("[bigint] three-way comparison") {
+  const bigint big("1234567891011121314151617181920");
+  CHECK((big <=> big) == std::strong_ordering::equal);
+  CHECK((big <=> -big) == std::strong_ordering::greater);
+  CHECK((-big <=> bigint(-1)) == std::strong_ordering::less);
+  CHECK((bigint(-5) <=> bigint(-7)) == std::strong_ordering::greater);
+  CHECK((bigint(0) <=> bigint(-0)) == std::strong_ordering::equal);
+  CHECK((big <=> big + bigint(1)) == std::strong_ordering::less);
+  CHECK((-big <=> -(big + bigint(1))) == std::strong_ordering::greater);
+}
+#endif
+
 inline std::ostream &operator<<(std::ostream &os, const bigint &a) noexcept {
-  if (a.sign)
-    os << '-';
-  for (const auto &ai : a.val | std::views::reverse) {
-    os << ai;
-  }
+  const auto basefield = os.flags() & std::ios_base::basefield;
+  const int base = basefield == std::ios_base::hex   ? 16
+                   : basefield == std::ios_base::oct ? 8
+                                                     : 10;
+  const std::string s = a.to_string(base);
+  bigint_detail::count(bigint_detail::stat::print_calls);
+  bigint_detail::count(bigint_detail::stat::print_chars, s.size());
+  os << s;
   return os;
 }
 
+inline std::string bigint::to_string(const int base) const noexcept(false) {
+  if (base < 2 || base > 36)
+    throw std::invalid_argument("base must be between 2 and 36");
+  std::string s(max_digits(base), '\0');
+  const auto res = to_chars(s.data(), s.data() + s.size(), base);
+  s.resize(static_cast<std::size_t>(res.ptr - s.data()));
+  return s;
+}
+
+inline std::to_chars_result bigint::to_chars(char *first, char *last,
+                                             const int base) const noexcept {
+  if (base < 2 || base > 36)
+    return {first, std::errc::invalid_argument};
+  const std::size_t bound = max_digits(base);
+  if (static_cast<std::size_t>(last - first) < bound) {
+    // the bound may overestimate by a digit, so convert aside and copy
+    const std::string s = to_string(base);
+    if (static_cast<std::size_t>(last - first) < s.size())
+      return {last, std::errc::value_too_large};
+    return {std::copy(s.begin(), s.end(), first), std::errc{}};
+  }
+  char *out = first;
+  if (sign)
+    *out++ = '-';
+  if (std::has_single_bit(static_cast<unsigned>(base)))
+    write_pow2(out, *this, static_cast<unsigned>(std::countr_zero(static_cast<unsigned>(base))));
+  else
+    write_radix(out, *this, base, 0);
+  return {out, std::errc{}};
+}
+
+// an upper bound on the length of to_string(base), including the sign
+inline std::size_t bigint::max_digits(const int base) const noexcept {
+  const auto bits = static_cast<double>(
+      WORD_BITS * (val.size() - 1) +
+      static_cast<std::size_t>(std::bit_width(val.back())));
+  return static_cast<std::size_t>(bits / std::log2(base)) + 2 + sign;
+}
+
+// chunk_of(base).power^(2^i), cached per thread. The cache is a deque so
+// references stay valid while it grows.
+inline const bigint &bigint::radix_power(const int base,
+                                         const std::size_t i) noexcept {
+  thread_local std::deque<bigint> cache[37];
+  std::deque<bigint> &powers = cache[base];
+  // the cache outlives any scoped resource
+  const bigint_memory_scope scope(nullptr);
+  if (powers.empty()) {
+    bigint p;
+    p.val[0] = bigint_detail::chunk_of(base).power;
+    powers.push_back(std::move(p));
+  }
+  while (powers.size() <= i) {
+    const bigint &last = powers.back();
+    powers.push_back(last * last);
+  }
+  return powers[i];
+}
+
+// the value of the base chunk_of(base).power digits c[0..m), most
+// significant first
+inline bigint bigint::from_radix_chunks(const WORD *c, const std::size_t m,
+                                        const int base) noexcept {
+  bigint res;
+  if (m <= RADIX_DC_LIMBS) {
+    const WORD power = bigint_detail::chunk_of(base).power;
+    res.val.reserve(m);
+    for (std::size_t i = 0; i < m; i++) {
+      res *= power;
+      res += c[i];
+    }
+    return res;
+  }
+  // the low part takes the largest power of two number of chunks below m
+  const auto i = static_cast<std::size_t>(std::bit_width(m - 1) - 1);
+  const std::size_t low = std::size_t{1} << i;
+  res = from_radix_chunks(c, m - low, base);
+  res *= radix_power(base, i);
+  res += from_radix_chunks(c + m - low, low, base);
+  return res;
+}
+
+// writes |x| in base 2^k at out
+inline void bigint::write_pow2(char *&out, const bigint &x,
+                               const unsigned k) noexcept {
+  if (x.is_zero()) {
+    *out++ = '0';
+    return;
+  }
+  const std::size_t n = x.val.size();
+  const std::size_t digits = (x.bit_length() + k - 1) / k;
+  if (k == 4) {
+    // the top limb unpadded, then eight digits for each limb below it
+    const std::size_t top = digits - 8 * (n - 1);
+    bigint_detail::limbs_to_pow2(out, &x.val[n - 1], 1, top, 4);
+    bigint_detail::limbs_to_hex(out + top, x.val.data(), n - 1);
+  } else {
+    bigint_detail::limbs_to_pow2(out, x.val.data(), n, digits, k);
+  }
+  out += digits;
+}
+
+// writes |x| in base at out, zero padded to width digits when width != 0
+inline void bigint::write_radix(char *&out, const bigint &x, const int base,
+                                const std::size_t width) noexcept {
+  const auto chunk = bigint_detail::chunk_of(base);
+  const auto b = static_cast<WORD>(base);
+  if (x.val.size() <= RADIX_DC_LIMBS) {
+    // peel off chunks, writing digits backwards from the end of the field
+    std::size_t n = x.val.size();
+    WORD q[RADIX_DC_LIMBS];
+    std::copy(x.val.begin(), x.val.end(), q);
+    char buf[RADIX_DC_LIMBS * 32];
+    char *const end = buf + sizeof(buf);
+    char *p = end;
+    while (n > 1 || q[0]) {
+      WORD rem = bigint_detail::divrem_1(q, q, n, chunk.power);
+      while (n > 1 && !q[n - 1])
+        n--;
+      const bool last = n == 1 && !q[0];
+      for (std::size_t j = 0; j < chunk.digits && (!last || rem); j++) {
+        *--p = bigint_detail::DIGITS[rem % b];
+        rem /= b;
+      }
+    }
+    auto len = static_cast<std::size_t>(end - p);
+    if (!width && !len) {
+      *--p = '0';
+      len = 1;
+    }
+    if (width > len) {
+      out = std::fill_n(out, width - len, '0');
+    }
+    out = std::copy(p, end, out);
+    return;
+  }
+
+  // split at the largest power with at most half the limbs of x
+  std::size_t i = 0;
+  while (2 * radix_power(base, i + 1).val.size() <= x.val.size() + 1)
+    i++;
+  bigint q, r;
+  val_divmod(x, radix_power(base, i), q, r);
+  const std::size_t low_digits = chunk.digits << i;
+  if (width || !q.is_zero())
+    write_radix(out, q, base, width ? width - low_digits : 0);
+  write_radix(out, r, base, q.is_zero() && !width ? 0 : low_digits);
+}
+
+#ifdef DOCTEST_LIBRARY_INCLUDED
+TEST_CASE("[bigint] output stream") {
+  auto str = [](const bigint &a) {
+    std::ostringstream os;
+    os << a;
+    return os.str();
+  };
+  CHECK_EQ(str(bigint()), "0");
+  CHECK_EQ(str(bigint(-12345)), "-12345");
+  CHECK_EQ(str(bigint(1000000000)), "1000000000");
+  CHECK_EQ(str(bigint("-0")), "0");
+  CHECK_EQ(str(bigint("1234567891011121314151617181920")),
+           "1234567891011121314151617181920");
+  CHECK_EQ(str(bigint("-1000000000000000000000000000001")),
+           "-1000000000000000000000000000001");
+
+  std::ostringstream os;
+  os << std::hex << bigint("-18446744073709551616") << ' ' << std::oct
+     << bigint(8);
+  CHECK_EQ(os.str(), "-10000000000000000 10");
+}
+
+TEST_CASE("[bigint] to_string") {
+  CHECK_EQ(bigint().to_string(), "0");
+  CHECK_EQ(bigint(-255).to_string(2), "-11111111");
+  CHECK_EQ(bigint(255).to_string(16), "ff");
+  CHECK_EQ(bigint(35).to_string(36), "z");
+  CHECK_EQ(bigint("340282366920938463463374607431768211455").to_string(16),
+           std::string(32, 'f'));
+  CHECK_EQ(bigint("-1000000000000000000000000000000").to_string(3),
+           "-212120220222112010021212002200000010201112102000211222011201001");
+  CHECK_THROWS_AS(std::string _ = bigint(1).to_string(1), std::invalid_argument);
+  CHECK_THROWS_AS(std::string _ = bigint(1).to_string(37), std::invalid_argument);
+
+  // large enough to take the divide-and-conquer path with padded halves
+  const std::string digits = "1" + std::string(600, '0') + "7" +
+                             std::string(300, '0') + "123456789";
+  CHECK_EQ(bigint(digits).to_string(), digits);
+  CHECK_EQ(bigint("-" + digits).to_string(), "-" + digits);
+  CHECK_EQ(bigint(std::string(1000, '9')).to_string(), std::string(1000, '9'));
+}
+
+TEST_CASE("[bigint] to_chars") {
+  char buf[8];
+  const bigint a(-1234567);
+  auto res = a.to_chars(buf, buf + sizeof(buf));
+  CHECK(res.ec == std::errc{});
+  CHECK_EQ(std::string(buf, res.ptr), "-1234567");
+  res = a.to_chars(buf, buf + 7);
+  CHECK(res.ec == std::errc::value_too_large);
+  CHECK_EQ(res.ptr, buf + 7);
+  res = a.to_chars(buf, buf + sizeof(buf), 40);
+  CHECK(res.ec == std::errc::invalid_argument);
+  res = bigint(9).to_chars(buf, buf + 1);
+  CHECK(res.ec == std::errc{});
+  CHECK_EQ(std::string(buf, res.ptr), "9");
+}
+
+TEST_CASE("[bigint] power-of-two bases") {
+  const bigint x("123456789012345678901234567890123456789012345678901234567890");
+  CHECK_EQ(x.to_string(16),
+           "13aaf504e4bc1e62173f87a4378c37b49c8ccff196ce3f0ad2");
+  CHECK_EQ(bigint("13AAF504E4BC1E62173F87A4378C37B49C8CCFF196CE3F0AD2", 16), x);
+  CHECK_EQ(bigint("-00000000000000000000000000000000000000ff", 16), bigint(-255));
+  CHECK_EQ(bigint("-0", 16).to_string(16), "0");
+  CHECK_EQ(bigint(-255).to_string(2), "-11111111");
+  CHECK_EQ(bigint(511).to_string(8), "777");
+  CHECK_EQ(bigint("-777", 8), bigint(-511));
+  CHECK_EQ(bigint("vv", 32), bigint(1023));
+  CHECK_EQ(bigint(0).to_string(16), "0");
+  CHECK_EQ(bigint(4294967296).to_string(16), "100000000");
+  CHECK_THROWS_AS(bigint _("12g4", 16), std::invalid_argument);
+  CHECK_THROWS_AS(bigint _("129", 8), std::invalid_argument);
+  bigint y;
+  const std::string_view sv = "ff@";
+  const auto res = bigint::from_chars(sv.data(), sv.data() + sv.size(), y, 16);
+  CHECK_EQ(res.ptr, sv.data() + 2);
+  CHECK_EQ(y, bigint(255));
+
+  // the SIMD and portable kernels agree with a digit by digit reference
+  const auto saved = bigint_detail::simd_dispatch;
+  for (int level = 0; level <= static_cast<int>(saved); level++) {
+    bigint_detail::simd_dispatch = static_cast<bigint_detail::simd_level>(level);
+    for (const std::size_t e : {1u, 30u, 200u, 203u, 1000u}) {
+      const bigint v = pow(bigint(3), e) * bigint(-7);
+      for (const int base : {2, 4, 8, 16, 32}) {
+        std::string ref;
+        bigint m = v < bigint(0) ? -v : v;
+        while (m > bigint(0)) {
+          const int d = std::stoi((m % bigint(base)).to_string());
+          ref.insert(ref.begin(), bigint_detail::DIGITS[d]);
+          m = m / bigint(base);
+        }
+        CHECK_EQ(v.to_string(base), "-" + ref);
+        CHECK_EQ(bigint("-" + ref, base), v);
+        // upper case and leading zeros, with a terminating character
+        std::string upper = "000" + ref + "!";
+        for (char &ch : upper)
+          ch = static_cast<char>(std::toupper(static_cast<unsigned char>(ch)));
+        const auto r = bigint::from_chars(upper.data(), upper.data() + upper.size(), y, base);
+        CHECK_EQ(r.ptr, upper.data() + upper.size() - 1);
+        CHECK_EQ(y, -v);
+      }
+    }
+  }
+  bigint_detail::simd_dispatch = saved;
+}
+#endif
+
 inline void bigint::val_plus(const bigint &b, std::size_t offset) noexcept {
   if (b.val.size() + offset > val.size())
     val.resize(b.val.size() + offset, 0);
-  WORD carry = 0;
-  for (std::size_t i = offset; i < val.size(); i++) {
-    const WORD ai = val[i];
-    const WORD bi = i - offset < b.val.size() ? b.val[i - offset] : 0;
-    val[i] = (ai + bi + carry) % BASE;
-    carry = (ai + bi + carry) / BASE;
-  }
+  bigint_detail::count(bigint_detail::stat::plus_calls);
+  bigint_detail::count(bigint_detail::stat::plus_limbs, val.size());
+  WORD *const r = val.data() + offset;
+  const std::size_t m = b.val.size();
+  WORD carry = bigint_detail::add_n(r, r, b.val.data(), m);
+  carry = bigint_detail::add_1(r + m, r + m, val.size() - offset - m, carry);
   if (carry) {
     val.push_back(carry);
   }
 }
 
 inline void bigint::val_monus(const bigint &b) noexcept {
-  WORD carry = 0;
-  for (std::size_t i = 0; i < val.size(); i++) {
-    const WORD ai = val[i];
-    const WORD bi = i < b.val.size() ? b.val[i] : 0;
-    val[i] = (ai - bi - carry + BASE) % BASE;
-    carry = (ai - bi - carry < 0) ? 1 : 0;
+  // requires |*this| >= |b|
+  bigint_detail::count(bigint_detail::stat::monus_calls);
+  bigint_detail::count(bigint_detail::stat::monus_limbs, val.size());
+  const std::size_t m = b.val.size();
+  const WORD borrow = bigint_detail::sub_n(val.data(), val.data(), b.val.data(), m);
+  bigint_detail::sub_1(val.data() + m, val.data() + m, val.size() - m, borrow);
+  trim();
+}
+
+inline void bigint::val_rmonus(const bigint &b) noexcept {
+  // *this = |b| - |*this|, requires |b| > |*this|
+  const std::size_t n = val.size();
+  const std::size_t m = b.val.size();
+  val.resize(m);
+  const WORD borrow =
+      bigint_detail::sub_n(val.data(), b.val.data(), val.data(), n);
+  bigint_detail::sub_1(val.data() + n, b.val.data() + n, m - n, borrow);
+  trim();
+}
+
+inline void bigint::val_mult(const bigint &b) noexcept {
+  const std::size_t n = val.size();
+  const std::size_t m = b.val.size();
+  bigint_detail::count(bigint_detail::stat::mult_calls);
+  bigint_detail::count(bigint_detail::stat::mult_limbs, n + m);
+  // the product goes through scratch space and back into val, whose storage
+  // is reused when it is large enough
+  bigint_detail::workspace::frame f(bigint_detail::workspace::local());
+  WORD *const prod = f.alloc(n + m);
+  if (n >= m) {
+    mul_limbs(prod, val.data(), n, b.val.data(), m);
+  } else {
+    mul_limbs(prod, b.val.data(), m, val.data(), n);
   }
-  while (val.size() > 1 && !val.back()) {
-    val.pop_back();
+  const std::size_t len = prod[n + m - 1] ? n + m : n + m - 1;
+  val.assign(prod, prod + len);
+  trim();
+}
+
+inline void bigint::val_divexact(const WORD d) noexcept {
+  bigint_detail::divrem_1(val.data(), val.data(), val.size(), d);
+  trim();
+}
+
+inline bigint bigint::from_limbs(const WORD *a, std::size_t n) noexcept {
+  while (n > 0 && !a[n - 1])
+    n--;
+  bigint res;
+  if (n) {
+    res.val.assign(a, a + n);
   }
+  return res;
 }
 
-inline void bigint::val_mult(const bigint &b) noexcept {
-  bigint s(0);
-  for (std::size_t i = 0; i < b.val.size(); i++) {
-    s.val_plus(*this * b.val[i], i);
+// r[0..an+bn) = a[0..an) * b[0..bn), requires an >= bn >= 1 and r must not
+// overlap a or b. a == b with an == bn is treated as a squaring.
+inline void bigint::mul_limbs(WORD *r, const WORD *a, const std::size_t an,
+                              const WORD *b, const std::size_t bn) noexcept {
+  // below 4 limbs the Karatsuba half sums are no smaller than the operands
+  using bigint_detail::count, bigint_detail::stat;
+  if (bn < std::max<std::size_t>(thresholds.karatsuba, 4)) {
+    count(stat::mul_basecase);
+    bigint_detail::mul_basecase(r, a, an, b, bn);
+    return;
   }
-  val = s.val;
-  while (val.size() > 1 && !val.back()) {
-    val.pop_back();
+  const std::size_t threads = mul_threads(bn);
+  if (bn >= thresholds.ntt && an + bn <= bigint_detail::NTT_MAX_LEN) {
+    count(stat::mul_ntt);
+    bigint_detail::mul_ntt(r, a, an, b, bn, threads);
+    return;
+  }
+  if ((an + 1) / 2 >= bn) {
+    count(stat::mul_unbalanced);
+    // unbalanced operands, multiply b by bn-limb slices of a, all at once
+    // when they run in parallel
+    std::fill(r, r + an + bn, WORD{0});
+    const std::size_t slices = (an + bn - 1) / bn;
+    const std::size_t batch = threads > 1 ? slices : 1;
+    bigint_detail::workspace::frame f(bigint_detail::workspace::local());
+    WORD *const t = f.alloc(batch * 2 * bn);
+    for (std::size_t s0 = 0; s0 < slices; s0 += batch) {
+      const std::size_t count = std::min(batch, slices - s0);
+      bigint_detail::thread_pool::instance().run(
+          count, threads, [&](std::size_t s) {
+            const std::size_t i = (s0 + s) * bn;
+            mul_limbs(t + s * 2 * bn, b, bn, a + i, std::min(bn, an - i));
+          });
+      for (std::size_t s = 0; s < count; s++) {
+        const std::size_t i = (s0 + s) * bn;
+        const std::size_t len = std::min(bn, an - i);
+        const WORD carry =
+            bigint_detail::add_n(r + i, r + i, t + s * 2 * bn, len + bn);
+        bigint_detail::add_1(r + i + len + bn, r + i + len + bn,
+                             an - i - len, carry);
+      }
+    }
+    return;
+  }
+  if (bn < thresholds.toom3 || bn <= 2 * ((an + 2) / 3)) {
+    count(stat::mul_karatsuba);
+    mul_karatsuba(r, a, an, b, bn);
+  } else {
+    count(stat::mul_toom3);
+    mul_toom3(r, a, an, b, bn);
   }
 }
 
-inline bool bigint::val_less(const bigint &b) const noexcept {
-  if (val.size() < b.val.size())
-    return true;
-  if (val.size() > b.val.size())
-    return false;
-  for (const auto [ai, bi] :
-       std::views::zip(val, b.val) | std::views::reverse) {
-    if (ai != bi)
-      return ai < bi;
+// the threads for a product whose smaller operand has bn limbs
+inline std::size_t bigint::mul_threads(const std::size_t bn) noexcept {
+  return bn >= parallel.min_limbs ? parallel.threads : 1;
+}
+
+// Karatsuba: with a = a1 B^h + a0 and b = b1 B^h + b0,
+// a b = z2 B^2h + ((a0 + a1)(b0 + b1) - z2 - z0) B^h + z0
+inline void bigint::mul_karatsuba(WORD *r, const WORD *a, const std::size_t an,
+                                  const WORD *b, const std::size_t bn) noexcept {
+  const std::size_t h = (an + 1) / 2;
+  const std::size_t n = an + bn;
+  bigint_detail::workspace::frame f(bigint_detail::workspace::local());
+  WORD *const sa = f.alloc(h + 1);
+  WORD *const sb = a == b && an == bn ? sa : f.alloc(h + 1);
+  WORD *const z1 = f.alloc(2 * h + 2);
+  const WORD ca = bigint_detail::add_n(sa, a, a + h, an - h);
+  sa[h] = bigint_detail::add_1(sa + an - h, a + an - h, 2 * h - an, ca);
+  if (sb != sa) {
+    const WORD cb = bigint_detail::add_n(sb, b, b + h, bn - h);
+    sb[h] = bigint_detail::add_1(sb + bn - h, b + bn - h, 2 * h - bn, cb);
   }
-  return false;
+
+  bigint_detail::thread_pool::instance().run(
+      3, mul_threads(bn), [&](std::size_t i) {
+        if (i == 0)
+          mul_limbs(r, a, h, b, h);
+        else if (i == 1)
+          mul_limbs(r + 2 * h, a + h, an - h, b + h, bn - h);
+        else
+          mul_limbs(z1, sa, h + 1, sb, h + 1);
+      });
+
+  WORD borrow = bigint_detail::sub_n(z1, z1, r, 2 * h);
+  bigint_detail::sub_1(z1 + 2 * h, z1 + 2 * h, 2, borrow);
+  borrow = bigint_detail::sub_n(z1, z1, r + 2 * h, n - 2 * h);
+  bigint_detail::sub_1(z1 + n - 2 * h, z1 + n - 2 * h, 4 * h + 2 - n, borrow);
+
+  // the middle term is below 2 B^2h, so at most 2h + 1 of its limbs are set
+  const std::size_t len = std::min(2 * h + 1, n - h);
+  const WORD carry = bigint_detail::add_n(r + h, r + h, z1, len);
+  bigint_detail::add_1(r + h + len, r + h + len, n - h - len, carry);
 }
 
-inline bool bigint::val_more(const bigint &b) const noexcept {
-  if (val.size() < b.val.size())
-    return false;
-  if (val.size() > b.val.size())
-    return true;
-  for (const auto [ai, bi] :
-       std::views::zip(val, b.val) | std::views::reverse) {
-    if (ai != bi)
-      return ai > bi;
+// Toom-3 evaluating at 0, 1, -1, -2 and infinity, interpolated with Bodrato's
+// sequence. The interpolation runs on two's complement values of 2k + 2 limbs,
+// which hold every intermediate with room to spare.
+inline void bigint::mul_toom3(WORD *r, const WORD *a, const std::size_t an,
+                              const WORD *b, const std::size_t bn) noexcept {
+  const std::size_t k = (an + 2) / 3;
+  const std::size_t n = an + bn;
+  const std::size_t w = 2 * k + 2;
+  const bool square = a == b && an == bn;
+  bigint_detail::workspace::frame f(bigint_detail::workspace::local());
+  WORD *const t = f.alloc(k + 1);
+  WORD *const ea = f.alloc(3 * (k + 1));
+  WORD *const eb = square ? ea : f.alloc(3 * (k + 1));
+  const auto [a_neg1, a_neg2] = bigint_detail::toom3_eval(ea, a, an, k, t);
+  std::pair<bool, bool> b_neg{a_neg1, a_neg2};
+  if (!square)
+    b_neg = bigint_detail::toom3_eval(eb, b, bn, k, t);
+
+  WORD *const r1 = f.alloc(w);
+  WORD *const rm1 = f.alloc(w);
+  WORD *const rm2 = f.alloc(w);
+  // r0 and rinf go straight to their places in r
+  const WORD *const r0 = r;
+  const WORD *const rinf = r + 4 * k;
+  const std::size_t inf_len = n - 4 * k;
+  bigint_detail::thread_pool::instance().run(
+      5, mul_threads(bn), [&](std::size_t i) {
+        if (i == 0) {
+          mul_limbs(r1, ea, k + 1, eb, k + 1);
+        } else if (i == 1) {
+          mul_limbs(rm1, ea + k + 1, k + 1, eb + k + 1, k + 1);
+          if (a_neg1 != b_neg.first)
+            bigint_detail::neg_n(rm1, w);
+        } else if (i == 2) {
+          mul_limbs(rm2, ea + 2 * (k + 1), k + 1, eb + 2 * (k + 1), k + 1);
+          if (a_neg2 != b_neg.second)
+            bigint_detail::neg_n(rm2, w);
+        } else if (i == 3) {
+          mul_limbs(r, a, k, b, k);
+        } else {
+          mul_limbs(r + 4 * k, a + 2 * k, an - 2 * k, b + 2 * k, bn - 2 * k);
+        }
+      });
+
+  // x[0..w) += rinf and x[0..w) -= rinf
+  const auto add_inf = [&](WORD *x) {
+    const WORD carry = bigint_detail::add_n(x, x, rinf, inf_len);
+    bigint_detail::add_1(x + inf_len, x + inf_len, w - inf_len, carry);
+  };
+  const auto sub_inf = [&](WORD *x) {
+    const WORD borrow = bigint_detail::sub_n(x, x, rinf, inf_len);
+    bigint_detail::sub_1(x + inf_len, x + inf_len, w - inf_len, borrow);
+  };
+
+  // s3 = (rm2 - r1) / 3, s1 = (r1 - rm1) / 2 and s2 = rm1 - r0, in place
+  WORD *const s1 = r1;
+  WORD *const s2 = rm1;
+  WORD *const s3 = rm2;
+  bigint_detail::sub_n(s3, rm2, r1, w);
+  bigint_detail::divexact_1(s3, s3, w, 3);
+  bigint_detail::sub_n(s1, r1, rm1, w);
+  bigint_detail::sar_1(s1, w);
+  const WORD borrow = bigint_detail::sub_n(s2, rm1, r0, 2 * k);
+  bigint_detail::sub_1(s2 + 2 * k, s2 + 2 * k, 2, borrow);
+  // s3 = (s2 - s3) / 2 + 2 rinf, s2 = s2 + s1 - rinf and s1 = s1 - s3
+  bigint_detail::sub_n(s3, s2, s3, w);
+  bigint_detail::sar_1(s3, w);
+  add_inf(s3);
+  add_inf(s3);
+  bigint_detail::add_n(s2, s2, s1, w);
+  sub_inf(s2);
+  bigint_detail::sub_n(s1, s1, s3, w);
+
+  // the coefficients are now non-negative and fit below the top of r
+  std::fill(r + 2 * k, r + 4 * k, WORD{0});
+  for (std::size_t i = 1; i <= 3; i++) {
+    const WORD *const s = i == 1 ? s1 : i == 2 ? s2 : s3;
+    const std::size_t offset = i * k;
+    const std::size_t len = std::min(w, n - offset);
+    const WORD carry = bigint_detail::add_n(r + offset, r + offset, s, len);
+    bigint_detail::add_1(r + offset + len, r + offset + len, n - offset - len,
+                         carry);
   }
-  return false;
+}
+
+inline void bigint::val_shl_limbs(const std::size_t k) noexcept {
+  if (!is_zero()) {
+    val.insert(val.begin(), k, WORD{0});
+  }
+}
+
+// limbs [lo, hi) of |x|, clamped to the size of x
+inline bigint bigint::limb_slice(const bigint &x, const std::size_t lo,
+                                 const std::size_t hi) noexcept {
+  const std::size_t n = x.val.size();
+  if (lo >= n)
+    return bigint();
+  return from_limbs(x.val.data() + lo, std::min(hi, n) - lo);
+}
+
+// val_divmod without recursion, through divrem_1 or Knuth's algorithm D. a
+// and r may alias.
+inline void bigint::val_divmod_basecase(const bigint &a, const bigint &b,
+                                        bigint &q, bigint &r) noexcept {
+  if (a.val_less(b)) {
+    q = bigint();
+    r = a;
+    r.sign = false;
+    return;
+  }
+  const std::size_t an = a.val.size();
+  const std::size_t bn = b.val.size();
+  bigint quot;
+  bigint rem;
+  quot.val.resize(an - bn + 1);
+  if (bn == 1) {
+    rem.val[0] =
+        bigint_detail::divrem_1(quot.val.data(), a.val.data(), an, b.val[0]);
+  } else {
+    rem.val.resize(bn);
+    bigint_detail::divrem_knuth(quot.val.data(), rem.val.data(), a.val.data(),
+                                an, b.val.data(), bn);
+    rem.trim();
+  }
+  quot.trim();
+  q = std::move(quot);
+  r = std::move(rem);
+}
+
+// q = |a| / |b| and r = |a| % |b|, both non-negative
+inline void bigint::val_divmod(const bigint &a, const bigint &b, bigint &q,
+                               bigint &r) noexcept {
+  const std::size_t an = a.val.size();
+  const std::size_t bn = b.val.size();
+  if (bn < div_threshold || a.val_less(b)) {
+    val_divmod_basecase(a, b, q, r);
+    return;
+  }
+
+  // Burnikel-Ziegler on normalized operands, one bn-limb digit of the
+  // dividend at a time
+  const auto s = static_cast<unsigned>(std::countl_zero(b.val.back()));
+  bigint na = a;
+  bigint nb = b;
+  na.sign = nb.sign = false;
+  if (s) {
+    bigint_detail::lshift(nb.val.data(), nb.val.data(), bn, s);
+    const WORD out = bigint_detail::lshift(na.val.data(), na.val.data(), an, s);
+    if (out)
+      na.val.push_back(out);
+  }
+  const std::size_t digits = (na.val.size() + bn - 1) / bn;
+  q.val.assign(digits * bn, 0);
+  q.sign = false;
+  r = bigint();
+  for (std::size_t i = digits; i-- > 0;) {
+    r.val_shl_limbs(bn);
+    r.val_plus(limb_slice(na, i * bn, (i + 1) * bn));
+    bigint qd;
+    bz_div2n1n(r, nb, bn, qd, r);
+    std::copy(qd.val.begin(), qd.val.end(),
+              q.val.begin() + static_cast<std::ptrdiff_t>(i * bn));
+  }
+  q.trim();
+  if (s) {
+    bigint_detail::rshift(r.val.data(), r.val.data(), r.val.size(), s);
+    r.trim();
+  }
+}
+
+// Divides a < B^n b by b, where b has n limbs with the top bit set. a and r
+// may alias.
+inline void bigint::bz_div2n1n(const bigint &a, const bigint &b,
+                               const std::size_t n, bigint &q,
+                               bigint &r) noexcept {
+  if (n < div_threshold || a.val.size() <= n + 1) {
+    val_divmod_basecase(a, b, q, r);
+    return;
+  }
+  if (n & 1) {
+    // pad to an even number of limbs, which keeps b normalized
+    bigint pa = a;
+    bigint pb = b;
+    pa.val_shl_limbs(1);
+    pb.val_shl_limbs(1);
+    bz_div2n1n(pa, pb, n + 1, q, r);
+    if (!r.is_zero())
+      r.val.erase(r.val.begin());
+    return;
+  }
+  const std::size_t h = n / 2;
+  const bigint b1 = limb_slice(b, h, n);
+  const bigint b2 = limb_slice(b, 0, h);
+  const bigint a3 = limb_slice(a, h, n);
+  const bigint a4 = limb_slice(a, 0, h);
+  bigint q1;
+  bz_div3n2n(limb_slice(a, n, 2 * n), a3, b, b1, b2, h, q1, r);
+  bz_div3n2n(r, a4, b, b1, b2, h, q, r);
+  q1.val_shl_limbs(h);
+  q1.val_plus(q);
+  q = std::move(q1);
+}
+
+// Divides a12 B^n + a3 by b = b1 B^n + b2, for the 3n/2n limb step of
+// Burnikel-Ziegler. a12 and r may alias.
+inline void bigint::bz_div3n2n(const bigint &a12, const bigint &a3,
+                               const bigint &b, const bigint &b1,
+                               const bigint &b2, const std::size_t n,
+                               bigint &q, bigint &r) noexcept {
+  if (limb_slice(a12, n, a12.val.size()) == b1) {
+    // the quotient estimate would overflow n limbs, so it is B^n - 1
+    q.val.assign(n, WORD_MAX);
+    q.sign = false;
+    bigint t = b1;
+    t.val_shl_limbs(n);
+    r = a12 - t + b1;
+  } else {
+    bz_div2n1n(a12, b1, n, q, r);
+  }
+  r.val_shl_limbs(n);
+  r += a3;
+  r -= q * b2;
+  while (r.sign) {
+    q -= 1;
+    r += b;
+  }
+}
+
+inline bool bigint::val_less(const bigint &b) const noexcept {
+  if (val.size() != b.val.size())
+    return val.size() < b.val.size();
+  return bigint_detail::cmp_n(val.data(), b.val.data(), val.size()) < 0;
+}
+
+inline bool bigint::val_more(const bigint &b) const noexcept {
+  if (val.size() != b.val.size())
+    return val.size() > b.val.size();
+  return bigint_detail::cmp_n(val.data(), b.val.data(), val.size()) > 0;
 }
 
 inline bool bigint::is_zero() const noexcept {
   return val.size() == 1 && !val.at(0);
 }
+
+inline void bigint::trim() noexcept {
+  while (val.size() > 1 && !val.back()) {
+    val.pop_back();
+  }
+}
@@ -153,6 +153,32 @@ void test_subtractions() {
   test(bigint(12345) - bigint(54321) == bigint(-41976), "[bigint] 12345 - 54321");
 }
 
+// Division tests
+void test_divisions() {
+  try {
+    bigint q = bigint(1) / bigint(0);
+    test(false, "[bigint] division by zero should throw");
+  } catch (const std::domain_error &) {
+    test(true, "[bigint] division by zero should throw");
+  }
+
+  // Truncation towards zero
+  test(bigint(7) / bigint(2) == bigint(3), "[bigint] 7 / 2");
+  test(bigint(-7) / bigint(2) == bigint(-3), "[bigint] -7 / 2");
+  test(bigint(-7) % bigint(2) == bigint(-1), "[bigint] -7 % 2");
+  test(bigint(7) % bigint(-2) == bigint(1), "[bigint] 7 % -2");
+
+  // Large number division
+  test(bigint("2222222212109886746252851749810") /
+               bigint("987654321098765432101234567890") ==
+           bigint(2),
+       "[bigint] large number division");
+  test(bigint("2222222212109886746252851749810") %
+               bigint("987654321098765432101234567890") ==
+           bigint("246913569912355882050382614030"),
+       "[bigint] large number remainder");
+}
+
 // Comparison tests
 void test_equality() {
     test(bigint() == bigint(), "[bigint] equality default constructor");
@@ -200,6 +226,7 @@ int main() {
   test_additions();
   test_multiplications();
   test_subtractions();
+  test_divisions();
 
   test_equality();
   test_inequality();
@@ -0,0 +1,107 @@
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <string>
+
+#include "bigint.hpp"
+
+// Measures where Karatsuba overtakes schoolbook multiplication, where Toom-3
+// overtakes Karatsuba and where the NTT overtakes Toom-3 on this machine. The
+// reported values can be assigned to bigint::thresholds at startup.
+//
+// usage: bigint_tune [max_limbs [max_ntt_limbs]]
+
+namespace {
+std::mt19937_64 rng(42);
+
+// a random positive bigint of roughly n limbs
+bigint random_bigint(std::size_t n) {
+  // 32 * log10(2) ~= 9.63 decimal digits per limb
+  const std::size_t digits = n * 963 / 100 + 1;
+  std::string s(digits, '0');
+  std::uniform_int_distribution<int> dist(0, 9);
+  for (char &ch : s) {
+    ch = static_cast<char>('0' + dist(rng));
+  }
+  s[0] = '1';
+  return bigint(s);
+}
+
+// best of several runs, in nanoseconds per multiplication
+double time_mult(const bigint &a, const bigint &b) {
+  using clock = std::chrono::steady_clock;
+  double best = 1e300;
+  for (int run = 0; run < 5; run++) {
+    std::size_t reps = 0;
+    const auto start = clock::now();
+    auto elapsed = clock::now() - start;
+    do {
+      const bigint c = a * b;
+      reps++;
+      elapsed = clock::now() - start;
+    } while (elapsed < std::chrono::milliseconds(20));
+    const double ns =
+        static_cast<double>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed)
+                .count()) /
+        static_cast<double>(reps);
+    best = std::min(best, ns);
+  }
+  return best;
+}
+
+// Smallest size in [lo, hi] at which one top-level step of the faster
+// algorithm beats the slower one, with `set` switching between the two.
+template <typename Set>
+std::size_t crossover(std::size_t lo, std::size_t hi, Set set,
+                      const char *slow, const char *fast) {
+  std::cout << "limbs " << slow << "(ns) " << fast << "(ns)\n";
+  for (std::size_t n = lo; n <= hi; n += std::max<std::size_t>(1, n / 8)) {
+    const bigint a = random_bigint(n);
+    const bigint b = random_bigint(n);
+    set(hi + 1);
+    const double t_slow = time_mult(a, b);
+    set(n);
+    const double t_fast = time_mult(a, b);
+    std::cout << n << " " << t_slow << " " << t_fast << "\n";
+    if (t_fast < t_slow) {
+      return n;
+    }
+  }
+  return hi;
+}
+} // namespace
+
+int main(int argc, char **argv) {
+  const std::size_t max_limbs =
+      argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 1024;
+  const std::size_t max_ntt_limbs =
+      argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 16384;
+  const auto saved = bigint::thresholds;
+
+  bigint::thresholds.ntt = max_ntt_limbs + 1;
+  bigint::thresholds.toom3 = max_limbs + 1;
+  const std::size_t karatsuba = crossover(
+      4, max_limbs, [](std::size_t t) { bigint::thresholds.karatsuba = t; },
+      "schoolbook", "karatsuba");
+  bigint::thresholds.karatsuba = karatsuba;
+
+  const std::size_t toom3 = crossover(
+      std::max<std::size_t>(karatsuba, 8), max_limbs,
+      [](std::size_t t) { bigint::thresholds.toom3 = t; }, "karatsuba",
+      "toom3");
+  bigint::thresholds.toom3 = toom3;
+
+  const std::size_t ntt = crossover(
+      toom3, max_ntt_limbs, [](std::size_t t) { bigint::thresholds.ntt = t; },
+      "toom3", "ntt");
+
+  std::cout << "\ndefault: bigint::thresholds = {" << saved.karatsuba << ", "
+            << saved.toom3 << ", " << saved.ntt << "}\n";
+  std::cout << "tuned:   bigint::thresholds = {" << karatsuba << ", " << toom3
+            << ", " << ntt << "}\n";
+  return 0;
+}